@@ -0,0 +1,99 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <Arduino.h>
+#include "EventBus.h"
+
+// Per-puzzle play statistics that survive power cycles. Each game keeps
+// counts of plays that ended in completion or time-up, plus log2
+// histograms of completion time, failed attempts and button presses. The
+// totals live in RAM and are merged into a reserved flash page in the
+// first idle frame after a session ends (never while a game runs: the page
+// erase stalls the CPU); 'a' on the console dumps them over telemetry.
+
+static const uint8_t ANALYTICS_GAMES = 4;
+
+// Bucket 0 counts zeros, bucket b counts [2^(b-1), 2^b), the last bucket
+// everything larger. Counts saturate.
+static const uint8_t ANALYTICS_BUCKETS = 12;
+
+struct LogHistogram
+{
+    uint16_t buckets[ANALYTICS_BUCKETS];
+
+    void add(uint32_t value)
+    {
+        uint8_t bucket = value ? 32 - __builtin_clz(value) : 0;
+        if (bucket >= ANALYTICS_BUCKETS)
+            bucket = ANALYTICS_BUCKETS - 1;
+        if (buckets[bucket] != UINT16_MAX)
+            buckets[bucket]++;
+    }
+
+    // Smallest value counted by bucket b.
+    static uint32_t lowerBound(uint8_t bucket) { return bucket == 0 ? 0 : 1UL << (bucket - 1); }
+};
+
+enum AnalyticsHistogram : uint8_t
+{
+    ANALYTICS_TIME_SEC, // Completion time
+    ANALYTICS_ATTEMPTS, // Failed attempts before completion or time-up
+    ANALYTICS_PRESSES,  // Button presses in the game
+    ANALYTICS_HISTOGRAM_COUNT
+};
+
+struct GameAnalytics
+{
+    uint16_t completions;
+    uint16_t timeUps;
+    LogHistogram histograms[ANALYTICS_HISTOGRAM_COUNT];
+};
+
+// Everything persisted to flash.
+struct AnalyticsData
+{
+    uint16_t sessions; // Sessions that reached game won or time up
+    uint16_t sessionsWon;
+    GameAnalytics games[ANALYTICS_GAMES];
+};
+
+class Analytics {
+public:
+    Analytics();
+    // Load the saved totals and listen for game scores.
+    void begin();
+
+    // A game (1-based id) counted a failed attempt: Game2 wrong tune,
+    // Game3 reset, Game4 wrong answer.
+    void recordAttempt(uint8_t gameId);
+    void recordCompletion(uint8_t gameId, uint32_t timeMs, uint16_t presses);
+    void recordTimeUp(uint8_t gameId, uint16_t presses);
+    // Session over: count it and merge into flash on the next idle update().
+    void recordSessionEnd(bool won);
+
+    // Merge new totals when idle (no game running), then continue a
+    // requested dump.
+    void update(bool idle);
+    void requestDump() { dumpCursor = 0; }
+    // Forget every statistic, in RAM and flash.
+    void clear();
+
+    const AnalyticsData &data() const { return totals; }
+    // Merges into flash so far (the newest copy's sequence number).
+    uint32_t merges() const { return sequence; }
+
+private:
+    static void onGameScored(const Event &event, void *context);
+    void merge();
+    void dumpGame(uint8_t game) const;
+
+    AnalyticsData totals;
+    uint8_t pendingAttempts[ANALYTICS_GAMES];
+    uint32_t sequence;      // Of the newest flash copy
+    bool dirty;
+    uint8_t dumpCursor;
+};
+
+extern Analytics analytics;
+
+#endif
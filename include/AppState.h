@@ -0,0 +1,22 @@
+#ifndef APPSTATE_H
+#define APPSTATE_H
+
+#include <Arduino.h>
+
+// Application state definitions
+enum AppState
+{
+  STATE_INTRO,
+  STATE_GAME,
+  STATE_LOADING,
+  STATE_TIME_UP,
+  STATE_GAME_WON,
+  STATE_COUNT
+};
+
+// Defined in main.cpp.
+extern AppState currentState;
+// Index into PlayOrder of the game being played (or loaded)
+extern uint8_t currentGame;
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef BOOTPROFILER_H
+#define BOOTPROFILER_H
+
+#include <Arduino.h>
+
+enum BootPhase : uint8_t
+{
+    BOOT_SETUP,        // setup() entered
+    BOOT_LCD_POWER_UP, // I2C started, LCD power-up wait running
+    BOOT_OUTPUTS,      // RGB LED, buzzer and button ready
+    BOOT_KEYLED,       // TM1638 ready
+    BOOT_LCD_READY,    // LCD controller initialised
+    BOOT_SESSION,      // Session clock started or resumed
+    BOOT_FIRST_FRAME,  // First loop() frame drawn
+    BOOT_PHASE_COUNT
+};
+
+// Boot-to-first-frame budget; the boot report flags anything slower.
+static const uint32_t BOOT_FIRST_FRAME_BUDGET_US = 100000;
+
+// Timestamps (micros() since reset) for each boot phase.
+class BootProfiler {
+public:
+    BootProfiler();
+    void mark(BootPhase phase);
+    uint32_t at(BootPhase phase) const { return stamps[phase]; }
+    bool finished() const { return stamps[BOOT_FIRST_FRAME] != 0; }
+    // Print each phase and the total over serial.
+    void report() const;
+
+private:
+    uint32_t stamps[BOOT_PHASE_COUNT];
+};
+
+extern BootProfiler bootProfiler;
+
+#endif
@@ -2,20 +2,33 @@
 #define BUTTON_H
 
 #include <Arduino.h>
+#include "EventBus.h"
 
+// Push button on an interrupt pin. Raw edges are captured by the pin
+// interrupt and queued on the event bus with their timestamp, so presses
+// are not lost while the loop is busy. update() checks the pin against the
+// last queued level in case the queue overflowed. Debounced presses are
+// published as EVENT_BUTTON_PRESSED.
 class Button {
 public:
     Button(uint8_t pin, unsigned long debounceDelay = 50);
     void begin();
     void update();
+    // True if a press was published by the last update().
     bool isPressed();
     
 private:
+    static void handleInterrupt();
+    static void handleEdge(const Event &event, void *context);
+    void processEdge(int rawState, unsigned long timestamp);
+    void commit(int rawState, unsigned long timestamp);
+
     uint8_t pin;
     unsigned long debounceDelay;
     int stableState;
     int lastRawState;
     unsigned long lastDebounceTime;
+    uint8_t pendingPresses;
     bool fallingEdgeDetected;
 };
 
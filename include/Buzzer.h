@@ -7,14 +7,16 @@ class Buzzer {
 public:
     Buzzer(uint8_t buzzerPin);
     void begin();
-    void playTone(int frequency, int duration);
-    void playErrorTone();
-    void playSuccessMelody();
-    void playGameOverMelody();
-    void playWinningMelody();
+    // Queue a tone for the audio engine instead of blocking on it.
+    void queueTone(int frequency, int duration);
+    // Audio engine: start the next queued tone once the current one ends.
+    void update();
+    // True while a tone started by update() is still sounding.
+    bool busy() const { return (long)(millis() - toneEndTime) < 0; }
 
 private:
     uint8_t buzzerPin;
+    unsigned long toneEndTime;
 };
 
 #endif
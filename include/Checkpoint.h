@@ -0,0 +1,93 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <Arduino.h>
+
+static const uint8_t CHECKPOINT_VERSION = 2;
+static const uint8_t CHECKPOINT_GAME_FIELDS = 16;
+static const uint8_t CHECKPOINT_MAX_GAMES = 4;
+
+// Compact snapshot of an in-progress session. It fits in the 16 RTC backup
+// registers, which survive a watchdog or software reset.
+struct SessionCheckpoint
+{
+    uint8_t version;
+    uint8_t appState;
+    uint8_t currentGame;
+    uint8_t reserved;
+    uint32_t runningMs;                         // Session time without penalties
+    int16_t adjustmentSec[CHECKPOINT_MAX_GAMES]; // Net penalty per game id - 1; penalties are whole seconds
+    uint16_t totalPresses;
+    uint16_t gamePresses;
+    int32_t scores[CHECKPOINT_MAX_GAMES];
+    uint8_t gameFields[CHECKPOINT_GAME_FIELDS]; // Written by the current game
+    uint32_t seedLow, seedHigh;                 // Session PRNG seed
+    uint32_t checksum;                          // CRC-32 of everything above
+};
+
+static_assert(sizeof(SessionCheckpoint) <= 64, "Checkpoint does not fit in the backup registers");
+static_assert(sizeof(SessionCheckpoint) % 4 == 0, "Checkpoint must be a whole number of backup registers");
+
+// Little-endian packing of a game's key fields into the checkpoint.
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(uint8_t *fields) : fields(fields), pos(0) {}
+    void u8(uint8_t value) { put(value, 1); }
+    void u16(uint16_t value) { put(value, 2); }
+    void u32(uint32_t value) { put(value, 4); }
+
+private:
+    void put(uint32_t value, uint8_t size)
+    {
+        for (uint8_t i = 0; i < size && pos < CHECKPOINT_GAME_FIELDS; i++)
+            fields[pos++] = (value >> (8 * i)) & 0xFF;
+    }
+
+    uint8_t *fields;
+    uint8_t pos;
+};
+
+class CheckpointReader {
+public:
+    explicit CheckpointReader(const uint8_t *fields) : fields(fields), pos(0) {}
+    uint8_t u8() { return get(1); }
+    uint16_t u16() { return get(2); }
+    uint32_t u32() { return get(4); }
+
+private:
+    uint32_t get(uint8_t size)
+    {
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < size && pos < CHECKPOINT_GAME_FIELDS; i++)
+            value |= (uint32_t)fields[pos++] << (8 * i);
+        return value;
+    }
+
+    const uint8_t *fields;
+    uint8_t pos;
+};
+
+// Stores the checkpoint in the backup registers (a RAM copy off-target).
+class CheckpointStore {
+public:
+    CheckpointStore() : resumable(false) {}
+    void begin();
+    bool load(SessionCheckpoint &checkpoint);
+    // Fills in version and checksum, then writes.
+    void save(SessionCheckpoint &checkpoint);
+    void clear();
+    // True when the last reset came from the watchdog, software or power
+    // loss rather than a press of the reset button.
+    bool resetAllowsResume() const { return resumable; }
+
+private:
+    bool resumable;
+};
+
+extern CheckpointStore checkpointStore;
+
+// Ask the main loop to write a checkpoint at the end of this frame.
+void requestCheckpoint();
+bool takeCheckpointRequest();
+
+#endif
@@ -0,0 +1,77 @@
+// Generated by tools/content_compiler.py from content/; do not edit.
+#ifndef CONTENT_H
+#define CONTENT_H
+
+#include <Arduino.h>
+
+// Puzzle content from content/pack.json (see tools/content_compiler.py).
+// Strings are offsets into CONTENT_STRINGS; contentText() turns one into
+// a pointer, and is a constant expression for scene cues.
+
+const uint16_t CONTENT_STRINGS_SIZE = 661;
+extern const char CONTENT_STRINGS[CONTENT_STRINGS_SIZE];
+
+constexpr const char *contentText(uint16_t offset)
+{
+    return CONTENT_STRINGS + offset;
+}
+
+struct ContentColor
+{
+    uint8_t r, g, b;
+};
+
+struct ContentQuestion
+{
+    uint16_t question;
+    uint16_t options[5];
+    uint8_t answer; // 0 = A
+};
+
+// Intro screens, two lines each
+constexpr uint16_t CONTENT_INTRO[][2] = {
+    {320, 421},
+    {470, 399},
+    {305, 85}};
+constexpr uint16_t CONTENT_GAME1_INTRO[][2] = {
+    {51, 388},
+    {260, 362},
+    {17, 348},
+    {214, 410},
+    {245, 68}};
+
+// Game2: the melody as key digits, and a tip per note
+constexpr uint16_t CONTENT_GAME2_MELODY = 452;
+constexpr uint16_t CONTENT_GAME2_TIPS[] = {0, 275, 230, 182, 150, 376, 334, 34};
+
+// Game3: target colours, level n is entries [START[n - 1], START[n])
+constexpr uint8_t CONTENT_PALETTE_LEVELS = 3;
+constexpr uint8_t CONTENT_PALETTE_START[] = {0, 5, 10, 15};
+constexpr ContentColor CONTENT_PALETTE[] = {
+    {160, 0, 0},
+    {0, 192, 0},
+    {0, 0, 224},
+    {64, 0, 0},
+    {0, 128, 0},
+    {64, 192, 0},
+    {128, 160, 0},
+    {224, 0, 192},
+    {0, 32, 192},
+    {160, 0, 224},
+    {32, 192, 96},
+    {64, 128, 32},
+    {32, 128, 32},
+    {96, 96, 32},
+    {160, 192, 32}};
+
+// Game4: questions and their five options
+constexpr uint8_t CONTENT_QUESTION_COUNT = 6;
+constexpr ContentQuestion CONTENT_QUESTIONS[] = {
+    {118, {630, 556, 584, 656, 577}, 0},
+    {134, {624, 651, 497, 598, 505}, 2},
+    {198, {618, 521, 528, 535, 612}, 1},
+    {102, {641, 591, 605, 646, 479}, 1},
+    {290, {461, 570, 549, 488, 513}, 4},
+    {166, {542, 636, 442, 563, 432}, 3}};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <Arduino.h>
+
+// CRC-32 (IEEE 802.3 polynomial, reflected, as used by zlib).
+uint32_t crc32(const void *data, size_t length, uint32_t crc = 0);
+
+// CRC-32/MPEG-2 (polynomial 0x04C11DB7, not reflected, no final XOR) over
+// whole words, most significant bit first: the STM32 CRC unit at its reset
+// settings computes it on target, software elsewhere gives the same value.
+uint32_t crc32Words(const uint32_t *words, size_t count);
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <Arduino.h>
+#include "SpscQueue.h"
+
+enum EventType : uint8_t
+{
+    EVENT_BUTTON_EDGE,    // Raw button level change, from the pin interrupt
+    EVENT_BUTTON_PRESSED, // Debounced button press
+    EVENT_KEYS_CHANGED,   // TM1638 key mask changed
+    EVENT_GAME_SCORED,    // A game finished and computed its score
+    EVENT_TONE,           // Tone request for the buzzer
+    EVENT_COLOR,          // Colour request for the RGB LED
+    EVENT_TYPE_COUNT
+};
+
+#define EVENT_BIT(type) (1UL << (type))
+
+// Fixed-size event record. The payload is copied by value.
+struct Event
+{
+    EventType type;
+    uint32_t timestamp; // millis() at capture
+    union
+    {
+        struct
+        {
+            uint8_t level;
+        } button;
+        struct
+        {
+            uint8_t mask;
+        } keys;
+        struct
+        {
+            uint8_t gameId;
+            uint16_t presses;
+            uint32_t timeTaken;
+            int32_t points;
+        } score;
+        struct
+        {
+            uint16_t frequency;
+            uint16_t duration;
+        } tone;
+        struct
+        {
+            uint8_t r, g, b;
+        } color;
+    };
+};
+
+// Builds an event of the given type stamped with the current time.
+Event makeEvent(EventType type);
+
+typedef void (*EventHandler)(const Event &event, void *context);
+
+// Typed event bus. Interrupt handlers feed the input queue, which the main
+// loop drains once per frame; main-loop events are delivered immediately.
+// Outgoing audio and LED requests go through their own queues to the
+// buzzer and LED engines.
+class EventBus {
+public:
+    static const uint8_t MAX_SUBSCRIBERS = 8;
+    static const uint8_t INPUT_QUEUE_SIZE = 16;
+    static const uint8_t OUTPUT_QUEUE_SIZE = 8;
+
+    EventBus();
+
+    // Register handler for every event type set in mask (see EVENT_BIT).
+    bool subscribe(uint32_t mask, EventHandler handler, void *context);
+    // Remove every subscription registered with context.
+    void unsubscribe(void *context);
+    bool hasSubscriber(EventType type) const;
+
+    // Interrupt side: queue an event for the next dispatch().
+    bool publishFromIsr(const Event &event);
+    // Main loop side: deliver an event to its subscribers right away.
+    void publish(const Event &event);
+    // Deliver every queued interrupt event. Called once per frame.
+    void dispatch();
+
+    // Main loop to output engines.
+    bool queueAudio(const Event &event);
+    bool nextAudio(Event &event);
+    bool queueLed(const Event &event);
+    bool nextLed(Event &event);
+
+    uint32_t inputOverflows() const;
+    uint32_t audioOverflows() const;
+    uint32_t ledOverflows() const;
+    uint32_t subscriberOverflows() const;
+
+private:
+    struct Subscriber
+    {
+        uint32_t mask;
+        EventHandler handler;
+        void *context;
+    };
+
+    Subscriber subscribers[MAX_SUBSCRIBERS];
+    uint32_t subscriberDrops;
+    SpscQueue<Event, INPUT_QUEUE_SIZE> inputQueue;
+    SpscQueue<Event, OUTPUT_QUEUE_SIZE> audioQueue;
+    SpscQueue<Event, OUTPUT_QUEUE_SIZE> ledQueue;
+};
+
+extern EventBus eventBus;
+
+#endif
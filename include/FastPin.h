@@ -0,0 +1,156 @@
+#ifndef FASTPIN_H
+#define FASTPIN_H
+
+#include <Arduino.h>
+
+// Compile-time GPIO. A Pin<Port, N> type names one pin of the MCU; its
+// reads and writes compile to a single IDR/BSRR/BRR access instead of the
+// runtime pin-map lookup behind digitalRead()/digitalWrite(). Mode changes
+// are rare and still go through pinMode().
+//
+// Off target (no STM32 core) the same calls fall back to the Arduino API.
+
+enum PinPort : uint8_t
+{
+    PORT_A,
+    PORT_B,
+    PORT_C,
+    PORT_D,
+    PORT_F = 5
+};
+
+template <PinPort Port, uint8_t N>
+struct Pin
+{
+    static_assert(N < 16, "A GPIO port has 16 pins");
+
+    // Same encoding as the core's PinName (PA_10 == 0x0A, PB_3 == 0x13).
+    static constexpr uint8_t id = (uint8_t)((Port << 4) | N);
+    static constexpr uint16_t mask = (uint16_t)(1u << N);
+
+    static uint32_t arduinoPin() { return pinNametoDigitalPin((PinName)id); }
+    static void mode(uint32_t mode) { pinMode(arduinoPin(), mode); }
+    static void output() { mode(OUTPUT); }
+    static void input() { mode(INPUT); }
+    static void inputPullup() { mode(INPUT_PULLUP); }
+
+#if defined(ARDUINO_ARCH_STM32)
+    static GPIO_TypeDef *gpio()
+    {
+        return (GPIO_TypeDef *)(GPIOA_BASE + (GPIOB_BASE - GPIOA_BASE) * Port);
+    }
+    static void high() { gpio()->BSRR = mask; }
+    static void low() { gpio()->BRR = mask; }
+    static void write(bool level) { gpio()->BSRR = level ? mask : (uint32_t)mask << 16; }
+    static bool read() { return (gpio()->IDR & mask) != 0; }
+    static void toggle() { gpio()->ODR ^= mask; }
+#else
+    static void high() { digitalWrite(arduinoPin(), HIGH); }
+    static void low() { digitalWrite(arduinoPin(), LOW); }
+    static void write(bool level) { digitalWrite(arduinoPin(), level ? HIGH : LOW); }
+    static bool read() { return digitalRead(arduinoPin()) == HIGH; }
+    static void toggle() { write(!read()); }
+#endif
+};
+
+// Timer channel behind a pin's PWM alternate function. Only pins listed
+// here can be used with PwmPin; the entries match the core's default
+// PinMap_TIM choice so analogWrite() and PwmPin drive the same channel.
+template <typename P>
+struct PwmChannel
+{
+    static_assert(sizeof(P) == 0, "Pin has no PWM timer channel");
+};
+
+#define DEFINE_PWM_CHANNEL(port, n, timerNumber, timerChannel, alternateFunction) \
+    template <>                                                                \
+    struct PwmChannel<Pin<port, n>>                                            \
+    {                                                                          \
+        static constexpr uint8_t timer = timerNumber;                          \
+        static constexpr uint8_t channel = timerChannel;                       \
+        static constexpr uint8_t af = alternateFunction;                       \
+        static constexpr uint8_t id = (uint8_t)((timerNumber << 2) | (timerChannel - 1)); \
+    }
+
+// STM32F303RE
+DEFINE_PWM_CHANNEL(PORT_B, 4, 3, 1, 2);  // TIM3_CH1, AF2
+DEFINE_PWM_CHANNEL(PORT_B, 5, 3, 2, 2);  // TIM3_CH2, AF2
+DEFINE_PWM_CHANNEL(PORT_B, 10, 2, 3, 1); // TIM2_CH3, AF1
+DEFINE_PWM_CHANNEL(PORT_A, 6, 3, 1, 2);  // TIM3_CH1, AF2
+DEFINE_PWM_CHANNEL(PORT_A, 7, 3, 2, 2);  // TIM3_CH2, AF2
+DEFINE_PWM_CHANNEL(PORT_C, 7, 3, 2, 2);  // TIM3_CH2, AF2
+DEFINE_PWM_CHANNEL(PORT_C, 8, 3, 3, 2);  // TIM3_CH3, AF2
+DEFINE_PWM_CHANNEL(PORT_C, 9, 3, 4, 2);  // TIM3_CH4, AF2
+DEFINE_PWM_CHANNEL(PORT_B, 11, 2, 4, 1); // TIM2_CH4, AF1
+
+#undef DEFINE_PWM_CHANNEL
+
+// 8-bit PWM output on a pin's timer channel. begin() lets analogWrite()
+// set up the timer and alternate function once; write() then only
+// updates the channel's compare register.
+template <typename P>
+struct PwmPin
+{
+    typedef PwmChannel<P> Channel;
+
+    static void begin()
+    {
+        P::output();
+        analogWrite(P::arduinoPin(), 0);
+    }
+
+#if defined(ARDUINO_ARCH_STM32)
+    static TIM_TypeDef *timer()
+    {
+        return Channel::timer == 2 ? TIM2 : TIM3;
+    }
+    static void write(uint8_t duty)
+    {
+        TIM_TypeDef *tim = timer();
+        // CCR1..CCR4 are consecutive registers.
+        (&tim->CCR1)[Channel::channel - 1] = ((uint32_t)duty * (tim->ARR + 1)) / 255;
+    }
+#else
+    static void write(uint8_t duty) { analogWrite(P::arduinoPin(), duty); }
+#endif
+};
+
+// Compile-time uniqueness check over a list of ids.
+constexpr bool idsUnique(const uint8_t *ids, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        for (uint8_t j = i + 1; j < count; j++)
+        {
+            if (ids[i] == ids[j])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Every pin in the set is distinct: PinSet<A, B, C>::unique.
+template <typename... Pins>
+struct PinSet
+{
+    static constexpr uint8_t ids[sizeof...(Pins)] = {Pins::id...};
+    static constexpr bool unique = idsUnique(ids, sizeof...(Pins));
+};
+
+template <typename... Pins>
+constexpr uint8_t PinSet<Pins...>::ids[sizeof...(Pins)];
+
+// Every PWM pin in the set drives its own timer channel.
+template <typename... Pins>
+struct PwmSet
+{
+    static constexpr uint8_t ids[sizeof...(Pins)] = {PwmChannel<Pins>::id...};
+    static constexpr bool unique = idsUnique(ids, sizeof...(Pins));
+};
+
+template <typename... Pins>
+constexpr uint8_t PwmSet<Pins...>::ids[sizeof...(Pins)];
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef FIXEDSTRING_H
+#define FIXEDSTRING_H
+
+#include <Arduino.h>
+#include <string.h>
+
+// String with a fixed capacity of N characters stored inline, so it lives
+// wherever its owner lives (a game's arena state, a stack frame) and never
+// touches the heap. Appends that do not fit are truncated and reported.
+template <uint8_t N>
+class FixedString {
+public:
+    FixedString() : len(0) { buffer[0] = '\0'; }
+    FixedString(const char *text) : len(0)
+    {
+        buffer[0] = '\0';
+        append(text);
+    }
+
+    static uint8_t capacity() { return N; }
+    uint8_t length() const { return len; }
+    bool empty() const { return len == 0; }
+    bool full() const { return len == N; }
+    const char *c_str() const { return buffer; }
+    char operator[](uint8_t index) const { return buffer[index]; }
+
+    void clear()
+    {
+        len = 0;
+        buffer[0] = '\0';
+    }
+
+    // Returns false if the string is full.
+    bool append(char c)
+    {
+        if (len == N)
+        {
+            return false;
+        }
+        buffer[len++] = c;
+        buffer[len] = '\0';
+        return true;
+    }
+
+    // Returns false if the text had to be truncated.
+    bool append(const char *text)
+    {
+        while (*text)
+        {
+            if (!append(*text++))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool equals(const char *text) const { return strcmp(buffer, text) == 0; }
+    template <uint8_t M>
+    bool equals(const FixedString<M> &other) const { return equals(other.c_str()); }
+    template <typename T>
+    bool operator==(const T &other) const { return equals(other); }
+    template <typename T>
+    bool operator!=(const T &other) const { return !equals(other); }
+
+    // Up to count characters starting at start.
+    FixedString slice(uint8_t start, uint8_t count) const
+    {
+        FixedString result;
+        for (uint8_t i = start; i < len && result.len < count; i++)
+        {
+            result.append(buffer[i]);
+        }
+        return result;
+    }
+
+private:
+    char buffer[N + 1];
+    uint8_t len;
+};
+
+#endif
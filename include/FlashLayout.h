@@ -0,0 +1,56 @@
+#ifndef FLASH_LAYOUT_H
+#define FLASH_LAYOUT_H
+
+#include <Arduino.h>
+
+// What the firmware keeps in flash, at the top of it, from the end down:
+//
+//   analytics       ANALYTICS_PAGES pages taking turns (Analytics.cpp)
+//   score log       SCORE_LOG_PAGES pages in a ring (ScoreLog.cpp)
+//   puzzle config   two slots of CONFIG_SLOT_PAGES pages (PuzzleConfig.cpp)
+//
+// The firmware image has to end below all of it. platformio.ini caps the
+// image at the flash size less FLASH_DATA_SIZE, and setup() checks the
+// linked image against flashDataBase() before anything touches flash.
+
+static const uint16_t FLASH_DATA_PAGE_SIZE = 2048;
+static const uint8_t ANALYTICS_PAGES = 2;
+static const uint8_t SCORE_LOG_PAGES = 8;
+static const uint8_t CONFIG_SLOT_PAGES = 2;
+static const uint32_t FLASH_DATA_SIZE =
+    (uint32_t)(ANALYTICS_PAGES + SCORE_LOG_PAGES + 2 * CONFIG_SLOT_PAGES) * FLASH_DATA_PAGE_SIZE;
+
+#if defined(ARDUINO_ARCH_STM32)
+static_assert(FLASH_DATA_PAGE_SIZE == FLASH_PAGE_SIZE, "Flash data is laid out in flash pages");
+
+inline uint32_t flashEnd()
+{
+    return FLASH_BASE + (uint32_t)(*(const uint16_t *)FLASHSIZE_BASE) * 1024;
+}
+
+inline uint32_t analyticsBase()
+{
+    return flashEnd() - ANALYTICS_PAGES * FLASH_DATA_PAGE_SIZE;
+}
+
+inline uint32_t scoreLogBase()
+{
+    return analyticsBase() - SCORE_LOG_PAGES * FLASH_DATA_PAGE_SIZE;
+}
+
+inline uint32_t configBase()
+{
+    return scoreLogBase() - 2 * CONFIG_SLOT_PAGES * FLASH_DATA_PAGE_SIZE;
+}
+
+// The lowest address the firmware writes to.
+inline uint32_t flashDataBase()
+{
+    return configBase();
+}
+
+// Just past the linked image: the code, then the .data initialisers.
+uint32_t firmwareImageEnd();
+#endif
+
+#endif
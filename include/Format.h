@@ -0,0 +1,59 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <Arduino.h>
+
+// Small replacement for sprintf/snprintf on the display and log paths.
+// A Formatter appends text and numbers into a caller's buffer, always
+// NUL-terminates it and silently truncates at the buffer size, like
+// snprintf. Number and time layouts are constexpr descriptors:
+//
+//   char line[17];
+//   Formatter(line, sizeof(line)).text("Lv:").number(level).text(" R:").number(red, PAD3);
+//   // same as snprintf(line, sizeof(line), "Lv:%d R:%03d", level, red)
+
+// Minimum field width and the fill used to reach it ('0' or ' ').
+struct NumberFormat
+{
+    uint8_t width;
+    char fill;
+};
+
+constexpr NumberFormat zeroPadded(uint8_t width) { return NumberFormat{width, '0'}; }
+constexpr NumberFormat rightAligned(uint8_t width) { return NumberFormat{width, ' '}; }
+
+static constexpr NumberFormat PLAIN = {0, ' '}; // %d
+static constexpr NumberFormat PAD2 = zeroPadded(2); // %02d
+static constexpr NumberFormat PAD3 = zeroPadded(3); // %03d
+
+// Minutes and seconds, both two digits, with an optional separator.
+struct TimeFormat
+{
+    char separator;
+};
+
+static constexpr TimeFormat MM_SS = {':'}; // 09:05
+static constexpr TimeFormat MMSS = {0};    // 0905 (seven-segment display)
+
+class Formatter {
+public:
+    Formatter(char *buffer, size_t size);
+    Formatter &text(const char *value);
+    Formatter &character(char value);
+    Formatter &number(long value, NumberFormat format = PLAIN);
+    // A duration in seconds as minutes and seconds.
+    Formatter &time(uint32_t seconds, TimeFormat format = MM_SS);
+    // Upper-case hex, zero-padded to digits.
+    Formatter &hex(uint32_t value, uint8_t digits = 8);
+    const char *c_str() const { return buffer; }
+    size_t length() const { return used; }
+
+private:
+    void put(char c);
+
+    char *buffer;
+    size_t size;
+    size_t used;
+};
+
+#endif
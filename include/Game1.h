@@ -1,6 +1,58 @@
 #ifndef GAME1_H
 #define GAME1_H
 
-bool updateGame1();
+#include <Arduino.h>
+#include "GameInput.h"
+#include "GameRules.h"
+#include "Timeline.h"
+
+// Number of levels in the game
+const int NUM_LEVELS = GAME1_LEVELS;
+
+enum Game1State
+{
+  GAME1_INIT,
+  GAME1_PLAY,
+  GAME1_COMPLETE,
+  GAME1_TIME_UP
+};
+
+enum WaitState
+{
+  WAIT_FOR_CORRECT_VALUE,
+  CONFIRMING
+};
+
+// Game1 state, kept in the shared game arena while the game runs.
+struct Game1Data
+{
+  GameInput input;
+  Game1State gameState = GAME1_INIT;
+  unsigned long stateStart = 0;
+  int currentStep = 0;
+  int combo[NUM_LEVELS] = {0};
+  int lastPrintedValue = -100;
+  WaitState waitState = WAIT_FOR_CORRECT_VALUE;
+  unsigned long confirmStartTime = 0;
+  unsigned long lastHoverBeepTime = 0;
+  uint32_t game1StartTime = 0;
+  TimelinePlayer scene;
+};
+
+// Vault puzzle: dial in the combo with the potentiometer.
+struct Game1
+{
+  typedef Game1Data Data;
+  // Builds the game's state in the game arena.
+  static void begin();
+  // Runs one frame; returns true when the game has finished.
+  static bool update();
+  // Packs the game's key fields into a session checkpoint.
+  static void save(uint8_t *fields);
+  // Continues from a checkpoint after begin().
+  static void resume(const uint8_t *fields);
+  // Current state of the game's state machine, for profiling.
+  static uint8_t state();
+};
 
 #endif
@@ -1,6 +1,54 @@
 #ifndef GAME2_H
 #define GAME2_H
 
-bool updateGame2();
+#include <Arduino.h>
+#include "GameInput.h"
+#include "Timeline.h"
+#include "FixedString.h"
+
+// Notes in the hidden melody
+const int MELODY_LENGTH = 8;
+
+enum Game2State
+{
+  GAME2_INIT,
+  GAME2_PLAY,
+  GAME2_WRONG,
+  GAME2_COMPLETE,
+  GAME2_TIME_UP
+};
+
+// Game2 state, kept in the shared game arena while the game runs.
+struct Game2Data
+{
+  GameInput input;
+  Game2State gameState = GAME2_INIT;
+  unsigned long stateStart = 0;
+  int attemptCount = 0;
+  // Notes played so far (extra notes past the LCD width are dropped).
+  FixedString<16> userInput;
+  unsigned long lastKeyPressTime = 0;
+  uint8_t lastButtons = 0;
+  uint32_t game2StartTime = 0;
+  TimelinePlayer scene;
+  bool finalMessageDisplayed = false;
+  FixedString<16> lastTip;
+};
+
+// Melody puzzle: play the hidden tune on the keys.
+struct Game2
+{
+  typedef Game2Data Data;
+  // Builds the game's state in the game arena.
+  static void begin();
+  // Runs one frame; returns true when the game has finished.
+  static bool update();
+  // Packs the game's key fields into a session checkpoint.
+  static void save(uint8_t *fields);
+  // Continues from a checkpoint after begin().
+  static void resume(const uint8_t *fields);
+  // Current state of the game's state machine, for profiling.
+  static uint8_t state();
+};
 
 #endif
@@ -1,6 +1,59 @@
 #ifndef GAME3_H
 #define GAME3_H
 
-bool updateGame3();
+#include <Arduino.h>
+#include "GameInput.h"
+#include "Timeline.h"
+
+enum Game3State
+{
+    GAME3_INIT,
+    GAME3_SHOW_COLOR,
+    GAME3_USER_GUESS,
+    GAME3_VALIDATE,
+    GAME3_SUCCESS,
+    GAME3_LEVEL_UP,
+    GAME3_FAIL
+};
+
+// Game3 state, kept in the shared game arena while the game runs.
+struct Game3Data
+{
+    GameInput input;
+    uint32_t game3StartTime = 0;
+    int currentLevel = 1;
+    Game3State gameState = GAME3_INIT;
+    unsigned long stateStart = 0;
+    // Target and guess color components.
+    int targetRed = 0, targetGreen = 0, targetBlue = 0;
+    int guessRed = 0, guessGreen = 0, guessBlue = 0;
+    // Active channel: 0 = Red, 1 = Green, 2 = Blue.
+    int currentChannel = 0;
+    // Last message shown by each state, so the LCD is only redrawn on change.
+    int initMsgIndex = -1;
+    int showMsgIndex = -1;
+    // Level-up, final and failure scenes.
+    TimelinePlayer scene;
+    unsigned long lastDisplayUpdate = 0;
+    char lastLine0[17] = "";
+    char lastLine1[17] = "";
+    bool finalMessageShown = false;
+};
+
+// Colour puzzle: mix the shown colour with the potentiometer.
+struct Game3
+{
+    typedef Game3Data Data;
+    // Builds the game's state in the game arena.
+    static void begin();
+    // Runs one frame; returns true when the game has finished.
+    static bool update();
+    // Packs the game's key fields into a session checkpoint.
+    static void save(uint8_t *fields);
+    // Continues from a checkpoint after begin().
+    static void resume(const uint8_t *fields);
+    // Current state of the game's state machine, for profiling.
+    static uint8_t state();
+};
 
 #endif
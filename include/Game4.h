@@ -1,6 +1,58 @@
 #ifndef GAME4_H
 #define GAME4_H
 
-bool updateGame4();
+#include <Arduino.h>
+#include "GameInput.h"
+#include "Timeline.h"
+
+enum Game4State
+{
+  GAME4_INIT,
+  GAME4_SHOW_QUESTION,
+  GAME4_WAIT_FOR_ANSWER,
+  GAME4_WRONG,
+  GAME4_SUCCESS,
+  GAME4_COMPLETE,
+  GAME4_TIME_UP
+};
+
+// Game4 state, kept in the shared game arena while the game runs.
+struct Game4Data
+{
+  GameInput input;
+  bool welcomePrinted = false;
+  bool finalPrinted = false;
+  Game4State gameState = GAME4_INIT;
+  unsigned long stateStart = 0;
+  int currentQuestion = 0;
+  int selectedOption = 0;
+  uint32_t game4StartTime = 0;
+  int charIndex = 0;
+  unsigned long lastCharTime = 0;
+  char typedQuestion[17] = {0};
+  bool typewriterInit = false;
+  unsigned long lastOptionUpdate = 0;
+  // Track correct answers.
+  int correctCount = 0;
+  bool firstTry = true;
+  // Feedback and completion scenes.
+  TimelinePlayer scene;
+};
+
+// Trivia puzzle: pick the right answer for each question.
+struct Game4
+{
+  typedef Game4Data Data;
+  // Builds the game's state in the game arena.
+  static void begin();
+  // Runs one frame; returns true when the game has finished.
+  static bool update();
+  // Packs the game's key fields into a session checkpoint.
+  static void save(uint8_t *fields);
+  // Continues from a checkpoint after begin().
+  static void resume(const uint8_t *fields);
+  // Current state of the game's state machine, for profiling.
+  static uint8_t state();
+};
 
 #endif
@@ -0,0 +1,83 @@
+#ifndef GAMEARENA_H
+#define GAMEARENA_H
+
+#include <Arduino.h>
+#include <new>
+#include "GameRegistry.h"
+
+// RAM budget for the state of a single game.
+static const size_t GAME_ARENA_BUDGET = 256;
+
+// Size and alignment of the largest type in a list.
+template <typename... Ts>
+struct ArenaLayout;
+
+template <typename T>
+struct ArenaLayout<T>
+{
+    static const size_t size = sizeof(T);
+    static const size_t align = alignof(T);
+};
+
+template <typename T, typename... Ts>
+struct ArenaLayout<T, Ts...>
+{
+    static const size_t size = sizeof(T) > ArenaLayout<Ts...>::size ? sizeof(T) : ArenaLayout<Ts...>::size;
+    static const size_t align = alignof(T) > ArenaLayout<Ts...>::align ? alignof(T) : ArenaLayout<Ts...>::align;
+};
+
+// Layout covering the Data type of every game in a GameList.
+template <typename List>
+struct GameListLayout;
+
+template <typename... Games>
+struct GameListLayout<GameList<Games...> > : ArenaLayout<typename Games::Data...>
+{
+};
+
+typedef GameListLayout<PlayOrder> GameArenaLayout;
+
+static_assert(GameArenaLayout::size <= GAME_ARENA_BUDGET, "Largest game state does not fit in the game arena");
+
+// Shared storage for the active game's state. Only one game runs at a time,
+// so every game builds its state here when it starts.
+class GameArena {
+public:
+    GameArena();
+    ~GameArena();
+
+    // Destroys the current occupant and constructs a fresh T in its place.
+    template <typename T>
+    T &begin()
+    {
+        static_assert(sizeof(T) <= sizeof(storage), "Game state does not fit in the game arena");
+        static_assert(alignof(T) <= GameArenaLayout::align, "Game state is over-aligned for the game arena");
+        reset();
+        T *data = new (storage) T();
+        destroy = &destroyAs<T>;
+        return *data;
+    }
+
+    // Returns the state built by the last begin<T>().
+    template <typename T>
+    T &get()
+    {
+        return *reinterpret_cast<T *>(storage);
+    }
+
+    void reset();
+
+private:
+    template <typename T>
+    static void destroyAs(void *data)
+    {
+        static_cast<T *>(data)->~T();
+    }
+
+    alignas(GameArenaLayout::align) unsigned char storage[GameArenaLayout::size];
+    void (*destroy)(void *);
+};
+
+extern GameArena gameArena;
+
+#endif
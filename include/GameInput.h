@@ -0,0 +1,50 @@
+#ifndef GAMEINPUT_H
+#define GAMEINPUT_H
+
+#include <Arduino.h>
+#include "EventBus.h"
+
+// Input events collected for the active game between frames.
+struct GameInput
+{
+    uint8_t pendingPresses = 0;
+    uint8_t keys = 0;
+
+    void handle(const Event &event)
+    {
+        if (event.type == EVENT_BUTTON_PRESSED)
+        {
+            if (pendingPresses < 255)
+                pendingPresses++;
+        }
+        else if (event.type == EVENT_KEYS_CHANGED)
+        {
+            keys = event.keys.mask;
+        }
+    }
+
+    // Consume one button press, if any arrived since the last frame.
+    bool takePress()
+    {
+        if (pendingPresses == 0)
+            return false;
+        pendingPresses--;
+        return true;
+    }
+};
+
+template <typename Data>
+void handleGameInput(const Event &event, void *context)
+{
+    static_cast<Data *>(context)->input.handle(event);
+}
+
+// Subscribe a game's Data::input to the events in mask. The subscription
+// is dropped when the game arena is reset.
+template <typename Data>
+void subscribeGameInput(Data &data, uint32_t mask)
+{
+    eventBus.subscribe(mask, &handleGameInput<Data>, &data);
+}
+
+#endif
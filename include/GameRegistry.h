@@ -0,0 +1,103 @@
+#ifndef GAMEREGISTRY_H
+#define GAMEREGISTRY_H
+
+#include <Arduino.h>
+#include "Game1.h"
+#include "Game2.h"
+#include "Game3.h"
+#include "Game4.h"
+
+// Compile-time list of games. Each game provides a Data type and static
+// begin()/update()/save()/resume()/state() functions; dispatch is resolved at compile time into a
+// chain of index compares with direct calls, so there is no virtual call
+// or function pointer between the scheduler and the game code.
+template <typename... Games>
+struct GameList
+{
+    static constexpr uint8_t count = sizeof...(Games);
+
+    static void begin(uint8_t index)
+    {
+        beginAt<0, Games...>(index);
+    }
+
+    static bool update(uint8_t index)
+    {
+        return updateAt<0, Games...>(index);
+    }
+
+    static void save(uint8_t index, uint8_t *fields)
+    {
+        saveAt<0, Games...>(index, fields);
+    }
+
+    static void resume(uint8_t index, const uint8_t *fields)
+    {
+        resumeAt<0, Games...>(index, fields);
+    }
+
+    static uint8_t state(uint8_t index)
+    {
+        return stateAt<0, Games...>(index);
+    }
+
+private:
+    template <uint8_t I>
+    static void beginAt(uint8_t) {}
+
+    template <uint8_t I, typename Game, typename... Rest>
+    static void beginAt(uint8_t index)
+    {
+        if (index == I)
+            Game::begin();
+        else
+            beginAt<I + 1, Rest...>(index);
+    }
+
+    template <uint8_t I>
+    static bool updateAt(uint8_t) { return false; }
+
+    template <uint8_t I, typename Game, typename... Rest>
+    static bool updateAt(uint8_t index)
+    {
+        return index == I ? Game::update() : updateAt<I + 1, Rest...>(index);
+    }
+
+    template <uint8_t I>
+    static void saveAt(uint8_t, uint8_t *) {}
+
+    template <uint8_t I, typename Game, typename... Rest>
+    static void saveAt(uint8_t index, uint8_t *fields)
+    {
+        if (index == I)
+            Game::save(fields);
+        else
+            saveAt<I + 1, Rest...>(index, fields);
+    }
+
+    template <uint8_t I>
+    static void resumeAt(uint8_t, const uint8_t *) {}
+
+    template <uint8_t I, typename Game, typename... Rest>
+    static void resumeAt(uint8_t index, const uint8_t *fields)
+    {
+        if (index == I)
+            Game::resume(fields);
+        else
+            resumeAt<I + 1, Rest...>(index, fields);
+    }
+
+    template <uint8_t I>
+    static uint8_t stateAt(uint8_t) { return 0; }
+
+    template <uint8_t I, typename Game, typename... Rest>
+    static uint8_t stateAt(uint8_t index)
+    {
+        return index == I ? Game::state() : stateAt<I + 1, Rest...>(index);
+    }
+};
+
+// Play order of the session. Add or reorder puzzles here.
+typedef GameList<Game1, Game2, Game3, Game4> PlayOrder;
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef GAMERULES_H
+#define GAMERULES_H
+
+#include <Arduino.h>
+
+// Tuning knobs of the session and the four games, shared by the firmware
+// and the host simulator in tools/montecarlo so a sweep there always
+// models the rules the board runs. All times in milliseconds.
+
+// Session
+const uint32_t SESSION_TIME_MS = 600000UL;
+const unsigned long INTRO_MESSAGE_INTERVAL_MS = 2000; // Three intro messages
+const unsigned long LOADING_SCREEN_DURATION_MS = 3000;
+const unsigned long TIME_UP_WARNING_MS = 1000;
+
+// Game1: vault dial
+const int GAME1_LEVELS = 3;
+const int GAME1_DIAL_RANGE = 3600;    // Pot full scale in dial units
+const int GAME1_COMBO_MIN = 5;        // Combo values are multiples of
+const int GAME1_COMBO_MAX = 32;       // GAME1_COMBO_STEP in
+const int GAME1_COMBO_STEP = 100;     // [MIN, MAX) * STEP
+const int THRESHOLD_LEVEL1 = 65;      // Base threshold for level 1
+const int LEVEL2_THRESHOLD_OFFSET = 10;
+const int LEVEL3_THRESHOLD_OFFSET = 20;
+const int CONFIRMATION_THRESHOLD = 75;          // Threshold to cancel confirmation
+const unsigned long CONFIRMATION_DELAY_MS = 80; // Hold time to confirm
+const unsigned long GAME1_INTRO_DURATION = 14000;
+const unsigned long GAME1_COMPLETE_DISPLAY_TIME = 2000;
+
+// How close the dial must be to the combo value at each level (1-based).
+// The firmware passes the puzzle config's values.
+inline int game1Threshold(int level, int threshold = THRESHOLD_LEVEL1, int level2Offset = LEVEL2_THRESHOLD_OFFSET,
+                          int level3Offset = LEVEL3_THRESHOLD_OFFSET)
+{
+    if (level == 2)
+        return threshold - level2Offset;
+    if (level == 3)
+        return threshold - level3Offset;
+    return threshold;
+}
+
+// Game2: melody
+const unsigned long GAME2_INIT_DURATION = 2000;
+const unsigned long GAME2_WRONG_DURATION = 1000;
+const unsigned long GAME2_COMPLETE_DURATION = 2000;
+const unsigned long PENALTY_TIME_INCREMENT = 30000; // Per wrong melody
+static_assert(PENALTY_TIME_INCREMENT % 1000 == 0, "The session checkpoint keeps penalties in whole seconds");
+
+// Game3: colour match
+const unsigned long GAME3_INIT_PHASE1_DURATION = 2000;
+const unsigned long GAME3_INIT_PHASE2_DURATION = 4000;
+const unsigned long GAME3_INIT_PHASE3_DURATION = 6000;
+const unsigned long GAME3_SHOW_COLOR_PHASE1_DURATION = 2000;
+const unsigned long GAME3_SHOW_COLOR_PHASE2_DURATION = 4000;
+const unsigned long GAME3_DEBOUNCE_DELAY = 200;
+const unsigned long GAME3_SUCCESS_DISPLAY_DURATION = 6000;
+const unsigned long GAME3_LEVEL_UP_DURATION = 1000; // After the success melody
+const unsigned long GAME3_FAIL_DURATION = 2000;
+const int GAME3_LEVELS = 3;
+const int GAME3_COLOR_TOLERANCE = 15;
+// The pot picks one of GAME3_POT_MAX_STEP + 1 values, step * multiplier.
+const int GAME3_POT_MAX_STEP = 9;
+const int GAME3_DISCRETE_VALUE_MULTIPLIER = 32;
+
+inline bool game3ChannelMatches(int guess, int target, int tolerance = GAME3_COLOR_TOLERANCE)
+{
+    return abs(guess - target) <= tolerance;
+}
+
+// Game4: trivia
+const int GAME4_QUESTION_COUNT = 6;
+const int GAME4_OPTION_COUNT = 5;
+const unsigned long GAME4_INIT_DURATION = 2000;
+const unsigned long GAME4_FEEDBACK_DURATION = 2000;
+const unsigned long TYPEWRITER_DELAY = 50;
+const unsigned long GAME4_OPTION_UPDATE_INTERVAL = 500;
+const unsigned long WRONG_FEEDBACK_DURATION = 1200;
+
+#endif
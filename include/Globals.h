@@ -8,15 +8,10 @@ extern RGBLed rgb;
 extern Buzzer buzzer;
 extern Button button;
 
-// Use the global timer defined in main.cpp.
-extern uint32_t globalStartTime;
+// Total session time defined in main.cpp; session time itself comes from sessionClock.
 extern const uint32_t TOTAL_TIME;
 
 // Declare the global game press counter.
 extern int currentGamePresses;
-extern int game1FinalScore;
-extern int game2FinalScore;
-extern int game3FinalScore;
-extern int game4FinalScore;
 
 #endif
\ No newline at end of file
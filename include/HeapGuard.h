@@ -0,0 +1,33 @@
+#ifndef HEAPGUARD_H
+#define HEAPGUARD_H
+
+#include <Arduino.h>
+
+// Watches the C heap. The linker routes newlib's _malloc_r/_calloc_r/
+// _realloc_r (behind malloc, new and printf) through HeapGuard.cpp, see
+// build_flags in platformio.ini. After lock() every allocation is counted;
+// building with -DHEAP_GUARD_FORBID turns one into a hard fault instead.
+class HeapGuard {
+public:
+    HeapGuard();
+    // Call at the end of setup(): from here on the heap must stay untouched.
+    void lock() { locked = true; }
+    bool isLocked() const { return locked; }
+    // Allocations since reset, and since lock().
+    uint32_t total() const { return totalCount; }
+    uint32_t afterLock() const { return lockedCount; }
+    // Called by the allocator wrappers.
+    void record(size_t size);
+    // Print the counts over serial.
+    void report() const;
+
+private:
+    volatile bool locked;
+    volatile uint32_t totalCount;
+    volatile uint32_t lockedCount;
+    volatile size_t lastLockedSize;
+};
+
+extern HeapGuard heapGuard;
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef INPUTTRACE_H
+#define INPUTTRACE_H
+
+#include <Arduino.h>
+#include "Random.h"
+
+// Analog inputs the games sample, by trace channel.
+enum InputChannel : uint8_t
+{
+    INPUT_POT,
+    INPUT_CHANNELS = 4
+};
+
+// Record kinds: the low 3 bits of each record's tag byte; the upper 5
+// bits carry a small payload.
+//
+//   FRAME   payload: ms since the previous frame (31 = varint follows)
+//   ANALOG  payload: channel; zigzag varint delta from the channel's last value
+//   KEYS    then the key mask byte
+//   EDGE    payload: button level; zigzag varint of timestamp - frame time
+//   SEED    then the session seed, 8 bytes little-endian
+//   STATE   payload: app state; then game index and game state bytes
+//
+// Analog and key records are written only when the value changed since the
+// channel's last record, in the order the firmware read them.
+enum InputRecordKind : uint8_t
+{
+    INPUT_RECORD_FRAME,
+    INPUT_RECORD_ANALOG,
+    INPUT_RECORD_KEYS,
+    INPUT_RECORD_EDGE,
+    INPUT_RECORD_SEED,
+    INPUT_RECORD_STATE
+};
+
+// Record of every input sample the firmware acts on, and replay of one.
+//
+// Recording appends delta-encoded records to a small buffer that goes out
+// as TM_INPUT_TRACE telemetry chunks. Replay reads a recorded stream
+// instead of the hardware: the host moves its clock to each frame's
+// recorded time, button edges are re-queued as if from the pin interrupt,
+// and every sample read returns the recorded value. State records, written whenever the app or
+// game state changes, are checked on replay to find where it diverges.
+class InputTrace {
+public:
+    static const uint8_t CHUNK_SIZE = 48;
+    static const unsigned long FLUSH_INTERVAL_MS = 500;
+
+    InputTrace();
+    // Stream a trace over telemetry from now on (INPUT_TRACE builds).
+    void startRecording();
+    // Replay data instead of the hardware.
+    void startReplay(const uint8_t *data, size_t length);
+    // Replay: move on to the next recorded frame and get its time, so the
+    // clock can be set before the frame runs. False at the end of the data.
+    bool prepareFrame(uint32_t &frameTimeMs);
+    bool recording() const { return mode == MODE_RECORD; }
+    bool replaying() const { return mode == MODE_REPLAY; }
+
+    // Record the session seed, or replace it with the recorded one.
+    void syncSeed(RandomService &rng);
+    // Start of a frame at the session clock's snapshot, before the input
+    // events are dispatched.
+    void beginFrame(uint32_t now);
+    int analog(InputChannel channel, int raw) { return mode == MODE_OFF ? raw : sampleAnalog(channel, raw); }
+    uint8_t keys(uint8_t raw) { return mode == MODE_OFF ? raw : sampleKeys(raw); }
+    // A button edge delivered to the button.
+    void buttonEdge(uint8_t level, uint32_t timestamp);
+    // End of a frame, with the state it left the app in.
+    void endFrame(uint8_t appState, uint8_t game, uint8_t gameState);
+    // Send what is buffered now.
+    void flush();
+
+    uint32_t frames() const { return frameCount; }
+    uint32_t divergences() const { return divergenceCount; }
+    // First frame that did not replay as recorded, if any.
+    uint32_t firstDivergence() const { return firstDivergentFrame; }
+
+private:
+    enum Mode : uint8_t
+    {
+        MODE_OFF,
+        MODE_RECORD,
+        MODE_REPLAY
+    };
+
+    int sampleAnalog(InputChannel channel, int raw);
+    uint8_t sampleKeys(uint8_t raw);
+
+    // Recording
+    void put(uint8_t kind, uint8_t payload);
+    void putByte(uint8_t byte);
+    void putVarint(uint32_t value);
+
+    // Replay
+    bool peek(uint8_t kind) const;
+    uint8_t take();
+    uint32_t takeVarint();
+    void diverged();
+
+    Mode mode;
+    uint32_t frameTime;
+    int16_t lastAnalog[INPUT_CHANNELS];
+    uint8_t lastKeys;
+    uint8_t lastState[3];
+    uint32_t frameCount;
+    bool framePrepared;
+
+    uint8_t chunk[CHUNK_SIZE];
+    uint8_t chunkLength;
+    uint16_t chunkSequence;
+    uint32_t lastFlush;
+
+    const uint8_t *data;
+    size_t length;
+    size_t position;
+    uint32_t divergenceCount;
+    uint32_t firstDivergentFrame;
+    uint32_t lastDivergentFrame;
+};
+
+extern InputTrace inputTrace;
+
+#endif
@@ -2,19 +2,24 @@
 #define KEYLED_H
 
 #include <Arduino.h>
-#include <TM1638plus.h>
+#include "TM1638.h"
+#include "pins.h"
 
 class KeyLed {
 public:
-    KeyLed(uint8_t stbPin, uint8_t clkPin, uint8_t dioPin);
+    KeyLed();
     void begin();
     uint8_t readButtons();
+    // Scan the keys while anyone listens and publish EVENT_KEYS_CHANGED on change.
+    void update();
     void setLED(uint8_t index, bool state);
-    // Display formatted time (MM.SS) on the left and a three-digit button counter on the right.
-    void displayTime(uint32_t elapsed, uint32_t totalDuration, int attemptCount);
+    // Display the session's remaining time (MM.SS) on the left and a three-digit button counter on the right.
+    void displayTime(int attemptCount);
     void printTimeUsed(unsigned long startTime);
 private:
-    TM1638plus tm;
+    TM1638<StbPin, ClkPin, DioPin> tm;
+    uint8_t lastKeys;
+    uint8_t leds; // As last set, one bit per LED
 };
 
 #endif
@@ -2,11 +2,16 @@
 #define LCD_H
 
 #include <Arduino.h>
-#include <LiquidCrystal_I2C.h>
 
+// 16x2 HD44780 character LCD behind a PCF8574 I2C expander, driven in
+// 4-bit mode. Start-up is split in two so the controller's power-up wait
+// overlaps the rest of the boot.
 class LCD {
 public:
     LCD(uint8_t address, uint8_t columns, uint8_t rows);
+    // Start the I2C bus and the power-up wait; returns immediately.
+    void beginPowerUp();
+    // Initialise the controller, waiting only for what is left of the power-up time.
     void begin();
     void clear();
     void setCursor(uint8_t col, uint8_t row);
@@ -19,7 +24,16 @@ public:
     void updateLCD(const char* line1, const char* line2);
 
 private:
-    LiquidCrystal_I2C lcd;
+    void command(uint8_t value);
+    void send(uint8_t value, uint8_t mode);
+    void write4bits(uint8_t value);
+
+    uint8_t address;
+    uint8_t columns;
+    uint8_t rows;
+    uint8_t backlightVal;
+    unsigned long powerUpStart;
+    bool poweringUp;
 };
 
 #endif
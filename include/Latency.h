@@ -0,0 +1,135 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <Arduino.h>
+#include "Profiler.h"
+
+// Input-to-feedback latency probe. Build with -DLATENCY_PROBE
+// (env:nucleo_f303re_latency on the board, env:native_latency on the
+// host) to enable it; otherwise the LATENCY_* macros expand to nothing.
+//
+// An input (a button press edge in the pin interrupt, a newly pressed key
+// in the key scan) is timestamped when it is captured and matched to the
+// first output transaction after the firmware has delivered it (the
+// debounced press, the key event): an LCD transfer, an LED that changes,
+// a tone that starts or an RGB write. Outputs before delivery cannot be
+// the input's doing, so they are not matched. The latency, from capture,
+// is filed under the app or game state the input arrived in. An input
+// with no output within LATENCY_TIMEOUT_US counts as unanswered; inputs
+// that arrive while one is waiting are folded into it.
+//
+// On the board the probe also raises LatencyPin (D7) at capture and drops
+// it at the matching output, so a logic analyser on D7 and the button or
+// STB line sees the same interval.
+
+enum LatencyInput : uint8_t
+{
+    LATENCY_BUTTON,
+    LATENCY_KEYS
+};
+
+enum LatencyOutput : uint8_t
+{
+    LATENCY_LCD,
+    LATENCY_LED,
+    LATENCY_TONE,
+    LATENCY_RGB,
+    LATENCY_OUTPUT_COUNT
+};
+
+// Latencies are kept per state slot (see Profiler.h).
+static const uint8_t LATENCY_SLOT_COUNT = STATE_SLOT_COUNT;
+
+#if defined(LATENCY_PROBE)
+
+static const uint32_t LATENCY_TIMEOUT_US = 2000000;
+
+// Two buckets per octave: bucket b > 0 counts [2^(7 + b/2), ...) in steps
+// of sqrt(2), so a percentile read off the histogram is within 19% of the
+// true value. Bucket 0 takes anything under 128 us.
+static const uint8_t LATENCY_BUCKETS = 32;
+static const uint8_t LATENCY_FIRST_BUCKET_BITS = 7;
+
+struct LatencyStats
+{
+    uint32_t count;
+    uint32_t max;
+    uint16_t unanswered;
+    uint16_t byOutput[LATENCY_OUTPUT_COUNT];
+    uint16_t buckets[LATENCY_BUCKETS]; // Saturating
+};
+
+class LatencyProbe {
+public:
+    LatencyProbe();
+    void begin();
+    // Frame start: the slot inputs arriving from now on belong to, and
+    // expiry of a waiting input.
+    void beginFrame(uint8_t slot);
+    // Safe from interrupt handlers.
+    void input(LatencyInput kind);
+    // The firmware acts on the waiting input from here on.
+    void delivered()
+    {
+        if (phase == PHASE_CAPTURED)
+            phase = PHASE_DELIVERED;
+    }
+    void output(LatencyOutput kind)
+    {
+        if (phase == PHASE_DELIVERED)
+            matched(kind);
+    }
+    void reset();
+    // Dump every slot over telemetry, one slot per update().
+    void requestDump() { dumpCursor = 0; }
+    void update();
+
+    const LatencyStats &stats(uint8_t slot) const { return slots[slot]; }
+    // Upper edge of the histogram bucket holding the p-th percentile (at
+    // most the slot's max), 0 with no samples.
+    uint32_t percentile(uint8_t slot, uint8_t p) const;
+
+private:
+    enum Phase : uint8_t
+    {
+        PHASE_IDLE,
+        PHASE_CAPTURED,
+        PHASE_DELIVERED
+    };
+
+    void matched(LatencyOutput kind);
+    void dumpSlot(uint8_t slot) const;
+
+    LatencyStats slots[LATENCY_SLOT_COUNT];
+    volatile Phase phase;
+    volatile uint32_t inputUs;
+    volatile uint8_t inputSlot;
+    uint8_t frameSlot;
+    uint8_t dumpCursor;
+};
+
+extern LatencyProbe latency;
+
+#define LATENCY_BEGIN() latency.begin()
+#define LATENCY_FRAME(slot) latency.beginFrame(slot)
+#define LATENCY_INPUT(kind) latency.input(kind)
+#define LATENCY_DELIVERED() latency.delivered()
+#define LATENCY_OUTPUT(kind) latency.output(kind)
+#define LATENCY_UPDATE() latency.update()
+#define LATENCY_DUMP() latency.requestDump()
+#define LATENCY_RESET() latency.reset()
+
+#else
+
+#define LATENCY_BEGIN()
+#define LATENCY_FRAME(slot)
+#define LATENCY_INPUT(kind)
+#define LATENCY_DELIVERED()
+#define LATENCY_OUTPUT(kind)
+#define LATENCY_UPDATE()
+#define LATENCY_DUMP()
+#define LATENCY_RESET()
+
+#endif
+
+#endif
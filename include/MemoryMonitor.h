@@ -0,0 +1,95 @@
+#ifndef MEMORYMONITOR_H
+#define MEMORYMONITOR_H
+
+#include <Arduino.h>
+#include "Profiler.h"
+
+// Stack and heap high-water marks, per state and for the session.
+//
+// begin() (end of setup, once the heap is final) puts an MPU no-access
+// guard region HEAP_HEADROOM above the heap, below the stack, and paints
+// the free stack below the current frame; from then on _sbrk (wrapped, see
+// build_flags) refuses to grow the heap into the guard. Each frame,
+// sample() scans down from the stack pointer for the deepest word that
+// lost its paint, files that depth under the frame's state slot and
+// repaints what it scanned, so every frame is measured on its own. A run
+// of STACK_GAP_WORDS still-painted words ends that scan, so a deeper frame
+// behind a larger untouched buffer is missed there and its paint left
+// alone; report() scans up from the guard for the session peak, which
+// catches it. Heap figures come from the allocator, re-read whenever
+// HeapGuard counts a new allocation.
+//
+// A stack that runs into the guard raises a MemManage fault. The handler
+// moves to a fresh stack, keeps a FaultRecord in CCM SRAM (not cleared by
+// a reset) and resets; the next boot reports it as TM_FAULT.
+//
+// Off target there is no stack to paint and no MPU; the figures read 0.
+struct MemoryStats
+{
+    uint32_t stackSize;    // Guard to top of RAM
+    uint32_t stackPeak;    // Deepest stack seen
+    uint32_t heapUsed;     // In allocated blocks
+    uint32_t heapFree;     // Free blocks and room left to grow
+    uint32_t largestFree;  // Biggest single allocation that would fit
+    uint8_t fragmentation; // Percent of free memory outside the largest block
+};
+
+struct FaultRecord
+{
+    uint32_t magic;
+    uint32_t cfsr;      // Configurable fault status
+    uint32_t hfsr;      // Hard fault status
+    uint32_t address;   // MMFAR/BFAR when valid, else 0
+    uint32_t sp;        // Stack pointer when the fault was taken
+    uint32_t excReturn; // LR on entry
+    uint8_t slot;       // State slot of the faulting frame
+    uint8_t stackOverflow;
+    uint16_t reserved;
+    uint32_t checksum; // CRC-32 of everything above
+};
+
+class MemoryMonitor {
+public:
+    static const uint32_t STACK_PAINT = 0xA5A5A5A5;
+    static const uint32_t STACK_GAP_WORDS = 32;
+    static const uint32_t GUARD_SIZE = 256;
+    // Heap growth room left below the guard.
+    static const uint32_t HEAP_HEADROOM = 1024;
+
+    MemoryMonitor();
+    void begin();
+    // Once per frame at a shallow point, with the frame's state slot.
+    void sample(uint8_t slot);
+    // Session figures over telemetry; requestDump() adds the per-state peaks,
+    // one slot per update() so the dump never floods the telemetry ring.
+    void report();
+    void requestDump() { dumpCursor = 0; }
+    void update();
+    // Report and clear a fault kept from before the last reset.
+    void reportFault();
+
+    const MemoryStats &stats() const { return session; }
+    uint16_t stackPeak(uint8_t slot) const { return stackPeaks[slot]; }
+    uint16_t heapPeak(uint8_t slot) const { return heapPeaks[slot]; }
+
+    // Called by the fault handler.
+    void recordFault(uint32_t sp, uint32_t excReturn);
+
+private:
+    void readHeap();
+    void scanStack();
+    void dumpSlot(uint8_t slot) const;
+
+    MemoryStats session;
+    uint16_t stackPeaks[STATE_SLOT_COUNT];
+    uint16_t heapPeaks[STATE_SLOT_COUNT];
+    uint32_t heapAllocations;
+    uint32_t guardEnd;
+    uint8_t frameSlot;
+    uint8_t dumpCursor;
+    bool painted;
+};
+
+extern MemoryMonitor memoryMonitor;
+
+#endif
@@ -2,16 +2,19 @@
 #define POTENTIOMETER_H
 
 #include <Arduino.h>
+#include "InputTrace.h"
 
 class Potentiometer {
 public:
-    Potentiometer(uint8_t analogPin);
+    // Reads go through the input trace as channel.
+    Potentiometer(uint8_t analogPin, InputChannel channel = INPUT_POT);
     int readValue();
     // Reads the raw value and maps it between the given min and max.
     int readMappedValue(int minVal, int maxVal);
     
 private:
     uint8_t analogPin;
+    InputChannel channel;
 };
 
 #endif
@@ -0,0 +1,153 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "Format.h"
+
+// Frame profiler on the Cortex-M4 DWT cycle counter. Build with
+// -DPROFILING (env:nucleo_f303re_profile) to enable it; otherwise the
+// PROFILE_* macros expand to nothing and none of this is compiled in.
+//
+// Each slot keeps count, min, max, total and a log2 histogram of the
+// cycles spent in one frame phase, app state or game state.
+
+// Loop phases.
+enum ProfileSlot : uint8_t
+{
+    PROFILE_FRAME,         // Everything but the frame delay
+    PROFILE_TIMER_DISPLAY, // updateTimerDisplay()
+    PROFILE_EVENTS,        // eventBus.dispatch()
+    PROFILE_BUTTON,        // button.update()
+    PROFILE_KEYLED,        // keyLed.update()
+    PROFILE_OUTPUTS,       // buzzer and RGB engines
+    PROFILE_CHECKPOINT,    // checkpoint save
+    PROFILE_TELEMETRY,     // telemetry.drain()
+    PROFILE_PHASE_COUNT
+};
+
+static const uint8_t PROFILE_APP_STATES = 5;
+static const uint8_t PROFILE_GAMES = 4;
+static const uint8_t PROFILE_GAME_STATES = 8;
+
+// App state s is slot PROFILE_APP_BASE + s; game g (0-based) in state s is
+// PROFILE_GAME_BASE + g * PROFILE_GAME_STATES + s.
+static const uint8_t PROFILE_APP_BASE = PROFILE_PHASE_COUNT;
+static const uint8_t PROFILE_GAME_BASE = PROFILE_APP_BASE + PROFILE_APP_STATES;
+static const uint8_t PROFILE_SLOT_COUNT = PROFILE_GAME_BASE + PROFILE_GAMES * PROFILE_GAME_STATES;
+
+constexpr uint8_t profileAppSlot(uint8_t state)
+{
+    return PROFILE_APP_BASE + (state < PROFILE_APP_STATES ? state : PROFILE_APP_STATES - 1);
+}
+
+constexpr uint8_t profileGameSlot(uint8_t game, uint8_t state)
+{
+    return PROFILE_GAME_BASE + (game < PROFILE_GAMES ? game : PROFILE_GAMES - 1) * PROFILE_GAME_STATES +
+           (state < PROFILE_GAME_STATES ? state : PROFILE_GAME_STATES - 1);
+}
+
+// The app and game state slots alone, numbered from 0, for per-state
+// statistics kept outside the profiler.
+static const uint8_t STATE_SLOT_COUNT = PROFILE_SLOT_COUNT - PROFILE_APP_BASE;
+
+constexpr uint8_t stateAppSlot(uint8_t state)
+{
+    return profileAppSlot(state) - PROFILE_APP_BASE;
+}
+
+constexpr uint8_t stateGameSlot(uint8_t game, uint8_t state)
+{
+    return profileGameSlot(game, state) - PROFILE_APP_BASE;
+}
+
+// "app state N" or "game G state N", as tools/bench.py reads them.
+inline void stateSlotLabel(Formatter &label, uint8_t slot)
+{
+    if (slot < PROFILE_APP_STATES)
+    {
+        label.text("app state ").number(slot);
+    }
+    else
+    {
+        uint8_t index = slot - PROFILE_APP_STATES;
+        label.text("game ").number(index / PROFILE_GAME_STATES + 1).text(" state ").number(index % PROFILE_GAME_STATES);
+    }
+}
+
+#if defined(PROFILING)
+
+// Bucket b counts samples of [2^(b+7), 2^(b+8)) cycles; bucket 0 also
+// takes anything shorter, the last bucket anything longer.
+static const uint8_t PROFILE_BUCKETS = 24;
+static const uint8_t PROFILE_FIRST_BUCKET_BITS = 8;
+
+struct ProfileStats
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint16_t buckets[PROFILE_BUCKETS]; // Saturating
+};
+
+inline uint32_t profileCycles()
+{
+#if defined(ARDUINO_ARCH_STM32)
+    return DWT->CYCCNT;
+#else
+    return micros();
+#endif
+}
+
+class Profiler {
+public:
+    Profiler();
+    // Start the DWT cycle counter.
+    void begin();
+    void record(uint8_t slot, uint32_t cycles);
+    void reset();
+    // Dump every slot over telemetry, one slot per update() so the dump
+    // never floods the telemetry ring.
+    void requestDump() { dumpCursor = 0; }
+    void update();
+    const ProfileStats &stats(uint8_t slot) const { return slots[slot]; }
+
+private:
+    void dumpSlot(uint8_t slot) const;
+
+    ProfileStats slots[PROFILE_SLOT_COUNT];
+    uint8_t dumpCursor;
+};
+
+extern Profiler profiler;
+
+// Times the enclosing scope into a slot.
+class ProfileScope {
+public:
+    explicit ProfileScope(uint8_t slot) : slot(slot), start(profileCycles()) {}
+    ~ProfileScope() { profiler.record(slot, profileCycles() - start); }
+
+private:
+    uint8_t slot;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(slot) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(slot)
+#define PROFILE_BEGIN() profiler.begin()
+#define PROFILE_UPDATE() profiler.update()
+#define PROFILE_DUMP() profiler.requestDump()
+#define PROFILE_RESET() profiler.reset()
+
+#else
+
+#define PROFILE_SCOPE(slot)
+#define PROFILE_BEGIN()
+#define PROFILE_UPDATE()
+#define PROFILE_DUMP()
+#define PROFILE_RESET()
+
+#endif
+
+#endif
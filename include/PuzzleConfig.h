@@ -0,0 +1,158 @@
+#ifndef PUZZLECONFIG_H
+#define PUZZLECONFIG_H
+
+#include <Arduino.h>
+#include "FlashLayout.h"
+
+// Puzzle parameters loaded at runtime. A config blob holds any of the keys
+// in ConfigKeys.def; a game asks for a key with its compiled value as the
+// fallback, so a blob only needs the keys a cabinet changes.
+//
+// Blob layout, little-endian, every part a multiple of 4 bytes:
+//   ConfigBlobHeader
+//   entries: ConfigEntryHeader, then the value padded to 4 bytes
+//     number  int32
+//     text    the string and its NUL
+//     list    the strings one after another, each with its NUL
+//
+// ConfigView maps a blob where it lies (flash, or a buffer) and checks
+// every length, type and limit once; the values it hands out point into
+// the blob. tools/puzzle_config.py builds blobs from JSON and uploads them.
+//
+// Two flash slots take turns. An upload ('c' on the console) goes to the
+// slot not in use and is checked there; only then is the slot stamped
+// with the next generation, which is what makes it the active one. A
+// reset at any point leaves the old config in force.
+
+enum ConfigKey : uint8_t
+{
+#define CONFIG_NUMBER(key, min, max) key,
+#define CONFIG_NUMBER_STEP(key, min, max, step) key,
+#define CONFIG_TEXT(key, maxLength) key,
+#define CONFIG_LIST(key, maxItems, maxItemLength) key,
+#include "ConfigKeys.def"
+#undef CONFIG_NUMBER
+#undef CONFIG_NUMBER_STEP
+#undef CONFIG_TEXT
+#undef CONFIG_LIST
+    CONFIG_KEY_COUNT
+};
+
+enum ConfigType : uint8_t
+{
+    CONFIG_TYPE_NUMBER = 1,
+    CONFIG_TYPE_TEXT = 2,
+    CONFIG_TYPE_LIST = 3
+};
+
+enum ConfigError : uint8_t
+{
+    CONFIG_OK,
+    CONFIG_BAD_HEADER,   // Magic, version or length
+    CONFIG_BAD_CHECKSUM,
+    CONFIG_BAD_ENTRY,    // Runs past the end, or the wrong type for its key
+    CONFIG_BAD_VALUE     // Out of range, too long, or not terminated
+};
+
+static const uint32_t CONFIG_MAGIC = 0x47464350; // "PCFG"
+static const uint16_t CONFIG_FORMAT_VERSION = 1;
+
+struct ConfigBlobHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entries;
+    uint32_t length; // Whole blob, header included
+    uint32_t crc;    // crc32() of the bytes after the header
+};
+
+struct ConfigEntryHeader
+{
+    uint8_t key;
+    uint8_t type;
+    uint16_t length; // Value bytes, before padding
+};
+
+class ConfigView {
+public:
+    ConfigView() { clear(); }
+    // Check a blob of at most capacity bytes and index its keys. On error
+    // the view is left empty.
+    ConfigError map(const uint8_t *blob, uint32_t capacity);
+    void clear();
+
+    bool mapped() const { return base != nullptr; }
+    uint32_t length() const { return mapped() ? ((const ConfigBlobHeader *)base)->length : 0; }
+    uint8_t keys() const;
+    bool has(ConfigKey key) const { return offsets[key] != 0; }
+
+    int32_t number(ConfigKey key, int32_t fallback) const;
+    const char *text(ConfigKey key, const char *fallback) const;
+    uint8_t items(ConfigKey key) const { return counts[key]; }
+    const char *item(ConfigKey key, uint8_t index, const char *fallback) const;
+
+private:
+    const uint8_t *base;
+    uint16_t offsets[CONFIG_KEY_COUNT]; // Of the value in the blob, 0 when absent
+    uint8_t counts[CONFIG_KEY_COUNT];   // List items
+};
+
+class PuzzleConfig {
+public:
+    static const uint16_t SLOT_SIZE = CONFIG_SLOT_PAGES * FLASH_DATA_PAGE_SIZE;
+    // The uploader waits for an acknowledgement after each chunk, so a
+    // chunk never overruns the UART receive buffer.
+    static const uint8_t CHUNK_SIZE = 48;
+    static const uint32_t UPLOAD_TIMEOUT_MS = 2000;
+
+    PuzzleConfig();
+    // Map the newest valid slot, if any.
+    void begin();
+
+    // 'c' from the console: the next four bytes are the blob length, then
+    // the blob. Not allowed while a game runs: the length is read and the
+    // upload refused.
+    void startUpload(bool allowed);
+    bool uploading() const { return phase != PHASE_IDLE; }
+    void receive(uint8_t byte);
+    // Abandon an upload that has gone quiet.
+    void update();
+
+    int32_t number(ConfigKey key, int32_t fallback) const { return active.number(key, fallback); }
+    const char *text(ConfigKey key, const char *fallback) const { return active.text(key, fallback); }
+    uint8_t items(ConfigKey key) const { return active.items(key); }
+    const char *item(ConfigKey key, uint8_t index, const char *fallback) const
+    {
+        return active.item(key, index, fallback);
+    }
+    // 0 while running on the compiled values.
+    uint32_t generation() const { return activeGeneration; }
+
+private:
+    enum Phase : uint8_t
+    {
+        PHASE_IDLE,
+        PHASE_LENGTH,
+        PHASE_DATA
+    };
+
+    void lengthReceived();
+    void finishUpload();
+    void reject(const char *reason);
+
+    ConfigView active;
+    uint32_t activeGeneration;
+    uint8_t activeSlot;
+
+    Phase phase;
+    bool allowed;
+    uint8_t slot; // Being written
+    uint32_t length;
+    uint32_t received;
+    uint8_t pendingByte; // Low half of the next half-word
+    uint32_t lastByteTime;
+};
+
+extern PuzzleConfig puzzleConfig;
+
+#endif
@@ -2,18 +2,24 @@
 #define RGBLED_H
 
 #include <Arduino.h>
+#include "Random.h"
 
 class RGBLed {
 public:
     RGBLed();
     void begin();
     void setColor(uint8_t r, uint8_t g, uint8_t b);
+    // Queue a colour for the LED engine; applied on the next update().
+    void queueColor(uint8_t r, uint8_t g, uint8_t b);
+    // LED engine: apply the latest queued colour.
+    void update();
     // Cycles through a rainbow of colors for the specified duration (in milliseconds).
     void loadingEffect(unsigned long duration);
     // Optional blink method.
     void blink(uint8_t r, uint8_t g, uint8_t b, int delayTime);
     void loadingAnimation(uint32_t elapsed);
-    void getRandomColor(int type, int &red, int &green, int &blue);
+    // Pick a target colour of the given type from the caller's random stream.
+    void getRandomColor(Xoshiro128 &random, int type, int &red, int &green, int &blue);
 };
 
 #endif
@@ -0,0 +1,67 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <Arduino.h>
+
+// xoshiro128** generator: 128 bits of state, a handful of cycles per
+// draw on a Cortex-M4, no division.
+class Xoshiro128 {
+public:
+    Xoshiro128();
+    void seed(uint64_t seed);
+    // Advance 2^64 draws; used to split one seed into independent streams.
+    void jump();
+
+    uint32_t next()
+    {
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // Uniform in [0, bound) by multiply-shift.
+    uint32_t below(uint32_t bound) { return (uint32_t)(((uint64_t)next() * bound) >> 32); }
+    // Uniform in [low, high), like Arduino's random(low, high).
+    long range(long low, long high) { return high > low ? low + (long)below((uint32_t)(high - low)) : low; }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    uint32_t s[4];
+};
+
+// Stream 0 is for the app; game n draws from stream n so one game's
+// draws never shift another's.
+static const uint8_t RANDOM_STREAMS = 5;
+
+// Session PRNG. The session seed comes from several entropy sources
+// unless it is overridden (build with -DSESSION_SEED=0x... or call
+// seed()), and is logged so any session can be replayed exactly.
+class RandomService {
+public:
+    RandomService();
+    // Seed from SESSION_SEED if defined, otherwise from entropy.
+    void begin();
+    // Use a known seed, e.g. to replay a logged session.
+    void seed(uint64_t sessionSeed);
+    uint64_t sessionSeed() const { return current; }
+    Xoshiro128 &stream(uint8_t id) { return streams[id < RANDOM_STREAMS ? id : 0]; }
+    // Print the session seed over serial.
+    void log() const;
+
+private:
+    static uint64_t gatherEntropy();
+
+    uint64_t current;
+    Xoshiro128 streams[RANDOM_STREAMS];
+};
+
+extern RandomService rng;
+
+#endif
@@ -13,6 +13,8 @@ class Score {
     Score();
     Score(int id, int presses, unsigned long time);
     void calculatePoints(int presses, unsigned long time);
+    // Publish the result as EVENT_GAME_SCORED.
+    void publish() const;
 };
 
 #endif
@@ -0,0 +1,106 @@
+#ifndef SCORELOG_H
+#define SCORELOG_H
+
+#include <Arduino.h>
+#include "FlashLayout.h"
+
+// Results of won sessions, kept in an append-only log in flash. The log
+// is a ring of SCORE_LOG_PAGES pages below the analytics pages; records
+// fill the head page slot by slot, and when it is full the next page
+// (always kept erased) becomes the head. The page after the new head, the
+// oldest, is compacted in idle frames: the leaderboard records still in
+// it are copied to the head, then it is erased. Every page is erased once
+// per trip round the ring, so wear is spread evenly.
+//
+// Records carry a CRC-32 from the hardware CRC unit; a record torn by a
+// reset fails it and is skipped. begin() scans the log once into an
+// in-RAM top-K index, so the leaderboard never reads flash.
+//
+// append() only queues a record. update() does at most one flash
+// operation per call: one half-word program, or (when idle) one page
+// erase, so a result costs the frame no more than one half-word write.
+//
+// Lower totals rank higher: points grow with time and button presses.
+
+static const uint8_t SCORE_LOG_GAMES = 4;
+static const uint8_t SCORE_TOP_K = 5;
+
+struct ScoreRecord
+{
+    uint32_t sequence; // Session number, from 1
+    int32_t total;
+    int32_t scores[SCORE_LOG_GAMES];
+    uint16_t presses;
+    uint16_t timeSec; // Session running time
+    uint32_t crc;     // crc32Words() of everything above
+};
+
+static_assert(sizeof(ScoreRecord) == 32, "Score records pack 64 to a flash page");
+
+struct ScoreEntry
+{
+    uint32_t sequence;
+    int32_t total;
+    uint16_t presses;
+    uint16_t timeSec;
+    uint16_t location; // Page * records per page + slot of the newest copy
+};
+
+class ScoreLog {
+public:
+    static const uint16_t PAGE_SIZE = FLASH_DATA_PAGE_SIZE;
+    static const uint8_t RECORDS_PER_PAGE = PAGE_SIZE / sizeof(ScoreRecord);
+
+    ScoreLog();
+    // Scan the log: rebuild the index, find the head, resume compaction.
+    void begin();
+    // Queue a result; sequence and CRC are filled in. Returns its
+    // sequence number, or 0 while an earlier result is still queued.
+    uint32_t append(ScoreRecord record);
+    // One step of writing or, when idle, compacting.
+    void update(bool idle);
+    // Erase the whole log, blocking. For the console and tests.
+    void clear();
+
+    // Leaderboard, best first.
+    uint8_t count() const { return entries; }
+    const ScoreEntry &entry(uint8_t rank) const { return top[rank]; }
+    // 1-based rank of a session, 0 when it is not on the leaderboard.
+    uint8_t rankOf(uint32_t sequence) const;
+    // Sessions logged since the log was last cleared.
+    uint32_t sessions() const { return lastSequence; }
+    // True while a result is queued or being written.
+    bool busy() const { return writing || queued; }
+    // Dump the leaderboard over telemetry, one entry per update().
+    void requestDump() { dumpCursor = 0; }
+
+private:
+    void insert(const ScoreRecord &record, uint16_t location);
+    uint16_t allocate();
+    void startWrite(const ScoreRecord &record, uint16_t location);
+    void compactStep();
+
+    ScoreEntry top[SCORE_TOP_K];
+    uint8_t entries;
+    uint32_t lastSequence;
+
+    uint8_t headPage;
+    uint8_t headSlot; // Next free slot in the head page
+
+    ScoreRecord queuedRecord;
+    bool queued;
+    ScoreRecord writeRecord;
+    uint16_t writeLocation;
+    uint8_t writeHalfWord; // Next half-word to program
+    bool writing;
+
+    int8_t compactPage; // Page waiting to be compacted and erased, or -1
+    uint8_t compactSlot;
+    bool compactDirty;  // Anything programmed in the page so far
+
+    uint8_t dumpCursor;
+};
+
+extern ScoreLog scoreLog;
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef SESSIONCLOCK_H
+#define SESSIONCLOCK_H
+
+#include <Arduino.h>
+
+// Session time service. A hardware timer (TIM4) advances a 1 ms tick;
+// the main loop snapshots it once per frame so every reader in a frame
+// sees the same time. Penalties and bonuses are kept in a ledger with the
+// game that caused them and take effect from the next frame.
+class SessionClock {
+public:
+    static const uint8_t MAX_GAMES = 8;
+    static const uint8_t LEDGER_SIZE = 16;
+
+    struct Adjustment
+    {
+        uint8_t gameId;
+        int32_t deltaMs;  // > 0 penalty, < 0 bonus
+        uint32_t atTick;
+    };
+
+    SessionClock();
+    // Start the 1 ms hardware tick.
+    void begin();
+    // Start a session of the given length at the current frame.
+    void start(uint32_t durationMs);
+    // Continue a session that had already run for runningMs (without adjustments).
+    void resume(uint32_t durationMs, uint32_t runningMs);
+    // Snapshot the tick and apply pending adjustments. Call once per frame.
+    void beginFrame();
+
+    // Tick at the start of the current frame.
+    uint32_t now() const { return frameTick; }
+    // Current tick, for timestamps taken after a blocking call in the frame.
+    uint32_t live() const;
+    // Milliseconds since t, measured at the frame snapshot.
+    uint32_t since(uint32_t t) const { return frameTick - t; }
+
+    // Session time including penalties and bonuses, at the frame snapshot.
+    uint32_t elapsed() const { return frameElapsed; }
+    uint32_t remaining() const { return frameElapsed < duration ? duration - frameElapsed : 0; }
+    bool expired() const { return frameElapsed >= duration; }
+    uint32_t sessionDuration() const { return duration; }
+    // Session time without penalties and bonuses.
+    uint32_t runningTime() const { return frameTick - startTick; }
+
+    void addPenalty(uint8_t gameId, uint32_t ms);
+    void addBonus(uint8_t gameId, uint32_t ms);
+    // Net adjustment charged to one game, or to the whole session.
+    int32_t adjustmentFor(uint8_t gameId) const;
+    int32_t totalAdjustment() const { return appliedTotal; }
+    uint8_t ledgerCount() const { return ledgerLength; }
+    const Adjustment &ledgerEntry(uint8_t index) const { return ledger[index]; }
+
+    // Wrap-safe deadline helpers.
+    static bool reached(uint32_t now, uint32_t deadline) { return (int32_t)(now - deadline) >= 0; }
+    static uint32_t deadlineAfter(uint32_t now, uint32_t ms) { return now + ms; }
+
+private:
+    static void onTick();
+    void record(uint8_t gameId, int32_t deltaMs);
+
+    static volatile uint32_t ticks;
+
+    uint32_t startTick;
+    uint32_t duration;
+    uint32_t frameTick;
+    uint32_t frameElapsed;
+    int32_t pendingTotal;
+    int32_t appliedTotal;
+    int32_t perGame[MAX_GAMES];
+    Adjustment ledger[LEDGER_SIZE];
+    uint8_t ledgerLength;
+};
+
+extern SessionClock sessionClock;
+
+#endif
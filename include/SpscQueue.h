@@ -0,0 +1,64 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Fixed-capacity single-producer/single-consumer ring buffer. One side
+// (for example an interrupt handler) pushes, the other pops; neither side
+// takes a lock. Items are copied in and out, nothing is allocated.
+template <typename T, uint8_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && Capacity <= 128, "SpscQueue capacity must be 1..128");
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0), overflows(0) {}
+
+    // Producer side. Returns false and counts an overflow when the queue is full.
+    bool push(const T &item)
+    {
+        uint8_t h = head.load(std::memory_order_relaxed);
+        uint8_t t = tail.load(std::memory_order_acquire);
+        if ((uint8_t)(h - t) == Capacity)
+        {
+            overflows.store(overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(T &item)
+    {
+        uint8_t t = tail.load(std::memory_order_relaxed);
+        uint8_t h = head.load(std::memory_order_acquire);
+        if (h == t)
+        {
+            return false;
+        }
+        item = items[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t overflowCount() const
+    {
+        return overflows.load(std::memory_order_relaxed);
+    }
+
+private:
+    T items[Capacity];
+    std::atomic<uint8_t> head;
+    std::atomic<uint8_t> tail;
+    std::atomic<uint32_t> overflows;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef TM1638_H
+#define TM1638_H
+
+#include <Arduino.h>
+
+// Bit-banged driver for the TM1638 LED&KEY board (8 digits, 8 LEDs,
+// 8 keys) on three FastPin types. Data goes out LSB first, set while CLK
+// is low and latched on the rising edge; CLK idles high.
+template <typename Stb, typename Clk, typename Dio>
+class TM1638 {
+public:
+    static const uint8_t CMD_WRITE_AUTO = 0x40;
+    static const uint8_t CMD_WRITE_FIXED = 0x44;
+    static const uint8_t CMD_READ_KEYS = 0x42;
+    static const uint8_t CMD_ADDRESS = 0xC0;
+    static const uint8_t CMD_DISPLAY_ON = 0x88;
+    static const uint8_t DEFAULT_BRIGHTNESS = 0x02;
+    // The chip's clock tops out at 1 MHz.
+    static const uint8_t HALF_PERIOD_US = 1;
+
+    void begin()
+    {
+        Stb::output();
+        Clk::output();
+        Dio::output();
+        Stb::high();
+        Clk::high();
+        command(CMD_DISPLAY_ON | DEFAULT_BRIGHTNESS);
+        clear();
+    }
+
+    // Blank every digit and LED.
+    void clear()
+    {
+        command(CMD_WRITE_AUTO);
+        Stb::low();
+        shiftOut(CMD_ADDRESS);
+        for (uint8_t i = 0; i < 16; i++)
+        {
+            shiftOut(0);
+        }
+        Stb::high();
+    }
+
+    // Digit i is at even addresses, LED i at the odd one after it.
+    void setLED(uint8_t index, bool on)
+    {
+        write(CMD_ADDRESS + 1 + (index << 1), on ? 1 : 0);
+    }
+
+    void setSegments(uint8_t digit, uint8_t segments)
+    {
+        write(CMD_ADDRESS + (digit << 1), segments);
+    }
+
+    // Up to 8 characters, left aligned; see segmentsFor() for the font.
+    void displayText(const char *text)
+    {
+        for (uint8_t digit = 0; digit < 8; digit++)
+        {
+            char c = *text ? *text++ : ' ';
+            setSegments(digit, segmentsFor(c));
+        }
+    }
+
+    // One bit per key, S1 in bit 0.
+    uint8_t readButtons()
+    {
+        uint8_t buttons = 0;
+        Stb::low();
+        shiftOut(CMD_READ_KEYS);
+        Dio::input();
+        delayMicroseconds(HALF_PERIOD_US);
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            buttons |= shiftIn() << i;
+        }
+        Dio::output();
+        Stb::high();
+        return buttons;
+    }
+
+    // Digits, space and minus; anything else is blank.
+    static uint8_t segmentsFor(char c)
+    {
+        static const uint8_t DIGITS[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+        if (c >= '0' && c <= '9')
+        {
+            return DIGITS[c - '0'];
+        }
+        return c == '-' ? 0x40 : 0x00;
+    }
+
+private:
+    void command(uint8_t value)
+    {
+        Stb::low();
+        shiftOut(value);
+        Stb::high();
+    }
+
+    void write(uint8_t address, uint8_t value)
+    {
+        command(CMD_WRITE_FIXED);
+        Stb::low();
+        shiftOut(address);
+        shiftOut(value);
+        Stb::high();
+    }
+
+    void shiftOut(uint8_t value)
+    {
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            Clk::low();
+            Dio::write(value & 0x01);
+            value >>= 1;
+            delayMicroseconds(HALF_PERIOD_US);
+            Clk::high();
+            delayMicroseconds(HALF_PERIOD_US);
+        }
+    }
+
+    uint8_t shiftIn()
+    {
+        uint8_t value = 0;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            Clk::low();
+            delayMicroseconds(HALF_PERIOD_US);
+            Clk::high();
+            if (Dio::read())
+            {
+                value |= 1 << i;
+            }
+            delayMicroseconds(HALF_PERIOD_US);
+        }
+        return value;
+    }
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Ids of the telemetry events; the list and each event's decoded text
+// live in TelemetryEvents.def.
+enum TelemetryEvent : uint8_t
+{
+#define TELEMETRY_EVENT(id, format) id,
+#include "TelemetryEvents.def"
+#undef TELEMETRY_EVENT
+    TM_EVENT_COUNT
+};
+
+static const unsigned long TELEMETRY_BAUD = 921600;
+
+// Raw bytes logged as one field; encoded like a string.
+struct TelemetryBytes
+{
+    const uint8_t *data;
+    uint8_t length;
+};
+
+// One binary record being built: event id, timestamp (ms) and fields.
+// Integers are zigzag varints shifted left by one; strings are their
+// length the same way with the low bit set, then the bytes. Records that
+// outgrow MAX_SIZE are cut at the last whole field.
+class TelemetryRecord {
+public:
+    static const uint8_t MAX_SIZE = 64;
+
+    TelemetryRecord(TelemetryEvent event, uint32_t timestamp);
+    void add(int64_t value);
+    void add(const char *value);
+    void add(const uint8_t *data, size_t count);
+    const uint8_t *data() const { return bytes; }
+    uint8_t size() const { return length; }
+
+private:
+    bool putVarint(uint64_t value);
+
+    uint8_t bytes[MAX_SIZE];
+    uint8_t length;
+};
+
+// Telemetry channel. log() encodes a record, frames it with COBS (0x00
+// ends a frame) and pushes it into a lock-free byte ring; drain() moves
+// what the UART can take right now into its interrupt-driven TX buffer,
+// so neither side ever waits on the wire. Records that do not fit in the
+// ring are dropped and counted, and the count is reported once there is
+// room again. One drain moves at most SERIAL_TX_BUFFER_SIZE - 1 bytes, so
+// platformio.ini raises the core's 64-byte default.
+class Telemetry {
+public:
+    static const uint16_t RING_SIZE = 1024;
+
+    Telemetry();
+    void begin(unsigned long baud = TELEMETRY_BAUD);
+
+    template <typename... Fields>
+    void log(TelemetryEvent event, Fields... fields)
+    {
+        TelemetryRecord record(event, millis());
+        addFields(record, fields...);
+        commit(record);
+    }
+
+    // Call once per frame.
+    void drain();
+    uint32_t dropped() const { return droppedTotal; }
+
+private:
+    static void addFields(TelemetryRecord &) {}
+    template <typename Field, typename... Rest>
+    static void addFields(TelemetryRecord &record, Field field, Rest... rest)
+    {
+        addField(record, field);
+        addFields(record, rest...);
+    }
+    static void addField(TelemetryRecord &record, const char *value) { record.add(value); }
+    static void addField(TelemetryRecord &record, char *value) { record.add(value); }
+    static void addField(TelemetryRecord &record, TelemetryBytes value) { record.add(value.data, value.length); }
+    template <typename Int>
+    static void addField(TelemetryRecord &record, Int value) { record.add((int64_t)value); }
+
+    void commit(const TelemetryRecord &record);
+    uint16_t freeSpace() const;
+
+    uint8_t ring[RING_SIZE];
+    std::atomic<uint16_t> head; // Written by log()
+    std::atomic<uint16_t> tail; // Written by drain()
+    uint32_t droppedTotal;
+    uint32_t droppedUnreported;
+};
+
+extern Telemetry telemetry;
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <Arduino.h>
+
+enum CueType : uint8_t
+{
+    CUE_TEXT,  // Show line1/line2 on the LCD
+    CUE_COLOR, // Set the RGB LED
+    CUE_TONE   // Queue a tone on the buzzer
+};
+
+// Most tracks a TimelinePlayer plays at once.
+static const uint8_t TIMELINE_MAX_TRACKS = 4;
+
+// One keyframe. Unused fields are zero.
+struct Cue
+{
+    uint32_t atMs;
+    const char *line1;
+    const char *line2;
+    CueType type;
+    uint8_t r, g, b;
+    uint16_t frequency;
+    uint16_t duration;
+};
+
+constexpr Cue textCue(uint32_t atMs, const char *line1, const char *line2)
+{
+    return Cue{atMs, line1, line2, CUE_TEXT, 0, 0, 0, 0, 0};
+}
+
+constexpr Cue colorCue(uint32_t atMs, uint8_t r, uint8_t g, uint8_t b)
+{
+    return Cue{atMs, nullptr, nullptr, CUE_COLOR, r, g, b, 0, 0};
+}
+
+constexpr Cue toneCue(uint32_t atMs, uint16_t frequency, uint16_t duration)
+{
+    return Cue{atMs, nullptr, nullptr, CUE_TONE, 0, 0, 0, frequency, duration};
+}
+
+// Cues sorted by time, shifted by offsetMs. Tracks that do not repeat only
+// play on the first pass of a looping timeline.
+struct Track
+{
+    const Cue *cues;
+    uint8_t count;
+    uint32_t offsetMs;
+    bool repeats;
+};
+
+template <size_t N>
+constexpr Track track(const Cue (&cues)[N], uint32_t offsetMs = 0, bool repeats = true)
+{
+    static_assert(N <= UINT8_MAX, "Too many cues in one track");
+    return Track{cues, N, offsetMs, repeats};
+}
+
+struct Timeline
+{
+    const Track *tracks;
+    uint8_t trackCount;
+    uint32_t lengthMs;
+    bool loops;
+};
+
+template <size_t N>
+constexpr Timeline timeline(const Track (&tracks)[N], uint32_t lengthMs, bool loops = false)
+{
+    static_assert(N <= TIMELINE_MAX_TRACKS, "Too many tracks for TimelinePlayer");
+    return Timeline{tracks, N, lengthMs, loops};
+}
+
+// Shared sound tracks (the Buzzer melodies as keyframes).
+extern const Cue SUCCESS_MELODY[8];
+extern const Cue GAME_OVER_MELODY[8];
+extern const Cue WINNING_MELODY[8];
+extern const Cue ERROR_TONE[1];
+static const uint32_t SUCCESS_MELODY_MS = 2300;
+static const uint32_t GAME_OVER_MELODY_MS = 1200;
+static const uint32_t WINNING_MELODY_MS = 1200;
+
+// Plays a timeline from the main loop without blocking.
+class TimelinePlayer {
+public:
+    static const uint8_t MAX_TRACKS = TIMELINE_MAX_TRACKS;
+
+    TimelinePlayer();
+    void play(const Timeline &timeline, uint32_t now);
+    // Fire every cue that is due. Returns true while the timeline is playing.
+    bool update(uint32_t now);
+    // Stop early, for example on input.
+    void interrupt();
+    void stop();
+    bool playing() const { return current != nullptr; }
+    bool wasInterrupted() const { return interrupted; }
+
+private:
+    void fire(const Cue &cue);
+
+    const Timeline *current;
+    uint32_t startTime;
+    uint8_t cursors[MAX_TRACKS];
+    bool firstPass;
+    bool interrupted;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+// Frame tracing. Build with -DTRACING (env:nucleo_f303re_trace) to record
+// begin/end spans and instant events with microsecond timestamps. They go
+// out through the telemetry ring as TM_TRACE records, and
+// tools/trace_export.py turns a capture into Chrome trace-event JSON for
+// chrome://tracing or ui.perfetto.dev. Without TRACING the TRACE_* macros
+// expand to nothing (TRACED_DELAY to a plain delay).
+
+enum TraceName : uint8_t
+{
+#define TRACE_NAME(id, text) id,
+#include "TraceNames.def"
+#undef TRACE_NAME
+    TRACE_NAME_COUNT
+};
+
+#if defined(TRACING)
+
+#include "Telemetry.h"
+
+enum TracePhase : char
+{
+    TRACE_BEGIN = 'B',
+    TRACE_END = 'E',
+    TRACE_INSTANT_EVENT = 'i'
+};
+
+inline void traceEvent(TracePhase phase, uint8_t name, int32_t arg)
+{
+    telemetry.log(TM_TRACE, (char)phase, name, micros(), arg);
+}
+
+// Span over the enclosing scope.
+class TraceSpan {
+public:
+    explicit TraceSpan(uint8_t name, int32_t arg = 0) : name(name) { traceEvent(TRACE_BEGIN, name, arg); }
+    ~TraceSpan() { traceEvent(TRACE_END, name, 0); }
+
+private:
+    uint8_t name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define TRACE_SPAN_ARG(name, arg) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, arg)
+#define TRACE_INSTANT(name, arg) traceEvent(TRACE_INSTANT_EVENT, name, arg)
+#define TRACED_DELAY(ms)                       \
+    do                                         \
+    {                                          \
+        TraceSpan delaySpan(TRACE_DELAY, ms);  \
+        delay(ms);                             \
+    } while (0)
+
+#else
+
+#define TRACE_SPAN(name)
+#define TRACE_SPAN_ARG(name, arg)
+#define TRACE_INSTANT(name, arg)
+#define TRACED_DELAY(ms) delay(ms)
+
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// The subset of the Arduino core the firmware uses, for env:native. Time
+// comes from a virtual clock (see HostArduino.h), so delay() returns at
+// once and a whole session runs in milliseconds of wall time.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 0x2
+#define FALLING 0x3
+#define RISING 0x4
+
+// Nucleo-64 header numbering: D0..D15, then A0..A5.
+#define A0 16
+#define A1 17
+#define A2 18
+#define A3 19
+#define A4 20
+#define A5 21
+#define NUM_DIGITAL_PINS 22
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint32_t PinName;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+int analogRead(uint32_t pin);
+void analogWrite(uint32_t pin, int value);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+uint32_t digitalPinToInterrupt(uint32_t pin);
+void attachInterrupt(uint32_t pin, void (*handler)(), uint32_t mode);
+void detachInterrupt(uint32_t pin);
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+// STM32 core: Arduino pin number behind a port/pin id.
+uint32_t pinNametoDigitalPin(PinName name);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// As in the STM32 core, where platformio.ini sets it.
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 64
+#endif
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    int availableForWrite();
+    size_t write(uint8_t byte) { return write(&byte, 1); }
+    size_t write(const uint8_t *buffer, size_t size);
+    void flush() {}
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,206 @@
+#include "Hd44780Model.h"
+#include <string.h>
+
+// PCF8574 port bits on the backpack
+static const uint8_t PORT_RS = 0x01;
+static const uint8_t PORT_RW = 0x02;
+static const uint8_t PORT_EN = 0x04;
+
+Hd44780Model::Hd44780Model(uint8_t columns, uint8_t rows)
+    : columns(columns), rows(rows), port(0), fourBit(false), haveHighNibble(false), highNibble(0), address(0),
+      addressInCgram(false), entryMode(0x02), displayControl(0), functionSet(0x10), shift(0), busyUntilUs(0),
+      instructionCount(0), dataCount(0), violations(0)
+{
+    // Power-on reset runs a clear.
+    memset(ddramData, ' ', sizeof(ddramData));
+    memset(cgramData, 0, sizeof(cgramData));
+}
+
+void Hd44780Model::attach(uint8_t address)
+{
+    hostI2c.attach(address, this);
+}
+
+void Hd44780Model::receive(const uint8_t *data, size_t length, uint32_t busUs)
+{
+    busCost.bytes += length + 1;
+    busCost.transactions++;
+    busCost.busUs += busUs;
+
+    // Each port byte lands after the address byte and the ones before it.
+    uint64_t startUs = hostClock.micros() - busUs;
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t before = port;
+        port = data[i];
+        bool fell = (before & PORT_EN) && !(port & PORT_EN);
+        if (fell && !(port & PORT_RW))
+        {
+            latch(port >> 4, port & PORT_RS, startUs + busUs * (i + 2) / (length + 1));
+        }
+    }
+}
+
+void Hd44780Model::latch(uint8_t nibble, bool rs, uint64_t atUs)
+{
+    if (!fourBit)
+    {
+        // D0..D3 are not wired; they read as 0.
+        execute(nibble << 4, rs, atUs);
+        return;
+    }
+    if (!haveHighNibble)
+    {
+        highNibble = nibble;
+        haveHighNibble = true;
+        return;
+    }
+    haveHighNibble = false;
+    execute((highNibble << 4) | nibble, rs, atUs);
+}
+
+void Hd44780Model::execute(uint8_t value, bool rs, uint64_t atUs)
+{
+    if (atUs < busyUntilUs)
+    {
+        violations++;
+    }
+    uint32_t duration;
+    if (rs)
+    {
+        writeData(value);
+        dataCount++;
+        duration = DATA_US;
+    }
+    else
+    {
+        instruction(value);
+        instructionCount++;
+        duration = value == 0x01 || (value & 0xFE) == 0x02 ? CLEAR_US : INSTRUCTION_US;
+    }
+    busyUntilUs = atUs + duration;
+}
+
+void Hd44780Model::instruction(uint8_t value)
+{
+    if (value & 0x80)
+    {
+        address = value & 0x7F;
+        addressInCgram = false;
+    }
+    else if (value & 0x40)
+    {
+        address = value & 0x3F;
+        addressInCgram = true;
+    }
+    else if (value & 0x20)
+    {
+        functionSet = value & 0x1C;
+        fourBit = !(value & 0x10);
+        haveHighNibble = false;
+    }
+    else if (value & 0x10)
+    {
+        bool right = value & 0x04;
+        if (value & 0x08)
+        {
+            shift = (int8_t)((shift + (right ? 1 : LINE_LENGTH - 1)) % LINE_LENGTH);
+        }
+        else
+        {
+            uint8_t mode = entryMode;
+            entryMode = right ? 0x02 : 0x00;
+            step();
+            entryMode = mode;
+        }
+    }
+    else if (value & 0x08)
+    {
+        displayControl = value & 0x07;
+    }
+    else if (value & 0x04)
+    {
+        entryMode = value & 0x03;
+    }
+    else if (value & 0x02)
+    {
+        address = 0;
+        addressInCgram = false;
+        shift = 0;
+    }
+    else if (value & 0x01)
+    {
+        memset(ddramData, ' ', sizeof(ddramData));
+        address = 0;
+        addressInCgram = false;
+        shift = 0;
+        entryMode |= 0x02;
+    }
+}
+
+void Hd44780Model::writeData(uint8_t value)
+{
+    if (addressInCgram)
+    {
+        cgramData[address & 0x3F] = value;
+        address = (address + ((entryMode & 0x02) ? 1 : 0x3F)) & 0x3F;
+        return;
+    }
+    if (twoLines())
+    {
+        ddramData[address >= 0x40 ? 1 : 0][(address & 0x3F) % LINE_LENGTH] = value;
+    }
+    else
+    {
+        // One line of 80 characters
+        ddramData[address / LINE_LENGTH % 2][address % LINE_LENGTH] = value;
+    }
+    step();
+    if (entryMode & 0x01)
+    {
+        // Shift the display with the cursor so it stays put.
+        shift = (int8_t)((shift + ((entryMode & 0x02) ? LINE_LENGTH - 1 : 1)) % LINE_LENGTH);
+    }
+}
+
+// Move the DDRAM address counter one place the entry mode's way. In
+// two-line mode the lines are 0x00..0x27 and 0x40..0x67 and the counter
+// runs from the end of one into the other.
+void Hd44780Model::step()
+{
+    bool increment = entryMode & 0x02;
+    if (!twoLines())
+    {
+        address = (uint8_t)((address + (increment ? 1 : 79)) % 80);
+        return;
+    }
+    if (increment)
+    {
+        address = address == 0x27 ? 0x40 : address == 0x67 ? 0x00 : address + 1;
+    }
+    else
+    {
+        address = address == 0x00 ? 0x67 : address == 0x40 ? 0x27 : address - 1;
+    }
+}
+
+uint8_t Hd44780Model::ddram(uint8_t address) const
+{
+    uint8_t row = address >= 0x40 ? 1 : 0;
+    return ddramData[row][(address & 0x3F) % LINE_LENGTH];
+}
+
+std::string Hd44780Model::line(uint8_t row) const
+{
+    std::string text;
+    if (row >= rows)
+    {
+        return text;
+    }
+    for (uint8_t col = 0; col < columns; col++)
+    {
+        uint8_t at = (uint8_t)((col - shift + LINE_LENGTH) % LINE_LENGTH);
+        text += (char)ddramData[row][at];
+    }
+    return text;
+}
@@ -0,0 +1,83 @@
+#ifndef HD44780_MODEL_H
+#define HD44780_MODEL_H
+
+#include "HostArduino.h"
+#include <string>
+
+// HD44780 character LCD behind a PCF8574 I2C backpack, for env:native.
+//
+// Each byte the PCF8574 receives sets its port: P0 RS, P1 RW, P2 EN,
+// P3 backlight, P4..P7 D4..D7. The controller latches D4..D7 on EN's
+// falling edge; it powers up in 8-bit mode, where every latch is a whole
+// instruction, and after function set with DL=0 takes two nibbles per
+// byte, high first. Instructions and data update DDRAM, CGRAM, the
+// address counter and the display/entry flags as in the datasheet.
+//
+// Each instruction keeps the controller busy for its execution time
+// (1.52 ms for clear and home, 37 us otherwise, 41 us for data) at the
+// datasheet's 270 kHz clock; one that arrives earlier would be lost on
+// the real part and is counted in busyViolations(). The driver never
+// reads the busy flag, so this checks that its waits and the bus time
+// between nibbles cover every instruction.
+class Hd44780Model : public I2cDevice {
+public:
+    static const uint8_t ADDRESS = 0x27;
+    static const uint8_t LINE_LENGTH = 40;
+    static const uint32_t CLEAR_US = 1520;
+    static const uint32_t INSTRUCTION_US = 37;
+    static const uint32_t DATA_US = 41;
+
+    explicit Hd44780Model(uint8_t columns = 16, uint8_t rows = 2);
+    // Attach to the host I2C bus at address.
+    void attach(uint8_t address = ADDRESS);
+    void receive(const uint8_t *data, size_t length, uint32_t busUs) override;
+
+    // Visible characters of a row (columns wide, after display shift).
+    std::string line(uint8_t row) const;
+    uint8_t ddram(uint8_t address) const;
+    uint8_t cgram(uint8_t address) const { return cgramData[address & 0x3F]; }
+    uint8_t addressCounter() const { return address; }
+    bool displayOn() const { return displayControl & 0x04; }
+    bool cursorOn() const { return displayControl & 0x02; }
+    bool blinkOn() const { return displayControl & 0x01; }
+    bool backlight() const { return port & 0x08; }
+    bool fourBitMode() const { return fourBit; }
+    bool twoLines() const { return functionSet & 0x08; }
+
+    const BusCost &cost() const { return busCost; }
+    uint64_t instructions() const { return instructionCount; }
+    uint64_t writes() const { return dataCount; }
+    // Instructions and data latched while the previous one was still running.
+    uint64_t busyViolations() const { return violations; }
+
+private:
+    void latch(uint8_t nibble, bool rs, uint64_t atUs);
+    void execute(uint8_t value, bool rs, uint64_t atUs);
+    void instruction(uint8_t value);
+    void writeData(uint8_t value);
+    void step();
+
+    uint8_t columns;
+    uint8_t rows;
+    uint8_t port;
+    bool fourBit;
+    bool haveHighNibble;
+    uint8_t highNibble;
+
+    uint8_t ddramData[2][LINE_LENGTH];
+    uint8_t cgramData[64];
+    uint8_t address;
+    bool addressInCgram;
+    uint8_t entryMode;
+    uint8_t displayControl;
+    uint8_t functionSet;
+    int8_t shift;
+
+    uint64_t busyUntilUs;
+    BusCost busCost;
+    uint64_t instructionCount;
+    uint64_t dataCount;
+    uint64_t violations;
+};
+
+#endif
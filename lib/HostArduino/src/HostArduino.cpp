@@ -0,0 +1,524 @@
+#include "HostArduino.h"
+#include "HeapGuard.h"
+#include <Wire.h>
+
+VirtualClock hostClock;
+HostPins hostPins;
+HostSerial hostSerial;
+HostI2c hostI2c;
+HostBusCounters hostBus;
+HardwareSerial Serial;
+TwoWire Wire;
+
+void setup();
+void loop();
+
+// Time
+
+// Reading the clock costs a microsecond of virtual time, so code that
+// busy-waits on millis() or micros() still gets there.
+unsigned long millis()
+{
+    hostClock.advance(1);
+    return (unsigned long)hostClock.millis();
+}
+
+unsigned long micros()
+{
+    hostClock.advance(1);
+    return (unsigned long)hostClock.micros();
+}
+
+void delay(unsigned long ms)
+{
+    hostClock.advanceMs(ms);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    hostClock.advance(us);
+}
+
+void hostRunFor(uint32_t ms)
+{
+    uint64_t end = hostClock.millis() + ms;
+    while (hostClock.millis() < end)
+    {
+        uint64_t before = hostClock.micros();
+        hostLoop();
+        // A loop() that never waits would spin forever on a virtual clock.
+        if (hostClock.micros() == before)
+        {
+            hostClock.advanceMs(1);
+        }
+    }
+}
+
+void hostLoop()
+{
+    HostFirmwareScope firmware;
+    loop();
+}
+
+// Heap
+
+static int firmwareDepth = 0;
+
+HostFirmwareScope::HostFirmwareScope()
+{
+    firmwareDepth++;
+}
+
+HostFirmwareScope::~HostFirmwareScope()
+{
+    firmwareDepth--;
+}
+
+#if defined(__GLIBC__)
+// Interpose the C allocator (operator new ends up here too) and report the
+// firmware's allocations, like the -Wl,--wrap wrappers in HeapGuard.cpp.
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+
+    void *malloc(size_t size)
+    {
+        if (firmwareDepth > 0)
+            heapGuard.record(size);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        if (firmwareDepth > 0)
+            heapGuard.record(count * size);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        if (firmwareDepth > 0)
+            heapGuard.record(size);
+        return __libc_realloc(ptr, size);
+    }
+}
+#endif
+
+// Pins
+
+// Nucleo-F303RE header: D0..D15 then A0..A5, as port << 4 | pin.
+static const uint8_t HEADER_PINS[NUM_DIGITAL_PINS] = {
+    0x03, 0x02, 0x0A, 0x13, 0x15, 0x14, 0x1A, 0x08, // D0..D7
+    0x09, 0x27, 0x16, 0x07, 0x06, 0x05, 0x19, 0x18, // D8..D15
+    0x00, 0x01, 0x04, 0x10, 0x21, 0x20};            // A0..A5
+
+uint32_t pinNametoDigitalPin(PinName name)
+{
+    for (uint32_t pin = 0; pin < NUM_DIGITAL_PINS; pin++)
+    {
+        if (HEADER_PINS[pin] == name)
+        {
+            return pin;
+        }
+    }
+    return NUM_DIGITAL_PINS; // Not on the header; ignored by HostPins
+}
+
+HostPins::State *HostPins::state(uint32_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? &pins[pin] : nullptr;
+}
+
+const HostPins::State *HostPins::state(uint32_t pin) const
+{
+    return pin < NUM_DIGITAL_PINS ? &pins[pin] : nullptr;
+}
+
+int HostPins::inputLevel(const State &s) const
+{
+    if (s.driven)
+        return s.input;
+    return s.mode == INPUT_PULLUP ? HIGH : LOW;
+}
+
+void HostPins::fireIfEdge(State &s, int before)
+{
+    int after = inputLevel(s);
+    if (s.handler == nullptr || s.mode == OUTPUT || after == before)
+    {
+        return;
+    }
+    if (s.edge == CHANGE || (s.edge == FALLING && after == LOW) || (s.edge == RISING && after == HIGH))
+    {
+        s.handler();
+    }
+}
+
+void HostPins::drive(uint32_t pin, int level)
+{
+    State *s = state(pin);
+    if (s == nullptr)
+        return;
+    int before = inputLevel(*s);
+    s->input = level ? HIGH : LOW;
+    s->driven = true;
+    fireIfEdge(*s, before);
+}
+
+void HostPins::release(uint32_t pin)
+{
+    State *s = state(pin);
+    if (s == nullptr)
+        return;
+    int before = inputLevel(*s);
+    s->driven = false;
+    fireIfEdge(*s, before);
+}
+
+void HostPins::setAnalog(uint32_t pin, int value)
+{
+    State *s = state(pin);
+    if (s != nullptr)
+        s->analog = value;
+}
+
+uint32_t HostPins::mode(uint32_t pin) const
+{
+    const State *s = state(pin);
+    return s ? s->mode : INPUT;
+}
+
+int HostPins::level(uint32_t pin) const
+{
+    const State *s = state(pin);
+    return s ? s->output : LOW;
+}
+
+int HostPins::pwm(uint32_t pin) const
+{
+    const State *s = state(pin);
+    return s ? s->pwm : 0;
+}
+
+unsigned int HostPins::toneFrequency(uint32_t pin) const
+{
+    const State *s = state(pin);
+    if (s == nullptr || (s->toneEndUs != 0 && hostClock.micros() >= s->toneEndUs))
+        return 0;
+    return s->toneFrequency;
+}
+
+void HostPins::connect(uint32_t pin, PinDevice *device)
+{
+    State *s = state(pin);
+    if (s != nullptr)
+        s->device = device;
+}
+
+void HostPins::reset()
+{
+    for (uint32_t pin = 0; pin < NUM_DIGITAL_PINS; pin++)
+    {
+        pins[pin] = State();
+    }
+}
+
+void HostPins::setMode(uint32_t pin, uint32_t mode)
+{
+    State *s = state(pin);
+    if (s != nullptr)
+        s->mode = mode;
+}
+
+void HostPins::write(uint32_t pin, int level)
+{
+    State *s = state(pin);
+    if (s == nullptr)
+        return;
+    s->output = level ? HIGH : LOW;
+    if (s->device != nullptr)
+        s->device->pinWritten(pin, s->output);
+}
+
+int HostPins::read(uint32_t pin) const
+{
+    const State *s = state(pin);
+    if (s == nullptr)
+        return LOW;
+    if (s->mode == OUTPUT)
+        return s->output;
+    int driven = s->device ? s->device->pinDriven(pin) : -1;
+    return driven >= 0 ? driven : inputLevel(*s);
+}
+
+int HostPins::readAnalog(uint32_t pin) const
+{
+    const State *s = state(pin);
+    return s ? s->analog : 0;
+}
+
+void HostPins::writePwm(uint32_t pin, int value)
+{
+    State *s = state(pin);
+    if (s != nullptr)
+        s->pwm = value;
+}
+
+void HostPins::setTone(uint32_t pin, unsigned int frequency, unsigned long durationMs)
+{
+    State *s = state(pin);
+    if (s == nullptr)
+        return;
+    s->toneFrequency = frequency;
+    s->toneEndUs = durationMs ? hostClock.micros() + durationMs * 1000 : 0;
+}
+
+void HostPins::attach(uint32_t pin, void (*handler)(), uint32_t mode)
+{
+    State *s = state(pin);
+    if (s == nullptr)
+        return;
+    s->handler = handler;
+    s->edge = mode;
+}
+
+void HostPins::detach(uint32_t pin)
+{
+    State *s = state(pin);
+    if (s != nullptr)
+        s->handler = nullptr;
+}
+
+void pinMode(uint32_t pin, uint32_t mode)
+{
+    hostPins.setMode(pin, mode);
+}
+
+void digitalWrite(uint32_t pin, uint32_t value)
+{
+    hostBus.pinWrites++;
+    hostPins.write(pin, value);
+}
+
+int digitalRead(uint32_t pin)
+{
+    hostBus.pinReads++;
+    return hostPins.read(pin);
+}
+
+int analogRead(uint32_t pin)
+{
+    hostBus.analogReads++;
+    return hostPins.readAnalog(pin);
+}
+
+void analogWrite(uint32_t pin, int value)
+{
+    hostPins.writePwm(pin, value);
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+{
+    // Like the STM32 core, which news its HardwareTimer on the first call.
+    static uint8_t *toneTimer = nullptr;
+    if (toneTimer == nullptr)
+        toneTimer = new uint8_t[64];
+    hostPins.setTone(pin, frequency, duration);
+}
+
+void noTone(uint8_t pin)
+{
+    hostPins.setTone(pin, 0, 0);
+}
+
+uint32_t digitalPinToInterrupt(uint32_t pin)
+{
+    return pin;
+}
+
+void attachInterrupt(uint32_t pin, void (*handler)(), uint32_t mode)
+{
+    hostPins.attach(pin, handler, mode);
+}
+
+void detachInterrupt(uint32_t pin)
+{
+    hostPins.detach(pin);
+}
+
+// Math
+
+static uint32_t randomState = 1;
+
+long random(long max)
+{
+    if (max <= 0)
+        return 0;
+    // Numerical Recipes LCG; only used if a caller bypasses RandomService.
+    randomState = randomState * 1664525u + 1013904223u;
+    return (long)(randomState % (uint32_t)max);
+}
+
+long random(long min, long max)
+{
+    return min >= max ? min : min + random(max - min);
+}
+
+void randomSeed(unsigned long seed)
+{
+    randomState = (uint32_t)seed;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Serial
+
+void HostSerial::feed(const char *text)
+{
+    while (*text)
+    {
+        feed((uint8_t)*text++);
+    }
+}
+
+void HostSerial::feed(uint8_t byte)
+{
+    if (inputHead - inputTail < INPUT_SIZE)
+    {
+        input[inputHead++ % INPUT_SIZE] = byte;
+    }
+}
+
+int HostSerial::read()
+{
+    if (inputHead == inputTail)
+        return -1;
+    return input[inputTail++ % INPUT_SIZE];
+}
+
+void HostSerial::begin(unsigned long baud)
+{
+    byteNs = 10000000000ULL / baud;
+}
+
+size_t HostSerial::txPending() const
+{
+    uint64_t now = hostClock.micros() * 1000;
+    return txDoneNs > now ? (size_t)((txDoneNs - now + byteNs - 1) / byteNs) : 0;
+}
+
+int HostSerial::availableForWrite() const
+{
+    return (int)(TX_BUFFER_SIZE - 1 - txPending());
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        // Full: wait for the UART to send a byte.
+        while (availableForWrite() <= 0)
+        {
+            uint64_t waitUs = (txDoneNs - hostClock.micros() * 1000 - (TX_BUFFER_SIZE - 2) * byteNs) / 1000 + 1;
+            hostClock.advance(waitUs);
+            blocked += waitUs;
+        }
+        uint64_t now = hostClock.micros() * 1000;
+        txDoneNs = (txDoneNs > now ? txDoneNs : now) + byteNs;
+    }
+    if (output != nullptr)
+    {
+        fwrite(buffer, 1, size, output);
+    }
+    written += size;
+    return size;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    hostSerial.begin(baud);
+}
+
+int HardwareSerial::available()
+{
+    return hostSerial.available();
+}
+
+int HardwareSerial::read()
+{
+    return hostSerial.read();
+}
+
+int HardwareSerial::availableForWrite()
+{
+    return hostSerial.availableForWrite();
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    return hostSerial.write(buffer, size);
+}
+
+// I2C
+
+bool HostI2c::attach(uint8_t address, I2cDevice *device)
+{
+    for (uint8_t i = 0; i < MAX_DEVICES; i++)
+    {
+        if (devices[i] == nullptr || addresses[i] == address)
+        {
+            addresses[i] = address;
+            devices[i] = device;
+            return true;
+        }
+    }
+    return false;
+}
+
+I2cDevice *HostI2c::device(uint8_t address) const
+{
+    for (uint8_t i = 0; i < MAX_DEVICES; i++)
+    {
+        if (devices[i] != nullptr && addresses[i] == address)
+            return devices[i];
+    }
+    return nullptr;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    this->address = address;
+    length = 0;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+    if (length == BUFFER_SIZE)
+        return 0;
+    buffer[length++] = value;
+    return 1;
+}
+
+// A transfer holds the caller for its time on the wire: start, nine
+// clocks per byte (address byte and ACKs included) and stop.
+uint8_t TwoWire::endTransmission(bool stop)
+{
+    (void)stop;
+    uint32_t bits = (length + 1) * 9 + 2;
+    uint32_t busUs = (uint32_t)(((uint64_t)bits * 1000000 + clockHz - 1) / clockHz);
+    hostClock.advance(busUs);
+    hostBus.i2cTransmissions++;
+    hostBus.i2cBytes += length + 1;
+    I2cDevice *device = hostI2c.device(address);
+    if (device != nullptr)
+    {
+        device->receive(buffer, length, busUs);
+    }
+    length = 0;
+    return 0;
+}
@@ -0,0 +1,201 @@
+#ifndef HOST_CONTROL_H
+#define HOST_CONTROL_H
+
+#include <Arduino.h>
+#include <stdio.h>
+
+// Test-side controls for the env:native Arduino shim: the virtual clock,
+// the simulated pins, the serial port and the I2C bus.
+
+// Virtual time. delay(), delayMicroseconds() and advance() move it, and
+// every millis()/micros() read adds a microsecond.
+class VirtualClock {
+public:
+    uint64_t micros() const { return nowUs; }
+    uint64_t millis() const { return nowUs / 1000; }
+    void advance(uint64_t us) { nowUs += us; }
+    void advanceMs(uint64_t ms) { nowUs += ms * 1000; }
+    void reset() { nowUs = 0; }
+
+private:
+    uint64_t nowUs = 0;
+};
+
+extern VirtualClock hostClock;
+
+// Model of a device wired to GPIO pins (see connect()). It sees every
+// write to its pins and drives the ones it outputs on.
+class PinDevice {
+public:
+    virtual ~PinDevice() {}
+    virtual void pinWritten(uint32_t pin, int level) = 0;
+    // Level the device drives pin to, or -1 when it leaves it alone.
+    virtual int pinDriven(uint32_t pin) const { return -1; }
+};
+
+// Pin levels as the board would see them. Inputs are driven from outside
+// with drive(); a change fires the pin's interrupt handler like an edge on
+// the real pin would.
+class HostPins {
+public:
+    void drive(uint32_t pin, int level);
+    // Let the pin float again (pull-up inputs read HIGH).
+    void release(uint32_t pin);
+    void setAnalog(uint32_t pin, int value);
+
+    uint32_t mode(uint32_t pin) const;
+    int level(uint32_t pin) const;
+    int pwm(uint32_t pin) const;
+    // Frequency of the running tone on pin, 0 when silent.
+    unsigned int toneFrequency(uint32_t pin) const;
+    // Wire a device model to pin (nullptr disconnects); reads of the pin
+    // as an input return what the device drives.
+    void connect(uint32_t pin, PinDevice *device);
+    void reset();
+
+    // Called by the Arduino API implementation.
+    void setMode(uint32_t pin, uint32_t mode);
+    void write(uint32_t pin, int level);
+    int read(uint32_t pin) const;
+    int readAnalog(uint32_t pin) const;
+    void writePwm(uint32_t pin, int value);
+    void setTone(uint32_t pin, unsigned int frequency, unsigned long durationMs);
+    void attach(uint32_t pin, void (*handler)(), uint32_t mode);
+    void detach(uint32_t pin);
+
+private:
+    struct State
+    {
+        uint32_t mode = INPUT;
+        int output = LOW;
+        int input = LOW;
+        bool driven = false;
+        int analog = 0;
+        int pwm = 0;
+        unsigned int toneFrequency = 0;
+        uint64_t toneEndUs = 0;
+        void (*handler)() = nullptr;
+        uint32_t edge = CHANGE;
+        PinDevice *device = nullptr;
+    };
+
+    State *state(uint32_t pin);
+    const State *state(uint32_t pin) const;
+    int inputLevel(const State &s) const;
+    void fireIfEdge(State &s, int before);
+
+    State pins[NUM_DIGITAL_PINS];
+};
+
+extern HostPins hostPins;
+
+// Host side of Serial: bytes to feed the firmware, and where its output goes.
+// The TX side is modelled like the core's: a SERIAL_TX_BUFFER_SIZE buffer
+// the UART empties at the baud rate (ten bits a byte) on the virtual clock,
+// and a write() that does not fit waits for room.
+class HostSerial {
+public:
+    static const size_t INPUT_SIZE = 256;
+    static const size_t TX_BUFFER_SIZE = SERIAL_TX_BUFFER_SIZE;
+
+    void feed(const char *text);
+    void feed(uint8_t byte);
+    // Firmware output goes to out (nullptr drops it).
+    void setOutput(FILE *out) { output = out; }
+    uint64_t bytesWritten() const { return written; }
+    // Virtual time write() spent waiting for room in the TX buffer.
+    uint64_t blockedUs() const { return blocked; }
+
+    // Called by HardwareSerial.
+    void begin(unsigned long baud);
+    int available() const { return (int)(inputHead - inputTail); }
+    int read();
+    int availableForWrite() const;
+    size_t write(const uint8_t *buffer, size_t size);
+
+private:
+    size_t txPending() const;
+
+    uint8_t input[INPUT_SIZE];
+    size_t inputHead = 0;
+    size_t inputTail = 0;
+    FILE *output = nullptr;
+    uint64_t written = 0;
+    uint64_t byteNs = 10000000000ULL / 921600;
+    uint64_t txDoneNs = 0; // When the last buffered byte is on the wire
+    uint64_t blocked = 0;
+};
+
+extern HostSerial hostSerial;
+
+// Model of a device on the I2C bus; gets each transmission's bytes once
+// the transfer is over, with the time the bus was busy with it.
+class I2cDevice {
+public:
+    virtual ~I2cDevice() {}
+    virtual void receive(const uint8_t *data, size_t length, uint32_t busUs) = 0;
+};
+
+class HostI2c {
+public:
+    static const uint8_t MAX_DEVICES = 4;
+
+    bool attach(uint8_t address, I2cDevice *device);
+    I2cDevice *device(uint8_t address) const;
+
+private:
+    uint8_t addresses[MAX_DEVICES];
+    I2cDevice *devices[MAX_DEVICES] = {nullptr};
+};
+
+extern HostI2c hostI2c;
+
+// Traffic on the simulated buses, for cost accounting: GPIO accesses,
+// analog conversions, and I2C transmissions with their bytes (address
+// byte included). Counts only grow; take differences around the code
+// being measured.
+struct HostBusCounters
+{
+    uint64_t pinWrites = 0;
+    uint64_t pinReads = 0;
+    uint64_t analogReads = 0;
+    uint64_t i2cTransmissions = 0;
+    uint64_t i2cBytes = 0;
+};
+
+extern HostBusCounters hostBus;
+
+// What a device model has cost its bus: bytes and transactions (an I2C
+// transmission, a TM1638 strobe) and the time the bus was busy.
+struct BusCost
+{
+    uint64_t bytes = 0;
+    uint64_t transactions = 0;
+    uint64_t busUs = 0;
+
+    BusCost operator-(const BusCost &since) const
+    {
+        BusCost d;
+        d.bytes = bytes - since.bytes;
+        d.transactions = transactions - since.transactions;
+        d.busUs = busUs - since.busUs;
+        return d;
+    }
+};
+
+// Run the firmware's loop() until the virtual clock has moved by ms.
+void hostRunFor(uint32_t ms);
+// Run loop() once.
+void hostLoop();
+
+// Marks code as the firmware's: heap allocations made while one is alive
+// go to heapGuard, as the allocator wrappers send them there on the board.
+// hostLoop() runs loop() inside one, so the shim's and the test's own
+// allocations are not counted. Counted on glibc hosts only.
+struct HostFirmwareScope
+{
+    HostFirmwareScope();
+    ~HostFirmwareScope();
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "HostArduino.h"
+#include "InputTraceFile.h"
+#include "InputTrace.h"
+#include "Telemetry.h"
+#include <string.h>
+
+void setup();
+void loop();
+
+extern const uint32_t TOTAL_TIME;
+
+// Feed a recorded input trace back through the firmware and report
+// whether every state change happened on the recorded frame.
+static int replay(const char *path)
+{
+    InputTraceFile file;
+    if (!file.open(path))
+    {
+        fprintf(stderr, "%s: %s\n", path, file.error());
+        return 2;
+    }
+    if (file.header().flags & INPUT_TRACE_TRUNCATED)
+        fprintf(stderr, "%s: capture lost chunks, replaying up to the gap\n", path);
+    inputTrace.startReplay(file.data(), file.dataLength());
+    setup();
+    uint32_t frameTime;
+    while (inputTrace.prepareFrame(frameTime))
+    {
+        // Each frame starts when it did on the board.
+        uint64_t start = (uint64_t)frameTime * 1000;
+        if (hostClock.micros() < start)
+            hostClock.advance(start - hostClock.micros());
+        hostLoop();
+    }
+    fflush(stdout);
+    fprintf(stderr, "replayed %u of %u frames, %u divergent", inputTrace.frames(), file.header().frameCount,
+            inputTrace.divergences());
+    if (inputTrace.divergences() > 0)
+        fprintf(stderr, " (first at frame %u)", inputTrace.firstDivergence());
+    fprintf(stderr, "\n");
+    return inputTrace.divergences() > 0 ? 1 : 0;
+}
+
+// Default entry point for `pio run -e native`: boot the firmware and run
+// it for the given number of virtual seconds (a full session and a minute
+// by default), writing its telemetry to stdout:
+//
+//     .pio/build/native/program | python3 tools/telemetry_decode.py -t -
+//
+// With --replay, play a trace file from tools/input_trace.py instead:
+//
+//     .pio/build/native/program --replay session.itr
+//
+// Tests link their own main(), which replaces this one.
+__attribute__((weak)) int main(int argc, char **argv)
+{
+    hostSerial.setOutput(stdout);
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+        return replay(argv[2]);
+    uint32_t seconds = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : TOTAL_TIME / 1000 + 60;
+    setup();
+    hostRunFor(seconds * 1000);
+    fflush(stdout);
+    fprintf(stderr, "telemetry: %llu bytes, %u records dropped, %llu us waiting on the UART\n",
+            (unsigned long long)hostSerial.bytesWritten(), telemetry.dropped(),
+            (unsigned long long)hostSerial.blockedUs());
+    return 0;
+}
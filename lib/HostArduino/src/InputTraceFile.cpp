@@ -0,0 +1,76 @@
+#include "InputTraceFile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+InputTraceFile::~InputTraceFile()
+{
+    close();
+}
+
+bool InputTraceFile::fail(const char *text)
+{
+    close();
+    message = text;
+    return false;
+}
+
+bool InputTraceFile::open(const char *path)
+{
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return fail(strerror(errno));
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(InputTraceHeader))
+    {
+        ::close(fd);
+        return fail("not an input trace (too short)");
+    }
+    void *mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return fail(strerror(errno));
+    base = (const uint8_t *)mapped;
+    size = (size_t)info.st_size;
+    head = (const InputTraceHeader *)base;
+
+    if (memcmp(head->magic, "ITR1", 4) != 0)
+        return fail("not an input trace (bad magic)");
+    if (head->version != 1 || head->blockEntrySize != sizeof(InputTraceBlock))
+        return fail("unsupported input trace version");
+    if (head->dataOffset > size || head->dataLength > size - head->dataOffset || head->indexOffset % 8 != 0 ||
+        head->indexOffset > size || (uint64_t)head->blockCount * sizeof(InputTraceBlock) > size - head->indexOffset)
+        return fail("input trace is truncated");
+    blocks = (const InputTraceBlock *)(base + head->indexOffset);
+    return true;
+}
+
+void InputTraceFile::close()
+{
+    if (base != nullptr)
+        munmap((void *)base, size);
+    base = nullptr;
+    size = 0;
+    head = nullptr;
+    blocks = nullptr;
+}
+
+uint32_t InputTraceFile::blockAt(uint32_t timeMs) const
+{
+    uint32_t low = 0;
+    uint32_t high = head->blockCount;
+    // First block starting after timeMs, then the one before it.
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if (blocks[mid].timeMs <= timeMs)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low > 0 ? low - 1 : 0;
+}
@@ -0,0 +1,74 @@
+#ifndef INPUT_TRACE_FILE_H
+#define INPUT_TRACE_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Input trace file, as written by tools/input_trace.py from a capture of
+// the board's TM_INPUT_TRACE telemetry. Little-endian:
+//
+//   header   InputTraceHeader, 64 bytes
+//   data     the record stream of include/InputTrace.h, back to back
+//   index    one InputTraceBlock per block of about blockSize data bytes
+//
+// Each block starts on a frame record and carries the decoder state at
+// that point, so a reader can start decoding at any block. The file is
+// mapped rather than read, so hours of capture open instantly and only
+// the pages touched are loaded.
+struct InputTraceHeader
+{
+    char magic[4]; // "ITR1"
+    uint16_t version;
+    uint16_t blockEntrySize;
+    uint32_t blockSize;
+    uint32_t blockCount;
+    uint64_t dataOffset;
+    uint64_t dataLength;
+    uint64_t indexOffset;
+    uint64_t seed;
+    uint32_t frameCount;
+    uint32_t durationMs; // Time of the last frame
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static const uint32_t INPUT_TRACE_TRUNCATED = 1; // Chunks were lost; data stops at the gap
+
+struct InputTraceBlock
+{
+    uint64_t offset;    // Into the data
+    uint32_t frame;     // Frames before the block
+    uint32_t timeMs;    // Time of the frame before the block
+    int16_t analog[4];  // Last value of each analog channel
+};
+
+static_assert(sizeof(InputTraceHeader) == 64, "Trace header layout");
+static_assert(sizeof(InputTraceBlock) == 24, "Trace index entry layout");
+
+class InputTraceFile {
+public:
+    ~InputTraceFile();
+    // Map and validate path; false with error() set on failure.
+    bool open(const char *path);
+    void close();
+    const char *error() const { return message; }
+
+    const InputTraceHeader &header() const { return *head; }
+    const uint8_t *data() const { return base + head->dataOffset; }
+    size_t dataLength() const { return (size_t)head->dataLength; }
+    uint32_t blockCount() const { return head->blockCount; }
+    const InputTraceBlock &block(uint32_t index) const { return blocks[index]; }
+    // Last block starting at or before timeMs.
+    uint32_t blockAt(uint32_t timeMs) const;
+
+private:
+    bool fail(const char *text);
+
+    const uint8_t *base = nullptr;
+    size_t size = 0;
+    const InputTraceHeader *head = nullptr;
+    const InputTraceBlock *blocks = nullptr;
+    const char *message = "";
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "Tm1638Model.h"
+#include <string.h>
+
+static const uint8_t SCAN_BYTES = 4;
+
+Tm1638Model::Tm1638Model(uint32_t stbPin, uint32_t clkPin, uint32_t dioPin)
+    : stbPin(stbPin), clkPin(clkPin), dioPin(dioPin), stb(HIGH), clk(HIGH), dio(HIGH), control(0),
+      fixedAddress(false), address(0), keys(0), byteIndex(0), shiftRegister(0), bitIndex(0), reading(false),
+      readBit(-1), strobeUs(0), bitCount(0), scanCount(0), errors(0)
+{
+    memset(ram, 0, sizeof(ram));
+}
+
+void Tm1638Model::connect()
+{
+    hostPins.connect(stbPin, this);
+    hostPins.connect(clkPin, this);
+    hostPins.connect(dioPin, this);
+}
+
+void Tm1638Model::pinWritten(uint32_t pin, int level)
+{
+    if (pin == dioPin)
+    {
+        dio = level;
+        return;
+    }
+    if (pin == stbPin && level != stb)
+    {
+        stb = level;
+        if (stb == LOW)
+        {
+            byteIndex = 0;
+            bitIndex = 0;
+            shiftRegister = 0;
+            reading = false;
+            strobeUs = hostClock.micros();
+        }
+        else
+        {
+            if (bitIndex != 0)
+                errors++;
+            busCost.transactions++;
+            busCost.busUs += hostClock.micros() - strobeUs;
+            reading = false;
+        }
+        return;
+    }
+    if (pin == clkPin && level != clk)
+    {
+        clk = level;
+        if (clk == HIGH)
+            risingEdge();
+        else
+            fallingEdge();
+    }
+}
+
+int Tm1638Model::pinDriven(uint32_t pin) const
+{
+    if (pin != dioPin || !reading || readBit < 0 || readBit >= SCAN_BYTES * 8)
+        return -1;
+    return (scanByte((uint8_t)(readBit / 8)) >> (readBit % 8)) & 0x01;
+}
+
+void Tm1638Model::risingEdge()
+{
+    if (stb == HIGH)
+    {
+        errors++;
+        return;
+    }
+    bitCount++;
+    if (reading)
+    {
+        // The controller samples the bit the chip put out on the falling edge.
+        if (readBit % 8 == 7)
+            busCost.bytes++;
+        return;
+    }
+    shiftRegister |= (dio ? 1 : 0) << bitIndex;
+    if (++bitIndex == 8)
+    {
+        busCost.bytes++;
+        byteReceived(shiftRegister);
+        bitIndex = 0;
+        shiftRegister = 0;
+    }
+}
+
+void Tm1638Model::fallingEdge()
+{
+    if (reading && stb == LOW)
+        readBit++;
+}
+
+void Tm1638Model::byteReceived(uint8_t value)
+{
+    if (byteIndex++ != 0)
+    {
+        ram[address] = value;
+        if (!fixedAddress)
+            address = (address + 1) & 0x0F;
+        return;
+    }
+    switch (value & 0xC0)
+    {
+    case 0x40:
+        fixedAddress = value & 0x04;
+        if ((value & 0x03) == 0x02)
+        {
+            reading = true;
+            readBit = -1;
+            scanCount++;
+        }
+        break;
+    case 0x80:
+        control = value & 0x0F;
+        break;
+    case 0xC0:
+        address = value & 0x0F;
+        break;
+    }
+}
+
+// Scan byte i has key S(i+1) in bit 0 and key S(i+5) in bit 4.
+uint8_t Tm1638Model::scanByte(uint8_t index) const
+{
+    return (uint8_t)(((keys >> index) & 0x01) | (((keys >> (index + 4)) & 0x01) << 4));
+}
+
+std::string Tm1638Model::text() const
+{
+    static const uint8_t DIGITS[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+    std::string out;
+    for (uint8_t digit = 0; digit < 8; digit++)
+    {
+        uint8_t pattern = segments(digit) & 0x7F; // Without the decimal point
+        char c = pattern == 0 ? ' ' : pattern == 0x40 ? '-' : '?';
+        for (uint8_t d = 0; d < 10; d++)
+        {
+            if (DIGITS[d] == pattern)
+                c = (char)('0' + d);
+        }
+        out += c;
+    }
+    return out;
+}
@@ -0,0 +1,76 @@
+#ifndef TM1638_MODEL_H
+#define TM1638_MODEL_H
+
+#include "HostArduino.h"
+#include <string>
+
+// TM1638 LED&KEY board on three GPIO pins, for env:native.
+//
+// Follows the wire protocol bit by bit: a transaction runs while STB is
+// low, bits are taken LSB first on CLK's rising edge, and the first byte
+// is a command. Data commands (0x40..) pick write or key read and auto
+// or fixed addressing; an address command (0xC0..) is followed by data
+// for the 16-byte display RAM (digit i at 2i, LED i at 2i + 1); display
+// control (0x80..) sets the brightness. After a key read command the
+// chip drives DIO with four scan bytes, one bit per CLK falling edge.
+//
+// Keys are set with setKeys() in KeyLed's order (S1 in bit 0). Costs are
+// counted per transaction, with bus time from STB low to STB high on the
+// virtual clock.
+class Tm1638Model : public PinDevice {
+public:
+    Tm1638Model(uint32_t stbPin, uint32_t clkPin, uint32_t dioPin);
+    // Wire the model to its pins; hostPins.reset() disconnects it.
+    void connect();
+    void pinWritten(uint32_t pin, int level) override;
+    int pinDriven(uint32_t pin) const override;
+
+    void setKeys(uint8_t mask) { keys = mask; }
+    uint8_t segments(uint8_t digit) const { return ram[(digit & 7) * 2]; }
+    bool led(uint8_t index) const { return ram[(index & 7) * 2 + 1] & 0x01; }
+    // The eight digits as text, for digits, '-' and blanks; other
+    // segment patterns read as '?'.
+    std::string text() const;
+    bool displayOn() const { return control & 0x08; }
+    uint8_t brightness() const { return control & 0x07; }
+
+    const BusCost &cost() const { return busCost; }
+    uint64_t bits() const { return bitCount; }
+    uint64_t keyScans() const { return scanCount; }
+    // Bytes cut short by STB going high, or clocked with STB high.
+    uint64_t protocolErrors() const { return errors; }
+
+private:
+    void risingEdge();
+    void fallingEdge();
+    void byteReceived(uint8_t value);
+    uint8_t scanByte(uint8_t index) const;
+
+    uint32_t stbPin;
+    uint32_t clkPin;
+    uint32_t dioPin;
+    int stb;
+    int clk;
+    int dio;
+
+    uint8_t ram[16];
+    uint8_t control;
+    bool fixedAddress;
+    uint8_t address;
+    uint8_t keys;
+
+    // Current transaction
+    uint8_t byteIndex;
+    uint8_t shiftRegister;
+    uint8_t bitIndex;
+    bool reading;
+    int readBit; // Bit of the scan on DIO, -1 before the first
+    uint64_t strobeUs;
+
+    BusCost busCost;
+    uint64_t bitCount;
+    uint64_t scanCount;
+    uint64_t errors;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+// I2C master for env:native. Each transmission is handed to the device
+// model registered for its address (see HostArduino.h); with none, the
+// bytes are dropped and the transfer still succeeds. Either way it takes
+// its time on the bus at the setClock() rate off the virtual clock.
+class TwoWire {
+public:
+    static const uint8_t BUFFER_SIZE = 32;
+
+    void begin() {}
+    void setClock(uint32_t hz) { clockHz = hz ? hz : 100000; }
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t value);
+    uint8_t endTransmission(bool stop = true);
+
+private:
+    uint8_t address = 0;
+    uint8_t buffer[BUFFER_SIZE];
+    uint8_t length = 0;
+    uint32_t clockHz = 100000;
+};
+
+extern TwoWire Wire;
+
+#endif
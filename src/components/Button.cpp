@@ -1,42 +1,93 @@
 #include "Button.h"
+#include "pins.h"
+#include "InputTrace.h"
+#include "Latency.h"
 
 Button::Button(uint8_t pin, unsigned long debounceDelay)
-    : pin(pin), debounceDelay(debounceDelay), stableState(HIGH), lastRawState(HIGH), lastDebounceTime(0), fallingEdgeDetected(false) {}
+    : pin(pin), debounceDelay(debounceDelay), stableState(HIGH), lastRawState(HIGH), lastDebounceTime(0), pendingPresses(0), fallingEdgeDetected(false) {}
 
 void Button::begin()
 {
     pinMode(pin, INPUT_PULLUP);
     stableState = digitalRead(pin);
     lastRawState = stableState;
+    eventBus.subscribe(EVENT_BIT(EVENT_BUTTON_EDGE), &Button::handleEdge, this);
+    attachInterrupt(digitalPinToInterrupt(pin), &Button::handleInterrupt, CHANGE);
 }
 
-void Button::update()
+// Pin interrupt: record the new level and when it happened.
+void Button::handleInterrupt()
 {
-    int rawState = digitalRead(pin);
-    if (rawState != lastRawState)
+    Event event = makeEvent(EVENT_BUTTON_EDGE);
+    event.button.level = ButtonPin::read() ? HIGH : LOW;
+    if (event.button.level == LOW)
     {
-        lastDebounceTime = millis();
-        lastRawState = rawState;
+        LATENCY_INPUT(LATENCY_BUTTON);
     }
-    if ((millis() - lastDebounceTime) > debounceDelay)
+    eventBus.publishFromIsr(event);
+}
+
+void Button::handleEdge(const Event &event, void *context)
+{
+    inputTrace.buttonEdge(event.button.level, event.timestamp);
+    static_cast<Button *>(context)->processEdge(event.button.level, event.timestamp);
+}
+
+void Button::processEdge(int rawState, unsigned long timestamp)
+{
+    // Stale edges (queued before a level read in update()) change nothing.
+    if (rawState == lastRawState || (long)(timestamp - lastDebounceTime) < 0)
     {
-        if (rawState != stableState)
-        {
-            if (stableState == HIGH && rawState == LOW)
-            {
-                fallingEdgeDetected = true;
-            }
-            else
-            {
-                fallingEdgeDetected = false;
-            }
-            stableState = rawState;
-        }
-        else
+        return;
+    }
+    // The previous level was held from lastDebounceTime until this edge.
+    if ((timestamp - lastDebounceTime) > debounceDelay)
+    {
+        commit(lastRawState, lastDebounceTime);
+    }
+    lastDebounceTime = timestamp;
+    lastRawState = rawState;
+}
+
+void Button::commit(int rawState, unsigned long timestamp)
+{
+    if (rawState == stableState)
+    {
+        return;
+    }
+    if (stableState == HIGH && rawState == LOW)
+    {
+        Event event = makeEvent(EVENT_BUTTON_PRESSED);
+        event.timestamp = timestamp;
+        eventBus.publish(event);
+        LATENCY_DELIVERED();
+        pendingPresses++;
+    }
+    stableState = rawState;
+}
+
+void Button::update()
+{
+    // Edges have been delivered by eventBus.dispatch(). A bounce can fill
+    // the input queue and lose the last edge, so take the level from the
+    // pin when it disagrees; a replay gets it from the recorded edge.
+    if (!inputTrace.replaying())
+    {
+        int level = ButtonPin::read() ? HIGH : LOW;
+        if (level != lastRawState)
         {
-            fallingEdgeDetected = false;
+            unsigned long now = millis();
+            inputTrace.buttonEdge(level, now);
+            processEdge(level, now);
         }
     }
+    // Settle the last one.
+    if ((millis() - lastDebounceTime) > debounceDelay)
+    {
+        commit(lastRawState, lastDebounceTime);
+    }
+    fallingEdgeDetected = pendingPresses > 0;
+    pendingPresses = 0;
 }
 
 bool Button::isPressed()
@@ -1,54 +1,37 @@
 #include "Buzzer.h"
+#include "EventBus.h"
+#include "Latency.h"
 
-Buzzer::Buzzer(uint8_t buzzerPin) : buzzerPin(buzzerPin) {}
+Buzzer::Buzzer(uint8_t buzzerPin) : buzzerPin(buzzerPin), toneEndTime(0) {}
 
 void Buzzer::begin()
 {
   pinMode(buzzerPin, OUTPUT);
-}
-
-void Buzzer::playTone(int frequency, int duration)
-{
-  tone(buzzerPin, frequency, duration);
-  delay(duration);
+  // The core allocates tone()'s timer on the first call; get that done
+  // here, before setup() locks the heap.
+  tone(buzzerPin, 1, 1);
   noTone(buzzerPin);
 }
 
-void Buzzer::playErrorTone()
+void Buzzer::queueTone(int frequency, int duration)
 {
-  playTone(300, 200);
+  Event event = makeEvent(EVENT_TONE);
+  event.tone.frequency = frequency;
+  event.tone.duration = duration;
+  eventBus.queueAudio(event);
 }
 
-void Buzzer::playSuccessMelody()
+void Buzzer::update()
 {
-  int melody[] = {261, 293, 329, 349, 392, 440, 493, 523};
-  playTone(melody[0], 200);
-  delay(200);
-  for (int i = 1; i < 7; i++)
+  if (busy())
   {
-    playTone(melody[i], 100);
-    delay(150);
+    return;
   }
-  playTone(melody[7], 200);
-  delay(200);
-}
-
-void Buzzer::playGameOverMelody()
-{
-  int melody[] = {523, 493, 440, 392, 349, 329, 293, 261};
-  for (int i = 0; i < 8; i++)
+  Event event;
+  if (eventBus.nextAudio(event))
   {
-    playTone(melody[i], 100);
-    delay(50);
+    LATENCY_OUTPUT(LATENCY_TONE);
+    tone(buzzerPin, event.tone.frequency, event.tone.duration);
+    toneEndTime = millis() + event.tone.duration;
   }
 }
-
-void Buzzer::playWinningMelody()
-{
-  int melody[] = {261, 293, 329, 349, 392, 440, 493, 523};
-  for (int i = 0; i < 8; i++)
-  {
-    playTone(melody[i], 100);
-    delay(50);
-  }
-}
\ No newline at end of file
@@ -1,57 +1,74 @@
 #include "KeyLed.h"
-#include <stdio.h>
+#include "EventBus.h"
+#include "SessionClock.h"
+#include "Format.h"
+#include "Telemetry.h"
+#include "InputTrace.h"
+#include "Latency.h"
 #include <string.h>
 
-KeyLed::KeyLed(uint8_t stbPin, uint8_t clkPin, uint8_t dioPin)
-    : tm(stbPin, clkPin, dioPin) {}
+KeyLed::KeyLed() : lastKeys(0), leds(0) {}
 
 void KeyLed::begin()
 {
-    tm.displayBegin();
+    tm.begin();
 }
 
 uint8_t KeyLed::readButtons()
 {
-    return tm.readButtons();
+    return inputTrace.keys(tm.readButtons());
 }
 
-void KeyLed::setLED(uint8_t index, bool state)
+void KeyLed::update()
 {
-    tm.setLED(index, state ? 1 : 0);
+    if (!eventBus.hasSubscriber(EVENT_KEYS_CHANGED))
+    {
+        lastKeys = 0;
+        return;
+    }
+    uint8_t keys = inputTrace.keys(tm.readButtons());
+    if (keys != lastKeys)
+    {
+        if (keys & ~lastKeys)
+        {
+            LATENCY_INPUT(LATENCY_KEYS);
+            LATENCY_DELIVERED();
+        }
+        Event event = makeEvent(EVENT_KEYS_CHANGED);
+        event.keys.mask = keys;
+        eventBus.publish(event);
+        lastKeys = keys;
+    }
 }
 
-void KeyLed::displayTime(uint32_t elapsed, uint32_t totalDuration, int attemptCount)
+void KeyLed::setLED(uint8_t index, bool state)
 {
-    // Calculate remaining time.
-    unsigned long remaining = (totalDuration > elapsed) ? (totalDuration - elapsed) : 0;
-    unsigned int secondsRemaining = remaining / 1000;
-    int minutes = secondsRemaining / 60;
-    int seconds = secondsRemaining % 60;
-
-    // Format time as "mmss" always 4 characters
-    char timeStr[5];
-    sprintf(timeStr, "%02d%02d", minutes, seconds);
+    uint8_t bit = 1 << index;
+    if (((leds & bit) != 0) != state)
+    {
+        LATENCY_OUTPUT(LATENCY_LED);
+        leds ^= bit;
+    }
+    tm.setLED(index, state);
+}
 
-    // Format the button count as a right-aligned number in a fixed 4-character field.
-    char countStr[5];
-    sprintf(countStr, "%4d", attemptCount);
+void KeyLed::displayTime(int attemptCount)
+{
+    // Remaining time at the frame snapshot.
+    unsigned long remaining = sessionClock.remaining();
 
-    // Combine the two parts into an 8-character string.
+    // "mmss" followed by the button count right-aligned in 4 characters.
     char disp[9];
-    sprintf(disp, "%s%s", timeStr, countStr);
+    Formatter(disp, sizeof(disp)).time(remaining / 1000, MMSS).number(attemptCount, rightAligned(4));
 
     tm.displayText(disp);
 }
 
 void KeyLed::printTimeUsed(unsigned long startTime)
 {
-    unsigned long usedTime = millis() - startTime;
+    unsigned long usedTime = sessionClock.since(startTime);
     unsigned int totalSeconds = usedTime / 1000;
     unsigned int minutes = totalSeconds / 60;
     unsigned int seconds = totalSeconds % 60;
-    Serial.print("Time used: ");
-    Serial.print(minutes);
-    Serial.print("m and ");
-    Serial.print(seconds);
-    Serial.println("s");
+    telemetry.log(TM_TIME_USED, minutes, seconds);
 }
@@ -1,44 +1,133 @@
 #include "LCD.h"
+#include <Wire.h>
+#include "Trace.h"
+#include "Latency.h"
 
-LCD::LCD(uint8_t address, uint8_t columns, uint8_t rows) : lcd(address, columns, rows) {}
+// HD44780 commands
+static const uint8_t LCD_CLEARDISPLAY = 0x01;
+static const uint8_t LCD_ENTRYMODESET = 0x04;
+static const uint8_t LCD_DISPLAYCONTROL = 0x08;
+static const uint8_t LCD_FUNCTIONSET = 0x20;
+static const uint8_t LCD_SETDDRAMADDR = 0x80;
+static const uint8_t LCD_ENTRYLEFT = 0x02;
+static const uint8_t LCD_DISPLAYON = 0x04;
+static const uint8_t LCD_2LINE = 0x08;
+
+// PCF8574 pin mapping
+static const uint8_t LCD_RS = 0x01;
+static const uint8_t LCD_EN = 0x04;
+static const uint8_t LCD_BACKLIGHT = 0x08;
+
+// Time the controller needs after power is applied, and after clear.
+static const unsigned long LCD_POWER_UP_MS = 50;
+static const unsigned long LCD_CLEAR_MS = 2;
+static const unsigned int LCD_RESET_WAIT_US = 4500;
+static const uint32_t LCD_I2C_CLOCK_HZ = 100000; // PCF8574 maximum
+
+LCD::LCD(uint8_t address, uint8_t columns, uint8_t rows)
+    : address(address), columns(columns), rows(rows), backlightVal(LCD_BACKLIGHT), powerUpStart(0), poweringUp(false) {}
+
+void LCD::beginPowerUp()
+{
+    Wire.begin();
+    Wire.setClock(LCD_I2C_CLOCK_HZ);
+    powerUpStart = millis();
+    poweringUp = true;
+}
 
 void LCD::begin()
 {
-    lcd.init();
-    lcd.backlight();
+    if (!poweringUp)
+    {
+        beginPowerUp();
+    }
+    while (millis() - powerUpStart < LCD_POWER_UP_MS)
+    {
+    }
+    poweringUp = false;
+
+    // Reset into 4-bit mode (HD44780 datasheet, figure 24).
+    Wire.beginTransmission(address);
+    Wire.write(backlightVal);
+    Wire.endTransmission();
+    write4bits(0x03 << 4);
+    delayMicroseconds(LCD_RESET_WAIT_US);
+    write4bits(0x03 << 4);
+    delayMicroseconds(LCD_RESET_WAIT_US);
+    write4bits(0x03 << 4);
+    delayMicroseconds(150);
+    write4bits(0x02 << 4);
+
+    command(LCD_FUNCTIONSET | LCD_2LINE);
+    command(LCD_DISPLAYCONTROL | LCD_DISPLAYON);
+    clear();
+    command(LCD_ENTRYMODESET | LCD_ENTRYLEFT);
 }
 
 void LCD::clear()
 {
-    lcd.clear();
+    TRACE_SPAN(TRACE_LCD_CLEAR);
+    command(LCD_CLEARDISPLAY);
+    delay(LCD_CLEAR_MS);
 }
 
 void LCD::setCursor(uint8_t col, uint8_t row)
 {
-    lcd.setCursor(col, row);
+    static const uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};
+    if (row >= rows)
+    {
+        row = rows - 1;
+    }
+    command(LCD_SETDDRAMADDR | (col + rowOffsets[row]));
 }
 
 void LCD::print(const char *message)
 {
-    lcd.print(message);
+    while (*message)
+    {
+        send(*message++, LCD_RS);
+    }
+}
+
+void LCD::command(uint8_t value)
+{
+    send(value, 0);
+}
+
+void LCD::send(uint8_t value, uint8_t mode)
+{
+    write4bits((value & 0xF0) | mode);
+    write4bits(((value << 4) & 0xF0) | mode);
+}
+
+// One nibble per I2C transaction: data with EN high, then EN low to latch.
+void LCD::write4bits(uint8_t value)
+{
+    uint8_t data = value | backlightVal;
+    LATENCY_OUTPUT(LATENCY_LCD);
+    Wire.beginTransmission(address);
+    Wire.write(data | LCD_EN);
+    Wire.write(data & ~LCD_EN);
+    Wire.endTransmission();
 }
 
 void LCD::printMessage(const char *line1, const char *line2, unsigned long duration)
 {
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print(line1);
-    lcd.setCursor(0, 1);
-    lcd.print(line2);
+    clear();
+    setCursor(0, 0);
+    print(line1);
+    setCursor(0, 1);
+    print(line2);
     delay(duration);
 }
 
 void LCD::lcdShow(const char *line1, const char *line2) {
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print(line1);
-    lcd.setCursor(0, 1);
-    lcd.print(line2);
+    TRACE_SPAN(TRACE_LCD_SHOW);
+    clear();
+    setCursor(0, 0);
+    print(line1);
+    setCursor(0, 1);
+    print(line2);
 }
 
 // Helper function to update the LCD only when content changes.
@@ -1,14 +1,14 @@
 #include "Potentiometer.h"
 
-Potentiometer::Potentiometer(uint8_t analogPin) : analogPin(analogPin) {}
+Potentiometer::Potentiometer(uint8_t analogPin, InputChannel channel) : analogPin(analogPin), channel(channel) {}
 
 int Potentiometer::readValue()
 {
-    return analogRead(analogPin);
+    return inputTrace.analog(channel, analogRead(analogPin));
 }
 
 int Potentiometer::readMappedValue(int minVal, int maxVal)
 {
-    int raw = analogRead(analogPin);
+    int raw = readValue();
     return map(raw, 0, 1023, minVal, maxVal);
 }
@@ -1,20 +1,49 @@
 #include "RGBLed.h"
 #include "pins.h"
+#include "EventBus.h"
+#include "Latency.h"
+#include "Content.h"
 
 RGBLed::RGBLed() {}
 
 void RGBLed::begin()
 {
-    pinMode(PIN_RED, OUTPUT);
-    pinMode(PIN_GREEN, OUTPUT);
-    pinMode(PIN_BLUE, OUTPUT);
+    PwmPin<RedPin>::begin();
+    PwmPin<GreenPin>::begin();
+    PwmPin<BluePin>::begin();
 }
 
 void RGBLed::setColor(uint8_t r, uint8_t g, uint8_t b)
 {
-    analogWrite(PIN_RED, r);
-    analogWrite(PIN_GREEN, g);
-    analogWrite(PIN_BLUE, b);
+    LATENCY_OUTPUT(LATENCY_RGB);
+    PwmPin<RedPin>::write(r);
+    PwmPin<GreenPin>::write(g);
+    PwmPin<BluePin>::write(b);
+}
+
+void RGBLed::queueColor(uint8_t r, uint8_t g, uint8_t b)
+{
+    Event event = makeEvent(EVENT_COLOR);
+    event.color.r = r;
+    event.color.g = g;
+    event.color.b = b;
+    eventBus.queueLed(event);
+}
+
+void RGBLed::update()
+{
+    Event event;
+    bool changed = false;
+    uint8_t r = 0, g = 0, b = 0;
+    while (eventBus.nextLed(event))
+    {
+        r = event.color.r;
+        g = event.color.g;
+        b = event.color.b;
+        changed = true;
+    }
+    if (changed)
+        setColor(r, g, b);
 }
 
 void RGBLed::loadingEffect(unsigned long duration)
@@ -73,47 +102,15 @@ void RGBLed::loadingAnimation(uint32_t elapsed)
         setColor(255, 255, 255);
 }
 
-void RGBLed::getRandomColor(int type, int &red, int &green, int &blue) {
-    // type: 1 for one-value colors, 2 for two-value colors, 3 for three-value colors
-    // the values can be 0,32,64,96,128,160,192,224
-    if (type == 1) {
-        const int numColors = 5;
-        int colors[numColors][3] = {
-            {160, 0,   0},   
-            {0,   192, 0},  
-            {0,   0,   224}, 
-            {64, 0,   0},   
-            {0,   128, 0}   
-        };
-        int index = random(0, numColors);
-        red   = colors[index][0];
-        green = colors[index][1];
-        blue  = colors[index][2];
-    } else if (type == 2) {
-        const int numColors = 5;
-        int colors[numColors][3] = {
-            {64, 192, 0},   
-            {128, 160, 0},   
-            {224, 0,   192}, 
-            {0,   32, 192},
-            {160, 0,   224} 
-        };
-        int index = random(0, numColors);
-        red   = colors[index][0];
-        green = colors[index][1];
-        blue  = colors[index][2];
-    } else if (type == 3) {
-        const int numColors = 5;
-        int colors[numColors][3] = {
-            {32, 192, 96},
-            {64, 128, 32},
-            {32, 128, 32},
-            {96, 96, 32},
-            {160, 192, 32}
-        };
-        int index = random(0, numColors);
-        red   = colors[index][0];
-        green = colors[index][1];
-        blue  = colors[index][2];
+void RGBLed::getRandomColor(Xoshiro128 &random, int type, int &red, int &green, int &blue) {
+    // type: the Game3 level, 1 to CONTENT_PALETTE_LEVELS; the palettes
+    // (content/pack.json) hold multiples of 32 the pot can reach
+    if (type < 1 || type > CONTENT_PALETTE_LEVELS) {
+        return;
     }
+    uint8_t first = CONTENT_PALETTE_START[type - 1];
+    const ContentColor &color = CONTENT_PALETTE[first + random.below(CONTENT_PALETTE_START[type] - first)];
+    red   = color.r;
+    green = color.g;
+    blue  = color.b;
 }
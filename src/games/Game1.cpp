@@ -9,19 +9,22 @@
 #include "pins.h"
 #include "Score.h"
 #include "Globals.h"
+#include "GameArena.h"
+#include "SessionClock.h"
+#include "Format.h"
+#include "Random.h"
+#include "Checkpoint.h"
+#include "Telemetry.h"
+#include "GameRules.h"
+#include "PuzzleConfig.h"
+#include "Content.h"
 
 // Constant Definitions
 
-// Number of levels in the game
-const int NUM_LEVELS = 3;
-
 // Tone frequency and threshold constants
 const int TUNE_SEARCH = 500;                    // Frequency for distant tone feedback
 const int TUNE_CORRECT = 1200;                  // Frequency for correct guess tone
-const int THRESHOLD_LEVEL1 = 65;                // Base threshold for level 1
-const int CONFIRMATION_THRESHOLD = 75;          // Threshold to cancel confirmation
 const int PRINT_CHANGE_THRESHOLD = 80;          // Minimum change needed to update printed value
-const unsigned long CONFIRMATION_DELAY_MS = 80; // Delay required for confirmation (ms)
 
 // Tone for time-up event
 const int TONE_TIME_UP_FREQUENCY = 400;          // Frequency when time is up
@@ -32,16 +35,10 @@ const unsigned long MSG_STAGE0 = 2000;
 const unsigned long MSG_STAGE1 = 5000;
 const unsigned long MSG_STAGE2 = 8000;
 const unsigned long MSG_STAGE3 = 11000;
-const unsigned long MSG_STAGE4 = 14000;
-
-// Random combo generation constants
-const int RANDOM_MIN = 5;
-const int RANDOM_MAX = 32;
-const int RANDOM_MULTIPLIER = 100;
+const unsigned long MSG_STAGE4 = GAME1_INTRO_DURATION;
 
-// Level-specific adjustments for thresholds and tones
-const int LEVEL2_THRESHOLD_OFFSET = 10;
-const int LEVEL3_THRESHOLD_OFFSET = 20;
+// Level-specific tones (thresholds are in GameRules.h). The puzzle config
+// can override the tones, thresholds and confirmation.
 const int TUNE_LEVEL2 = 1500;
 const int TUNE_LEVEL3 = 1800;
 
@@ -50,51 +47,101 @@ const unsigned long TONE_DURATION_SHORT = 50;
 const unsigned long TONE_DURATION_LONG = 100;
 const unsigned long HOVER_BEEP_INTERVAL = 500;
 
-// Game completion display time
-const unsigned long GAME_COMPLETE_DISPLAY_TIME = 2000;
+// Intro messages before the vault opens for play
+static const Cue INTRO_TEXT[] = {
+    textCue(0, contentText(CONTENT_GAME1_INTRO[0][0]), contentText(CONTENT_GAME1_INTRO[0][1])),
+    textCue(MSG_STAGE0, contentText(CONTENT_GAME1_INTRO[1][0]), contentText(CONTENT_GAME1_INTRO[1][1])),
+    textCue(MSG_STAGE1, contentText(CONTENT_GAME1_INTRO[2][0]), contentText(CONTENT_GAME1_INTRO[2][1])),
+    textCue(MSG_STAGE2, contentText(CONTENT_GAME1_INTRO[3][0]), contentText(CONTENT_GAME1_INTRO[3][1])),
+    textCue(MSG_STAGE3, contentText(CONTENT_GAME1_INTRO[4][0]), contentText(CONTENT_GAME1_INTRO[4][1]))};
+static const Track INTRO_TRACKS[] = {track(INTRO_TEXT)};
+static const Timeline INTRO_SCENE = timeline(INTRO_TRACKS, MSG_STAGE4);
+
+static const Cue VAULT_OPEN_CUES[] = {
+    textCue(0, "Vault opened!", "Congrats!"),
+    colorCue(0, 0, 255, 0)};
+static const Track VAULT_OPEN_TRACKS[] = {track(VAULT_OPEN_CUES), track(SUCCESS_MELODY)};
+static const Timeline VAULT_OPEN_SCENE = timeline(VAULT_OPEN_TRACKS, SUCCESS_MELODY_MS + GAME1_COMPLETE_DISPLAY_TIME);
 
-// Game State Definitions
+// All at once: the game ends in the same frame.
+static const Cue TIME_UP_CUES[] = {
+    textCue(0, "Time is up!", "Vault locked!"),
+    toneCue(0, TONE_TIME_UP_FREQUENCY, TONE_TIME_UP_DURATION),
+    colorCue(0, 255, 0, 0)};
+static const Track TIME_UP_TRACKS[] = {track(TIME_UP_CUES)};
+static const Timeline TIME_UP_SCENE = timeline(TIME_UP_TRACKS, 0);
+
+void Game1::begin()
+{
+  Game1Data &data = gameArena.begin<Game1Data>();
+  data.stateStart = sessionClock.now();
+  data.scene.play(INTRO_SCENE, data.stateStart);
+  subscribeGameInput(data, EVENT_BIT(EVENT_BUTTON_PRESSED));
+}
+
+void Game1::save(uint8_t *fields)
+{
+  Game1Data &data = gameArena.get<Game1Data>();
+  CheckpointWriter writer(fields);
+  writer.u8(data.gameState == GAME1_PLAY ? 1 : 0);
+  writer.u8(data.currentStep);
+  for (int i = 0; i < NUM_LEVELS; i++)
+  {
+    writer.u16(data.combo[i]);
+  }
+  writer.u32(sessionClock.since(data.game1StartTime));
+}
 
-enum Game1State
+void Game1::resume(const uint8_t *fields)
 {
-  GAME1_INIT,
-  GAME1_PLAY,
-  GAME1_COMPLETE,
-  GAME1_TIME_UP
-};
+  Game1Data &data = gameArena.get<Game1Data>();
+  CheckpointReader reader(fields);
+  if (reader.u8() == 0)
+  {
+    return; // Still in the intro messages; start over.
+  }
+  data.currentStep = reader.u8();
+  for (int i = 0; i < NUM_LEVELS; i++)
+  {
+    data.combo[i] = reader.u16();
+  }
+  data.game1StartTime = sessionClock.now() - reader.u32();
+  data.gameState = GAME1_PLAY;
+  data.stateStart = sessionClock.now();
+  data.scene.stop();
+  rgb.setColor(255, 0, 255);
+}
 
-enum WaitState
+uint8_t Game1::state()
 {
-  WAIT_FOR_CORRECT_VALUE,
-  CONFIRMING
-};
+  return gameArena.get<Game1Data>().gameState;
+}
 
-bool updateGame1()
+bool Game1::update()
 {
-  static Game1State gameState = GAME1_INIT;
-  static unsigned long stateStart = millis();
-  static int currentStep = 0;
-  static int combo[NUM_LEVELS];
-  static bool comboInitialized = false;
-  static int lastPrintedValue = -100;
-  static WaitState waitState = WAIT_FOR_CORRECT_VALUE;
-  static unsigned long confirmStartTime = 0;
-  static unsigned long lastHoverBeepTime = 0;
-  static bool safeOpened = false;
+  // Game state lives in the shared game arena.
+  Game1Data &data = gameArena.get<Game1Data>();
+  Game1State &gameState = data.gameState;
+  unsigned long &stateStart = data.stateStart;
+  int &currentStep = data.currentStep;
+  int (&combo)[NUM_LEVELS] = data.combo;
+  int &lastPrintedValue = data.lastPrintedValue;
+  WaitState &waitState = data.waitState;
+  unsigned long &confirmStartTime = data.confirmStartTime;
+  unsigned long &lastHoverBeepTime = data.lastHoverBeepTime;
   // Record the start time of Game1.
-  static uint32_t game1StartTime = 0;
+  uint32_t &game1StartTime = data.game1StartTime;
+  bool buttonPressed = data.input.takePress();
 
   // Check global timer expiration.
-  uint32_t elapsedGlobal = millis() - globalStartTime;
-  if (elapsedGlobal >= TOTAL_TIME)
+  if (sessionClock.expired())
   {
     if (gameState != GAME1_TIME_UP)
     {
       gameState = GAME1_TIME_UP;
-      stateStart = millis();
-      lcd.lcdShow("Time is up!", "Vault locked!");
-      buzzer.playTone(TONE_TIME_UP_FREQUENCY, TONE_TIME_UP_DURATION);
-      rgb.setColor(255, 0, 0);
+      stateStart = sessionClock.now();
+      data.scene.play(TIME_UP_SCENE, stateStart);
+      data.scene.update(stateStart);
     }
     return true; // End Game1
   }
@@ -103,133 +150,77 @@ bool updateGame1()
   {
   case GAME1_INIT:
   {
-    uint32_t t = millis() - stateStart;
-    static int lastMsgIndex = -1;
-    int msgIndex = -1;
-    if (t < MSG_STAGE0)
-    {
-      msgIndex = 0;
-    }
-    else if (t < MSG_STAGE1)
-    {
-      msgIndex = 1;
-    }
-    else if (t < MSG_STAGE2)
+    if (!data.scene.update(sessionClock.now()))
     {
-      msgIndex = 2;
-    }
-    else if (t < MSG_STAGE3)
-    {
-      msgIndex = 3;
-    }
-    else if (t < MSG_STAGE4)
-    {
-      msgIndex = 4;
-    }
-    else
-    {
-      randomSeed(analogRead(A1));
+      Xoshiro128 &random = rng.stream(1);
       for (int i = 0; i < NUM_LEVELS; i++)
       {
-        combo[i] = random(RANDOM_MIN, RANDOM_MAX) * RANDOM_MULTIPLIER;
+        combo[i] = random.range(GAME1_COMBO_MIN, GAME1_COMBO_MAX) * GAME1_COMBO_STEP;
       }
-      Serial.println("------------------------------------");
-      Serial.println("---------------Game-1---------------");
-      Serial.println("Vault combo generated!");
-      Serial.print("Vault combo: ");
-      Serial.print(combo[0]);
-      Serial.print(" ");
-      Serial.print(combo[1]);
-      Serial.print(" ");
-      Serial.println(combo[2]);
+      telemetry.log(TM_SECTION, "Game-1");
+      telemetry.log(TM_G1_COMBO, combo[0], combo[1], combo[2]);
       rgb.setColor(255, 0, 255);
       currentStep = 0;
       lastPrintedValue = -100;
       waitState = WAIT_FOR_CORRECT_VALUE;
-      comboInitialized = true;
       gameState = GAME1_PLAY;
-      game1StartTime = millis();
-      stateStart = millis();
-      lastMsgIndex = -1;
-      break;
-    }
-
-    if (msgIndex != lastMsgIndex)
-    {
-      lcd.lcdShow(
-          (msgIndex == 0) ? "Welcome: LEVEL 1" : (msgIndex == 1) ? "Escape fast or"
-                                             : (msgIndex == 2)   ? "Listen carefully"
-                                             : (msgIndex == 3)   ? "When found, you"
-                                                                 : "Dont forget to",
-          (msgIndex == 0) ? "Get Ready!" : (msgIndex == 1) ? "rocks hit you"
-                                       : (msgIndex == 2)   ? "find the beep"
-                                       : (msgIndex == 3)   ? "are close!"
-                                                           : "press the button");
-      lastMsgIndex = msgIndex;
+      game1StartTime = sessionClock.now();
+      stateStart = sessionClock.now();
+      requestCheckpoint();
     }
     break;
   }
   case GAME1_PLAY:
   {
-    uint32_t elapsed = millis() - globalStartTime;
-    keyLed.displayTime(elapsed, TOTAL_TIME, currentGamePresses);
-
     // Read potentiometer.
     Potentiometer potentiometer(PIN_POT);
     int potValue = potentiometer.readValue();
-    int currentValue = map(potValue, 0, 1023, 0, 3600);
+    int currentValue = map(potValue, 0, 1023, 0, GAME1_DIAL_RANGE);
     if (abs(currentValue - lastPrintedValue) > PRINT_CHANGE_THRESHOLD)
       lastPrintedValue = currentValue;
 
     // Set thresholds and tone frequencies based on current step.
     int currentLevel = currentStep + 1;
-    int levelThreshold, levelTone;
+    int levelThreshold = game1Threshold(currentLevel, puzzleConfig.number(CFG_GAME1_THRESHOLD, THRESHOLD_LEVEL1),
+                                        puzzleConfig.number(CFG_GAME1_LEVEL2_OFFSET, LEVEL2_THRESHOLD_OFFSET),
+                                        puzzleConfig.number(CFG_GAME1_LEVEL3_OFFSET, LEVEL3_THRESHOLD_OFFSET));
+    int levelTone;
     switch (currentLevel)
     {
-    case 1:
-      levelThreshold = THRESHOLD_LEVEL1;
-      levelTone = TUNE_CORRECT;
-      break;
     case 2:
-      levelThreshold = THRESHOLD_LEVEL1 - LEVEL2_THRESHOLD_OFFSET;
-      levelTone = TUNE_LEVEL2;
+      levelTone = puzzleConfig.number(CFG_GAME1_TONE_LEVEL2, TUNE_LEVEL2);
       break;
     case NUM_LEVELS:
-      levelThreshold = THRESHOLD_LEVEL1 - LEVEL3_THRESHOLD_OFFSET;
-      levelTone = TUNE_LEVEL3;
+      levelTone = puzzleConfig.number(CFG_GAME1_TONE_LEVEL3, TUNE_LEVEL3);
       break;
     default:
-      levelThreshold = THRESHOLD_LEVEL1;
-      levelTone = TUNE_CORRECT;
+      levelTone = puzzleConfig.number(CFG_GAME1_TONE_LEVEL1, TUNE_CORRECT);
       break;
     }
+    int searchTone = puzzleConfig.number(CFG_GAME1_TONE_SEARCH, TUNE_SEARCH);
 
     int target = combo[currentStep];
     int distance = abs(currentValue - target);
 
-    // Tone generation based on distance.
-    if (distance < levelThreshold)
-    {
-      buzzer.playTone(levelTone, TONE_DURATION_SHORT);
-    }
-    else if (distance < levelThreshold + 5)
+    // Tone feedback based on distance, one tone at a time through the
+    // audio queue so the dial keeps being read while it sounds.
+    if (!buzzer.busy())
     {
-      if (millis() - lastHoverBeepTime > HOVER_BEEP_INTERVAL)
+      if (distance < levelThreshold)
       {
-        buzzer.playTone(1000, TONE_DURATION_LONG);
-        lastHoverBeepTime = millis();
+        buzzer.queueTone(levelTone, TONE_DURATION_SHORT);
+      }
+      else if (distance < levelThreshold + 5 && sessionClock.since(lastHoverBeepTime) > HOVER_BEEP_INTERVAL)
+      {
+        buzzer.queueTone(1000, TONE_DURATION_LONG);
+        lastHoverBeepTime = sessionClock.now();
       }
       else
       {
-        int toneFreq = map(distance, 0, 3600, levelTone, TUNE_SEARCH);
-        buzzer.playTone(toneFreq, TONE_DURATION_SHORT);
+        int toneFreq = map(distance, 0, GAME1_DIAL_RANGE, levelTone, searchTone);
+        buzzer.queueTone(toneFreq, TONE_DURATION_SHORT);
       }
     }
-    else
-    {
-      int toneFreq = map(distance, 0, 3600, levelTone, TUNE_SEARCH);
-      buzzer.playTone(toneFreq, TONE_DURATION_SHORT);
-    }
 
     // LED feedback.
     if (distance < levelThreshold)
@@ -245,52 +236,45 @@ bool updateGame1()
     }
 
     // Process button input.
-    bool buttonPressed = button.isPressed();
     if (buttonPressed)
     {
-      Serial.print("Button pressed with value: ");
-      Serial.println(currentValue);
+      telemetry.log(TM_G1_PRESS, currentValue);
     }
     if (waitState == WAIT_FOR_CORRECT_VALUE)
     {
       if (distance < levelThreshold && buttonPressed)
       {
-        confirmStartTime = millis();
+        confirmStartTime = sessionClock.now();
         waitState = CONFIRMING;
       }
     }
     else if (waitState == CONFIRMING)
     {
-      if (distance >= CONFIRMATION_THRESHOLD)
+      if (distance >= puzzleConfig.number(CFG_GAME1_CONFIRM_THRESHOLD, CONFIRMATION_THRESHOLD))
         waitState = WAIT_FOR_CORRECT_VALUE;
-      else if (millis() - confirmStartTime >= CONFIRMATION_DELAY_MS)
+      else if (sessionClock.since(confirmStartTime) >= (uint32_t)puzzleConfig.number(CFG_GAME1_CONFIRM_MS, CONFIRMATION_DELAY_MS))
       {
         currentStep++;
-        Serial.print("Step ");
-        Serial.print(currentStep);
-        Serial.println(" confirmed!");
+        requestCheckpoint();
+        telemetry.log(TM_G1_STEP, currentStep);
         if (currentStep < NUM_LEVELS)
         {
           char stepMsg[17];
-          sprintf(stepMsg, "STEP %d OF %d DONE", currentStep, NUM_LEVELS);
+          Formatter(stepMsg, sizeof(stepMsg)).text("STEP ").number(currentStep).text(" OF ").number(NUM_LEVELS).text(" DONE");
           lcd.lcdShow(stepMsg, "KEEP GOING");
         }
         else
         {
-          lcd.lcdShow("Vault opened!", "Congrats!");
-          Serial.println("Vault opened!");
+          telemetry.log(TM_G1_OPENED);
           keyLed.printTimeUsed(game1StartTime);
-          Serial.println("Button presses: " + String(currentGamePresses));
-          unsigned long timeTaken = millis() - game1StartTime;
+          telemetry.log(TM_BUTTON_PRESSES, currentGamePresses);
+          unsigned long timeTaken = sessionClock.since(game1StartTime);
           Score game1Score(1, currentGamePresses, timeTaken);
-          game1FinalScore = game1Score.points;
-          Serial.print("Game 1 Score: ");
-          Serial.println(game1Score.points);
-          rgb.setColor(0, 255, 0);
-          buzzer.playSuccessMelody();
-          safeOpened = true;
+          game1Score.publish();
+          telemetry.log(TM_GAME_SCORE, 1, game1Score.points);
           gameState = GAME1_COMPLETE;
-          stateStart = millis();
+          stateStart = sessionClock.now();
+          data.scene.play(VAULT_OPEN_SCENE, stateStart);
         }
         waitState = WAIT_FOR_CORRECT_VALUE;
         lastPrintedValue = -100;
@@ -300,7 +284,7 @@ bool updateGame1()
   }
   case GAME1_COMPLETE:
   {
-    if (millis() - stateStart > GAME_COMPLETE_DISPLAY_TIME)
+    if (!data.scene.update(sessionClock.now()))
       return true;
     break;
   }
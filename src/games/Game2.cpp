@@ -9,6 +9,16 @@
 #include "pins.h"
 #include "Score.h"
 #include "Globals.h"
+#include "GameArena.h"
+#include "SessionClock.h"
+#include "Format.h"
+#include "Checkpoint.h"
+#include "Telemetry.h"
+#include "Analytics.h"
+#include "GameRules.h"
+#include "PuzzleConfig.h"
+#include "Content.h"
+#include <string.h>
 
 // Declare global objects from main.cpp.
 extern LCD lcd;
@@ -17,27 +27,19 @@ extern RGBLed rgb;
 extern Buzzer buzzer;
 extern Button button;
 
-// Use the global timer defined in main.cpp.
-extern uint32_t globalStartTime;
-extern const uint32_t TOTAL_TIME;
 extern int currentGamePresses;
-extern int game2FinalScore;
 
 //-----------------------
 // Constant Definitions
 //-----------------------
 
 // Game parameters
-const int MELODY_LENGTH = 8;
+const uint8_t GAME2_ID = 2;
 const int KEY_DEBOUNCE_DELAY = 150;
 const unsigned long BUTTON_DEBOUNCE_DELAY = 50; // Unused but defined
 
-// Time durations (in milliseconds)
-const unsigned long GAME2_INIT_DURATION = 2000;
+// Time durations (in milliseconds; scene lengths are in GameRules.h)
 const unsigned long TONE_NOTE_DURATION = 200;
-const unsigned long GAME2_WRONG_DURATION = 1000;
-const unsigned long GAME2_COMPLETE_DURATION = 2000;
-const unsigned long PENALTY_TIME_INCREMENT = 30000;
 
 // Color definitions
 const int COLOR_BLUE_R = 0;
@@ -52,87 +54,131 @@ const int COLOR_GREEN_R = 0;
 const int COLOR_GREEN_G = 255;
 const int COLOR_GREEN_B = 0;
 
-// Melody and Tips
+// Melody and Tips (content/pack.json)
 //-----------------------
-String targetMelody = "48215637";
+static const char *const TARGET_MELODY = contentText(CONTENT_GAME2_MELODY);
+static_assert(sizeof(CONTENT_GAME2_TIPS) / sizeof(CONTENT_GAME2_TIPS[0]) == MELODY_LENGTH, "One tip per note");
 
-String tips[MELODY_LENGTH] = {
-    "A quartet awaits",
-    "Infinite curve",
-    "A pair in tune",
-    "The lone melody",
-    "Middle of magic",
-    "Sixth sense",
-    "Triple allure",
-    "Lucky final touch"};
+// The puzzle config's melody when it is MELODY_LENGTH key digits, and its
+// tips where it has them; the compiled ones otherwise.
+static const char *targetMelody()
+{
+  const char *melody = puzzleConfig.text(CFG_GAME2_MELODY, TARGET_MELODY);
+  if (strlen(melody) != MELODY_LENGTH)
+    return TARGET_MELODY;
+  for (int i = 0; i < MELODY_LENGTH; i++)
+  {
+    if (melody[i] < '1' || melody[i] > '0' + MELODY_LENGTH)
+      return TARGET_MELODY;
+  }
+  return melody;
+}
+
+static const char *tipFor(int note)
+{
+  return puzzleConfig.item(CFG_GAME2_TIPS, note, contentText(CONTENT_GAME2_TIPS[note]));
+}
+
+// Scenes
+static const Cue INTRO_CUES[] = {
+    textCue(0, "Welcome: LEVEL 2", "Find the tune!"),
+    colorCue(0, COLOR_BLUE_R, COLOR_BLUE_G, COLOR_BLUE_B)};
+static const Track INTRO_TRACKS[] = {track(INTRO_CUES)};
+static const Timeline INTRO_SCENE = timeline(INTRO_TRACKS, GAME2_INIT_DURATION);
+
+static const Cue CORRECT_CUES[] = {
+    textCue(0, "Correct Tune!", "Well done!"),
+    colorCue(0, COLOR_GREEN_R, COLOR_GREEN_G, COLOR_GREEN_B)};
+static const Track CORRECT_TRACKS[] = {track(CORRECT_CUES), track(SUCCESS_MELODY)};
+static const Timeline CORRECT_SCENE = timeline(CORRECT_TRACKS, SUCCESS_MELODY_MS + GAME2_COMPLETE_DURATION);
+
+static const Cue WRONG_CUES[] = {
+    textCue(0, "Wrong Tune!", "Try again!"),
+    colorCue(0, COLOR_RED_R, COLOR_RED_G, COLOR_RED_B)};
+static const Track WRONG_TRACKS[] = {track(WRONG_CUES), track(ERROR_TONE)};
+static const Timeline WRONG_SCENE = timeline(WRONG_TRACKS, GAME2_WRONG_DURATION);
 
 char keyDigits[MELODY_LENGTH] = {'1', '2', '3', '4', '5', '6', '7', '8'};
 int noteFrequencies[MELODY_LENGTH] = {261, 293, 329, 349, 392, 440, 493, 523};
 
-// Game State Definitions
-enum Game2State
+void Game2::begin()
+{
+  Game2Data &data = gameArena.begin<Game2Data>();
+  data.stateStart = sessionClock.now();
+  data.scene.play(INTRO_SCENE, data.stateStart);
+  subscribeGameInput(data, EVENT_BIT(EVENT_BUTTON_PRESSED) | EVENT_BIT(EVENT_KEYS_CHANGED));
+}
+
+void Game2::save(uint8_t *fields)
 {
-  GAME2_INIT,
-  GAME2_PLAY,
-  GAME2_WRONG,
-  GAME2_COMPLETE,
-  GAME2_TIME_UP
-};
+  Game2Data &data = gameArena.get<Game2Data>();
+  CheckpointWriter writer(fields);
+  writer.u8(data.gameState == GAME2_INIT ? 0 : 1);
+  writer.u8(data.attemptCount);
+  writer.u32(sessionClock.since(data.game2StartTime));
+}
 
-bool updateGame2()
+void Game2::resume(const uint8_t *fields)
 {
-  static Game2State gameState = GAME2_INIT;
-  static unsigned long stateStart = millis();
-  static int attemptCount = 0;
-  static unsigned long penaltyTime = 0; // Accumulate penalty time here
-  static String userInput = "";
-  static unsigned long lastKeyPressTime = 0;
-  static uint8_t lastButtons = 0;
+  Game2Data &data = gameArena.get<Game2Data>();
+  CheckpointReader reader(fields);
+  if (reader.u8() == 0)
+  {
+    return;
+  }
+  data.attemptCount = reader.u8();
+  data.game2StartTime = sessionClock.now() - reader.u32();
+  data.gameState = GAME2_PLAY;
+  data.stateStart = sessionClock.now();
+  data.scene.stop();
+  rgb.setColor(COLOR_BLUE_R, COLOR_BLUE_G, COLOR_BLUE_B);
+  lcd.lcdShow("Tip for note 1", FixedString<16>(tipFor(0)).c_str());
+}
+
+uint8_t Game2::state()
+{
+  return gameArena.get<Game2Data>().gameState;
+}
+
+bool Game2::update()
+{
+  // Game state lives in the shared game arena.
+  Game2Data &data = gameArena.get<Game2Data>();
+  Game2State &gameState = data.gameState;
+  unsigned long &stateStart = data.stateStart;
+  int &attemptCount = data.attemptCount;
+  FixedString<16> &userInput = data.userInput;
+  unsigned long &lastKeyPressTime = data.lastKeyPressTime;
+  uint8_t &lastButtons = data.lastButtons;
   // Record the start time of Game 2.
-  static uint32_t game2StartTime = 0;
+  uint32_t &game2StartTime = data.game2StartTime;
+  bool buttonPressed = data.input.takePress();
 
   switch (gameState)
   {
   case GAME2_INIT:
   {
-    uint32_t t = millis() - stateStart;
-    static int lastMsgIndex = -1;
-    int msgIndex = -1;
-    if (t < GAME2_INIT_DURATION)
-    {
-      msgIndex = 0;
-      if (msgIndex != lastMsgIndex)
-      {
-        lcd.lcdShow("Welcome: LEVEL 2", "Find the tune!");
-        rgb.setColor(COLOR_BLUE_R, COLOR_BLUE_G, COLOR_BLUE_B);
-        lastMsgIndex = msgIndex;
-      }
-    }
-    else
+    if (!data.scene.update(sessionClock.now()))
     {
       // After init duration, display the first tip.
       char tipHeader[17];
-      sprintf(tipHeader, "Tip for note %d", 1);
-      lcd.lcdShow(tipHeader, tips[0].substring(0, 16).c_str());
-      Serial.println("------------------------------------");
-      Serial.println("---------------Game-2---------------");
-      Serial.println("Melody generated!");
-      Serial.print("Melody: ");
-      Serial.println(targetMelody);
+      Formatter(tipHeader, sizeof(tipHeader)).text("Tip for note ").number(1);
+      lcd.lcdShow(tipHeader, FixedString<16>(tipFor(0)).c_str());
+      telemetry.log(TM_SECTION, "Game-2");
+      telemetry.log(TM_G2_MELODY, targetMelody());
       // Set the start time for Game 2.
-      game2StartTime = millis();
+      game2StartTime = sessionClock.now();
       gameState = GAME2_PLAY;
-      stateStart = millis();
-      lastMsgIndex = -1;
-      break;
+      stateStart = sessionClock.now();
+      requestCheckpoint();
     }
     break;
   }
   case GAME2_PLAY:
   {
-    static bool finalMessageDisplayed = false;
-    static String lastTip = "";
-    uint8_t keys = keyLed.readButtons();
+    bool &finalMessageDisplayed = data.finalMessageDisplayed;
+    FixedString<16> &lastTip = data.lastTip;
+    uint8_t keys = data.input.keys;
     int pressedCount = 0;
     int pressedIndex = -1;
     for (int i = 0; i < MELODY_LENGTH; i++)
@@ -152,19 +198,18 @@ bool updateGame2()
     }
 
     if (pressedCount == 1 &&
-        (millis() - lastKeyPressTime > KEY_DEBOUNCE_DELAY) &&
+        (sessionClock.since(lastKeyPressTime) > KEY_DEBOUNCE_DELAY) &&
         ((lastButtons & (1 << pressedIndex)) == 0))
     {
-      userInput += keyDigits[pressedIndex];
-      buzzer.playTone(noteFrequencies[pressedIndex], TONE_NOTE_DURATION);
-      lastKeyPressTime = millis();
+      userInput.append(keyDigits[pressedIndex]);
+      buzzer.queueTone(noteFrequencies[pressedIndex], TONE_NOTE_DURATION);
+      lastKeyPressTime = sessionClock.now();
       char tipHeader[17];
-      sprintf(tipHeader, "Tip for note %d", (int)userInput.length() + 1);
+      Formatter(tipHeader, sizeof(tipHeader)).text("Tip for note ").number(userInput.length() + 1);
       if (userInput.length() < MELODY_LENGTH)
       {
-        String tip = tips[userInput.length()];
-        if (tip.length() > 16)
-          tip = tip.substring(0, 16);
+        // Tips longer than the LCD line are cut to 16 characters.
+        FixedString<16> tip(tipFor(userInput.length()));
         if (tip != lastTip)
         {
           lcd.lcdShow(tipHeader, tip.c_str());
@@ -179,86 +224,70 @@ bool updateGame2()
     }
     lastButtons = keys;
 
-    if (button.isPressed() && userInput.length() > 0)
+    if (buttonPressed && userInput.length() > 0)
     {
       // Debug: print current user input.
-      Serial.print("User submitted melody: ");
-      Serial.println(userInput);
+      telemetry.log(TM_G2_SUBMIT, userInput.c_str());
 
       int correctCount = 0;
-      for (int i = 0; i < userInput.length() && i < targetMelody.length(); i++)
+      for (int i = 0; i < userInput.length() && i < MELODY_LENGTH; i++)
       {
-        if (userInput.charAt(i) == targetMelody.charAt(i))
+        if (userInput[i] == targetMelody()[i])
           correctCount++;
         else
           break;
       }
 
-      if (userInput.equals(targetMelody))
+      if (userInput.equals(targetMelody()))
       {
-        Serial.print("Try number ");
-        Serial.print(attemptCount + 1);
-        Serial.println(": melody correct");
+        telemetry.log(TM_G2_CORRECT, attemptCount + 1);
         //keyLed.printTimeUsed(game2StartTime);
-        Serial.print("Button presses: ");
-        Serial.println(currentGamePresses);
+        telemetry.log(TM_BUTTON_PRESSES, currentGamePresses);
 
-        // Compute effective time as elapsed time plus the accumulated penalty.
-        unsigned long effectiveTime = (millis() - game2StartTime) + penaltyTime;
+        // Compute effective time as elapsed time plus the penalties charged to this game.
+        unsigned long effectiveTime = sessionClock.since(game2StartTime) + sessionClock.adjustmentFor(GAME2_ID);
 
         unsigned long totalSeconds = effectiveTime / 1000;
         unsigned long minutes = totalSeconds / 60;
         unsigned long seconds = totalSeconds % 60;
-        Serial.print("Time used: ");
-        Serial.print(minutes);
-        Serial.print("m and ");
-        Serial.print(seconds);
-        Serial.println("s");
+        telemetry.log(TM_TIME_USED, minutes, seconds);
 
-        lcd.lcdShow("Correct Tune!", "Well done!");
-        Score game2Score(2, currentGamePresses, effectiveTime);
-        game2FinalScore = game2Score.points;
-        Serial.print("Game 2 Score: ");
-        Serial.println(game2Score.points);
-        rgb.setColor(COLOR_GREEN_R, COLOR_GREEN_G, COLOR_GREEN_B);
-        buzzer.playSuccessMelody();
+        Score game2Score(GAME2_ID, currentGamePresses, effectiveTime);
+        game2Score.publish();
+        telemetry.log(TM_GAME_SCORE, GAME2_ID, game2Score.points);
         gameState = GAME2_COMPLETE;
-        stateStart = millis();
+        stateStart = sessionClock.now();
+        data.scene.play(CORRECT_SCENE, stateStart);
       }
       else
       {
         attemptCount++;
-        penaltyTime += PENALTY_TIME_INCREMENT;
-        globalStartTime -= PENALTY_TIME_INCREMENT;
-        Serial.print("Try number ");
-        Serial.print(attemptCount);
-        Serial.print(": ");
-        Serial.print(correctCount);
-        Serial.println(" correct");
-        lcd.lcdShow("Wrong Tune!", "Try again!");
-        rgb.setColor(COLOR_RED_R, COLOR_RED_G, COLOR_RED_B);
-        buzzer.playErrorTone();
+        sessionClock.addPenalty(GAME2_ID, puzzleConfig.number(CFG_GAME2_PENALTY_MS, PENALTY_TIME_INCREMENT));
+        requestCheckpoint();
+        telemetry.log(TM_G2_WRONG, attemptCount, correctCount);
+        analytics.recordAttempt(GAME2_ID);
         gameState = GAME2_WRONG;
-        stateStart = millis();
+        stateStart = sessionClock.now();
+        data.scene.play(WRONG_SCENE, stateStart);
       }
     }
     break;
   }
   case GAME2_WRONG:
   {
-    if (millis() - stateStart >= GAME2_WRONG_DURATION)
+    if (!data.scene.update(sessionClock.now()))
     {
       rgb.setColor(COLOR_BLUE_R, COLOR_BLUE_G, COLOR_BLUE_B);
-      userInput = "";
-      lcd.lcdShow("Tip for note 1", tips[0].substring(0, 16).c_str());
+      userInput.clear();
+      lcd.lcdShow("Tip for note 1", FixedString<16>(tipFor(0)).c_str());
       gameState = GAME2_PLAY;
-      stateStart = millis();
+      stateStart = sessionClock.now();
     }
     break;
   }
   case GAME2_COMPLETE:
   {
-    if (millis() - stateStart > GAME2_COMPLETE_DURATION)
+    if (!data.scene.update(sessionClock.now()))
       return true;
     break;
   }
@@ -9,60 +9,103 @@
 #include "pins.h"
 #include "Score.h"
 #include "Globals.h"
+#include "GameArena.h"
+#include "SessionClock.h"
+#include "Format.h"
+#include "Random.h"
+#include "Checkpoint.h"
+#include "Telemetry.h"
+#include "Analytics.h"
+#include "Trace.h"
+#include "GameRules.h"
+#include "PuzzleConfig.h"
 
 // Constant Definitions
 
-// Durations (in milliseconds)
-const unsigned long GAME3_INIT_PHASE1_DURATION = 2000;
-const unsigned long GAME3_INIT_PHASE2_DURATION = 4000;
-const unsigned long GAME3_INIT_PHASE3_DURATION = 6000;
-const unsigned long GAME3_SHOW_COLOR_PHASE1_DURATION = 2000;
-const unsigned long GAME3_SHOW_COLOR_PHASE2_DURATION = 4000;
-const unsigned long GAME3_DEBOUNCE_DELAY = 200;
+// Durations (in milliseconds; the tuned ones are in GameRules.h)
 const unsigned long GAME3_LCD_UPDATE_INTERVAL = 500;
 const unsigned long GAME3_SUCCESS_PHASE_INTERVAL = 2000;
-const unsigned long GAME3_SUCCESS_DISPLAY_DURATION = 6000;
-const unsigned long GAME3_FAIL_DURATION = 2000;
 
-// Color tolerance for validation
-const int GAME3_COLOR_TOLERANCE = 15;
+// Scenes
+static const Cue LEVEL_UP_CUES[] = {
+    textCue(0, "Good job!", "Next Level..."),
+    colorCue(0, 0, 224, 0)};
+static const Track LEVEL_UP_TRACKS[] = {track(LEVEL_UP_CUES), track(SUCCESS_MELODY)};
+static const Timeline LEVEL_UP_SCENE = timeline(LEVEL_UP_TRACKS, SUCCESS_MELODY_MS + GAME3_LEVEL_UP_DURATION);
 
-// Potentiometer mapping constants
-const int GAME3_POT_MAX_STEP = 9;
-const int GAME3_DISCRETE_VALUE_MULTIPLIER = 32;
+static const Cue FINAL_CUES[] = {
+    textCue(0, "Final Level", "Complete!"),
+    colorCue(0, 0, 224, 0)};
+static const Track FINAL_TRACKS[] = {track(FINAL_CUES), track(SUCCESS_MELODY)};
+static const Timeline FINAL_SCENE = timeline(FINAL_TRACKS, SUCCESS_MELODY_MS + GAME3_SUCCESS_DISPLAY_DURATION);
 
-// Define game states.
-enum Game3State
+static const Cue FAIL_CUES[] = {
+    textCue(0, "Wrong color!", "Restarting..."),
+    colorCue(0, 224, 0, 0)};
+static const Track FAIL_TRACKS[] = {track(FAIL_CUES), track(ERROR_TONE)};
+static const Timeline FAIL_SCENE = timeline(FAIL_TRACKS, GAME3_FAIL_DURATION);
+
+void Game3::begin()
+{
+    Game3Data &data = gameArena.begin<Game3Data>();
+    data.stateStart = sessionClock.now();
+    subscribeGameInput(data, EVENT_BIT(EVENT_BUTTON_PRESSED) | EVENT_BIT(EVENT_KEYS_CHANGED));
+}
+
+void Game3::save(uint8_t *fields)
+{
+    Game3Data &data = gameArena.get<Game3Data>();
+    CheckpointWriter writer(fields);
+    writer.u8(data.game3StartTime == 0 ? 0 : 1);
+    writer.u8(data.currentLevel);
+    writer.u32(sessionClock.since(data.game3StartTime));
+}
+
+void Game3::resume(const uint8_t *fields)
+{
+    Game3Data &data = gameArena.get<Game3Data>();
+    CheckpointReader reader(fields);
+    if (reader.u8() == 0)
+    {
+        return;
+    }
+    data.currentLevel = reader.u8();
+    data.game3StartTime = sessionClock.now() - reader.u32();
+    // Show a fresh target for the saved level.
+    rgb.getRandomColor(rng.stream(3), data.currentLevel, data.targetRed, data.targetGreen, data.targetBlue);
+    data.gameState = GAME3_SHOW_COLOR;
+    data.stateStart = sessionClock.now();
+}
+
+uint8_t Game3::state()
 {
-    GAME3_INIT,
-    GAME3_SHOW_COLOR,
-    GAME3_USER_GUESS,
-    GAME3_VALIDATE,
-    GAME3_SUCCESS,
-    GAME3_FAIL
-};
+    return gameArena.get<Game3Data>().gameState;
+}
 
-bool updateGame3()
+bool Game3::update()
 {
-    static uint32_t game3StartTime = 0;
-    static int currentLevel = 1;
+    // Game state lives in the shared game arena.
+    Game3Data &data = gameArena.get<Game3Data>();
+    uint32_t &game3StartTime = data.game3StartTime;
+    int &currentLevel = data.currentLevel;
 
-    static Game3State gameState = GAME3_INIT;
-    static unsigned long stateStart = millis();
+    Game3State &gameState = data.gameState;
+    unsigned long &stateStart = data.stateStart;
 
     // Target and guess color components.
-    static int targetRed = 0, targetGreen = 0, targetBlue = 0;
-    static int guessRed = 0, guessGreen = 0, guessBlue = 0;
+    int &targetRed = data.targetRed, &targetGreen = data.targetGreen, &targetBlue = data.targetBlue;
+    int &guessRed = data.guessRed, &guessGreen = data.guessGreen, &guessBlue = data.guessBlue;
     // Active channel: 0 = Red, 1 = Green, 2 = Blue.
-    static int currentChannel = 0;
+    int &currentChannel = data.currentChannel;
+    bool buttonPressed = data.input.takePress();
 
-    unsigned long elapsed = millis() - stateStart;
+    unsigned long elapsed = sessionClock.since(stateStart);
 
     switch (gameState)
     {
     case GAME3_INIT:
     {
-        static int lastMsgIndex = -1;
+        int &lastMsgIndex = data.initMsgIndex;
         int msgIndex = -1;
         if (elapsed < GAME3_INIT_PHASE1_DURATION)
         {
@@ -105,37 +148,33 @@ bool updateGame3()
             // Set game3StartTime only once at the start of the game.
             if (game3StartTime == 0)
             {
-                game3StartTime = millis();
+                game3StartTime = sessionClock.now();
             }
             // Generate target color for currentLevel.
-            rgb.getRandomColor(currentLevel, targetRed, targetGreen, targetBlue);
-            {
-                char dbg[50];
-                Serial.println("------------------------------------");
-                Serial.println("---------------Game-3---------------");
-                Serial.print("Generating color for Level ");
-                Serial.println(currentLevel);
-                sprintf(dbg, "Color to match: R:%03d G:%03d B:%03d", targetRed, targetGreen, targetBlue);
-                Serial.println(dbg);
-            }
+            rgb.getRandomColor(rng.stream(3), currentLevel, targetRed, targetGreen, targetBlue);
+            telemetry.log(TM_SECTION, "Game-3");
+            telemetry.log(TM_G3_LEVEL, currentLevel, targetRed, targetGreen, targetBlue);
             // Reset user's guess.
             guessRed = 0;
             guessGreen = 0;
             guessBlue = 0;
             currentChannel = 0;
-            stateStart = millis();
+            stateStart = sessionClock.now();
             gameState = GAME3_SHOW_COLOR;
             lastMsgIndex = -1;
+            requestCheckpoint();
         }
         break;
     }
     case GAME3_SHOW_COLOR:
     {
-        static int lastMsgIndex = -1;
+        int &lastMsgIndex = data.showMsgIndex;
         int msgIndex = -1;
+        uint32_t hintMs = puzzleConfig.number(CFG_GAME3_SHOW_HINT_MS, GAME3_SHOW_COLOR_PHASE1_DURATION);
+        uint32_t showMs = puzzleConfig.number(CFG_GAME3_SHOW_MS, GAME3_SHOW_COLOR_PHASE2_DURATION);
         // Display target color.
         rgb.setColor(targetRed, targetGreen, targetBlue);
-        if (elapsed < GAME3_SHOW_COLOR_PHASE1_DURATION)
+        if (elapsed < hintMs)
         {
             msgIndex = 0;
             if (msgIndex != lastMsgIndex)
@@ -144,7 +183,7 @@ bool updateGame3()
                 lastMsgIndex = msgIndex;
             }
         }
-        else if (elapsed < GAME3_SHOW_COLOR_PHASE2_DURATION)
+        else if (elapsed < showMs)
         {
             msgIndex = 1;
             if (msgIndex != lastMsgIndex)
@@ -153,48 +192,49 @@ bool updateGame3()
                 lastMsgIndex = msgIndex;
             }
         }
-        if (button.isPressed() || elapsed >= GAME3_SHOW_COLOR_PHASE2_DURATION)
+        if (buttonPressed || elapsed >= showMs)
         {
             // Hide the target color.
             rgb.setColor(0, 0, 0);
-            stateStart = millis();
+            stateStart = sessionClock.now();
             gameState = GAME3_USER_GUESS;
             lastMsgIndex = -1;
             // DO NOT reset game3StartTime here.
-            delay(GAME3_DEBOUNCE_DELAY); // Debounce delay.
+            TRACED_DELAY(GAME3_DEBOUNCE_DELAY); // Debounce delay.
         }
         break;
     }
     case GAME3_USER_GUESS:
     {
         // Process key input for channel selection and reset.
-        uint8_t keys = keyLed.readButtons();
+        uint8_t keys = data.input.keys;
         if (keys & 0x80)
         { // Reset guess.
             guessRed = 0;
             guessGreen = 0;
             guessBlue = 0;
             currentChannel = 0;
-            delay(GAME3_DEBOUNCE_DELAY);
+            TRACED_DELAY(GAME3_DEBOUNCE_DELAY);
         }
         else if (keys & 0x01)
         { // Key 1 selects Red.
             currentChannel = 0;
-            delay(GAME3_DEBOUNCE_DELAY);
+            TRACED_DELAY(GAME3_DEBOUNCE_DELAY);
         }
         else if (keys & 0x02)
         { // Key 2 selects Green.
             currentChannel = 1;
-            delay(GAME3_DEBOUNCE_DELAY);
+            TRACED_DELAY(GAME3_DEBOUNCE_DELAY);
         }
         else if (keys & 0x04)
         { // Key 3 selects Blue.
             currentChannel = 2;
-            delay(GAME3_DEBOUNCE_DELAY);
+            TRACED_DELAY(GAME3_DEBOUNCE_DELAY);
         }
 
         // Read potentiometer and update the active channel.
-        int potValue = analogRead(PIN_POT);
+        Potentiometer potentiometer(PIN_POT);
+        int potValue = potentiometer.readValue();
         int step = map(potValue, 0, 1023, 0, GAME3_POT_MAX_STEP);
         int discreteValue = step * GAME3_DISCRETE_VALUE_MULTIPLIER;
         if (currentChannel == 0)
@@ -208,117 +248,102 @@ bool updateGame3()
         rgb.setColor(guessRed, guessGreen, guessBlue);
 
         // Update the LCD every GAME3_LCD_UPDATE_INTERVAL.
-        static unsigned long lastDisplayUpdate = 0;
-        if (millis() - lastDisplayUpdate >= GAME3_LCD_UPDATE_INTERVAL)
+        unsigned long &lastDisplayUpdate = data.lastDisplayUpdate;
+        if (sessionClock.since(lastDisplayUpdate) >= GAME3_LCD_UPDATE_INTERVAL)
         {
             char newLine0[17];
             char newLine1[17];
-            sprintf(newLine0, "Lv:%d R:%03d", currentLevel, guessRed);
-            sprintf(newLine1, "G:%03d B:%03d", guessGreen, guessBlue);
-            static char lastLine0[17] = "";
-            static char lastLine1[17] = "";
+            Formatter(newLine0, sizeof(newLine0)).text("Lv:").number(currentLevel).text(" R:").number(guessRed, PAD3);
+            Formatter(newLine1, sizeof(newLine1)).text("G:").number(guessGreen, PAD3).text(" B:").number(guessBlue, PAD3);
+            char (&lastLine0)[17] = data.lastLine0;
+            char (&lastLine1)[17] = data.lastLine1;
             if (strcmp(newLine0, lastLine0) != 0 || strcmp(newLine1, lastLine1) != 0)
             {
                 lcd.lcdShow(newLine0, newLine1);
                 strcpy(lastLine0, newLine0);
                 strcpy(lastLine1, newLine1);
             }
-            lastDisplayUpdate = millis();
+            lastDisplayUpdate = sessionClock.now();
         }
 
-        if (button.isPressed())
+        if (buttonPressed)
         {
-            Serial.println("User submitted guess.");
+            telemetry.log(TM_G3_SUBMIT);
             gameState = GAME3_VALIDATE;
-            delay(GAME3_DEBOUNCE_DELAY);
+            TRACED_DELAY(GAME3_DEBOUNCE_DELAY);
         }
         break;
     }
     case GAME3_VALIDATE:
     {
-        char dbg[50];
-        sprintf(dbg, "Guess: R:%03d G:%03d B:%03d", guessRed, guessGreen, guessBlue);
-        Serial.println(dbg);
+        telemetry.log(TM_G3_GUESS, guessRed, guessGreen, guessBlue);
 
-        bool redOk = abs(guessRed - targetRed) <= GAME3_COLOR_TOLERANCE;
-        bool greenOk = abs(guessGreen - targetGreen) <= GAME3_COLOR_TOLERANCE;
-        bool blueOk = abs(guessBlue - targetBlue) <= GAME3_COLOR_TOLERANCE;
+        int tolerance = puzzleConfig.number(CFG_GAME3_TOLERANCE, GAME3_COLOR_TOLERANCE);
+        bool redOk = game3ChannelMatches(guessRed, targetRed, tolerance);
+        bool greenOk = game3ChannelMatches(guessGreen, targetGreen, tolerance);
+        bool blueOk = game3ChannelMatches(guessBlue, targetBlue, tolerance);
 
         if (redOk && greenOk && blueOk)
         {
-            Serial.println("Correct color!");
+            telemetry.log(TM_G3_CORRECT);
             gameState = GAME3_SUCCESS;
         }
         else
         {
-            Serial.println("Wrong color. Resetting to Level 1.");
-            // Set LED to red for a wrong guess.
-            rgb.setColor(224, 0, 0);
+            telemetry.log(TM_G3_WRONG);
             gameState = GAME3_FAIL;
-            stateStart = millis();
-            buzzer.playErrorTone();
+            stateStart = sessionClock.now();
+            data.scene.play(FAIL_SCENE, stateStart);
         }
         break;
     }
     case GAME3_SUCCESS:
     {
         // Calculate elapsed time for the current success phase.
-        unsigned long successElapsed = millis() - stateStart;
+        unsigned long successElapsed = sessionClock.since(stateStart);
 
-        if (currentLevel < 3)
+        if (currentLevel < GAME3_LEVELS)
         {
             if (successElapsed >= GAME3_SUCCESS_DISPLAY_DURATION)
             {
-                Serial.print("Level ");
-                Serial.print(currentLevel);
-                Serial.println(" complete. Advancing to next level.");
-                lcd.lcdShow("Good job!", "Next Level...");
-                rgb.setColor(0, 224, 0); // Green LED for correct guess.
-                buzzer.playSuccessMelody();
-                delay(1000);
+                telemetry.log(TM_G3_LEVEL_DONE, currentLevel);
                 // Advance level.
                 currentLevel++;
-                rgb.getRandomColor(currentLevel, targetRed, targetGreen, targetBlue);
-                {
-                    char dbg[50];
-                    sprintf(dbg, "New target for Level %d: R:%03d G:%03d B:%03d", currentLevel, targetRed, targetGreen, targetBlue);
-                    Serial.println(dbg);
-                }
+                requestCheckpoint();
+                rgb.getRandomColor(rng.stream(3), currentLevel, targetRed, targetGreen, targetBlue);
+                telemetry.log(TM_G3_TARGET, currentLevel, targetRed, targetGreen, targetBlue);
                 // Reset user's guess.
                 guessRed = 0;
                 guessGreen = 0;
                 guessBlue = 0;
                 currentChannel = 0;
-                stateStart = millis();
-                gameState = GAME3_SHOW_COLOR;
+                stateStart = sessionClock.now();
+                gameState = GAME3_LEVEL_UP;
+                data.scene.play(LEVEL_UP_SCENE, stateStart);
             }
         }
         else // currentLevel == 3, final level.
         {
-            static bool finalMessageShown = false;
+            bool &finalMessageShown = data.finalMessageShown;
             if (!finalMessageShown)
             {
                 if (successElapsed >= GAME3_SUCCESS_DISPLAY_DURATION)
                 {
-                    Serial.println("Final level complete. Game over!");
-                    lcd.lcdShow("Final Level", "Complete!");
-                    rgb.setColor(0, 224, 0); // Green LED for success.
-                    Serial.print("Button presses: ");
-                    Serial.println(currentGamePresses);
-                    buzzer.playSuccessMelody();
+                    telemetry.log(TM_FINAL_LEVEL);
+                    telemetry.log(TM_BUTTON_PRESSES, currentGamePresses);
                     keyLed.printTimeUsed(game3StartTime);
-                    unsigned long timeTaken = millis() - game3StartTime;
+                    unsigned long timeTaken = sessionClock.since(game3StartTime);
                     Score game3Score(3, currentGamePresses, timeTaken);
-                    game3FinalScore = game3Score.points;
-                    Serial.print("Game 3 Score: ");
-                    Serial.println(game3Score.points);
+                    game3Score.publish();
+                    telemetry.log(TM_GAME_SCORE, 3, game3Score.points);
                     finalMessageShown = true;
-                    stateStart = millis();  // Reset stateStart to measure final display time.
+                    stateStart = sessionClock.now();
+                    data.scene.play(FINAL_SCENE, stateStart);
                 }
             }
             else
             {
-                if (millis() - stateStart >= GAME3_SUCCESS_DISPLAY_DURATION)
+                if (!data.scene.update(sessionClock.now()))
                 {
                     return true; // End Game 3.
                 }
@@ -326,37 +351,33 @@ bool updateGame3()
         }
         break;
     }
-    case GAME3_FAIL:
+    case GAME3_LEVEL_UP:
     {
-        static int lastMsgIndex = -1;
-        int msgIndex = 0; // Single failure message.
-        if (elapsed < GAME3_FAIL_DURATION)
+        if (!data.scene.update(sessionClock.now()))
         {
-            if (msgIndex != lastMsgIndex)
-            {
-                lcd.lcdShow("Wrong color!", "Restarting...");
-                lastMsgIndex = msgIndex;
-            }
+            stateStart = sessionClock.now();
+            gameState = GAME3_SHOW_COLOR;
         }
-        else
+        break;
+    }
+    case GAME3_FAIL:
+    {
+        if (!data.scene.update(sessionClock.now()))
         {
             // Reset to level 1 after a wrong guess.
             currentLevel = 1;
-            Serial.println("Resetting game to Level 1 after failure.");
-            rgb.getRandomColor(currentLevel, targetRed, targetGreen, targetBlue);
-            {
-                char dbg[50];
-                sprintf(dbg, "New target for Level %d: R:%03d G:%03d B:%03d", currentLevel, targetRed, targetGreen, targetBlue);
-                Serial.println(dbg);
-            }
+            requestCheckpoint();
+            telemetry.log(TM_G3_RESET);
+            analytics.recordAttempt(3);
+            rgb.getRandomColor(rng.stream(3), currentLevel, targetRed, targetGreen, targetBlue);
+            telemetry.log(TM_G3_TARGET, currentLevel, targetRed, targetGreen, targetBlue);
             // Reset user's guess.
             guessRed = 0;
             guessGreen = 0;
             guessBlue = 0;
             currentChannel = 0;
-            stateStart = millis();
+            stateStart = sessionClock.now();
             gameState = GAME3_SHOW_COLOR;
-            lastMsgIndex = -1;
         }
         break;
     }
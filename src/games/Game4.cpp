@@ -9,45 +9,77 @@
 #include "pins.h"
 #include "Score.h"
 #include "Globals.h"
+#include "GameArena.h"
+#include "SessionClock.h"
+#include "Format.h"
+#include "Checkpoint.h"
+#include "Telemetry.h"
+#include "Analytics.h"
+#include "GameRules.h"
+#include "Trace.h"
+#include "PuzzleConfig.h"
+#include "Content.h"
 #include <string.h>
 
-// Structure for a trivia question with 5 options.
-struct TriviaQuestion
+// General knowledge questions, from content/questions.csv.
+static const int NUM_QUESTIONS = CONTENT_QUESTION_COUNT;
+static_assert(NUM_QUESTIONS == GAME4_QUESTION_COUNT, "Update GAME4_QUESTION_COUNT in GameRules.h");
+
+// A configured quiz replaces the compiled one as a whole: its list holds
+// each question followed by its five options, and needs one answer letter
+// per question. Anything else falls back to the compiled questions.
+static int configuredQuestions()
 {
-  const char *question;
-  const char *options[5]; // Options labeled A–E
-  int correctIndex;       // 0-based index: 0=A, 1=B, …, 4=E
-};
+  const char *answers = puzzleConfig.text(CFG_GAME4_ANSWERS, "");
+  int count = strlen(answers);
+  if (count == 0 || puzzleConfig.items(CFG_GAME4_QUESTIONS) != count * 6)
+  {
+    return 0;
+  }
+  for (int q = 0; q < count; q++)
+  {
+    if (answers[q] < 'A' || answers[q] > 'E')
+    {
+      return 0;
+    }
+  }
+  return count;
+}
 
-// Updated general knowledge questions (each 16 chars or less).
-static const TriviaQuestion questions[] = {
-    {"France: Capital",
-     {"Paris", "Berlin", "Madrid", "Rome", "Lisbon"},
-     0},
-    {"Largest planet?",
-     {"Earth", "Mars", "Jupiter", "Saturn", "Neptune"},
-     2},
-    {"Water Boils at?",
-     {"90°C", "100°C", "110°C", "120°C", "80°C"},
-     1},
-    {"Element 'O' is?",
-     {"Gold", "Oxygen", "Silver", "Iron", "Hydrogen"},
-     1},
-    {"Largest ocean?",
-     {"Atlantic", "Indian", "Arctic", "Southern", "Pacific"},
-     4},
-    {"Portugal is in?",
-     {"Africa", "Asia", "S.America", "Europe", "Australia"},
-     3}};
+static int questionCount()
+{
+  int configured = configuredQuestions();
+  return configured > 0 ? configured : NUM_QUESTIONS;
+}
 
-static const int NUM_QUESTIONS = sizeof(questions) / sizeof(questions[0]);
+static const char *questionText(int q)
+{
+  if (configuredQuestions() > 0)
+  {
+    return puzzleConfig.item(CFG_GAME4_QUESTIONS, q * 6, "");
+  }
+  return contentText(CONTENT_QUESTIONS[q].question);
+}
 
-// Timing constants (in milliseconds)
-const unsigned long GAME4_INIT_DURATION = 2000;
-const unsigned long GAME4_FEEDBACK_DURATION = 2000;
-const unsigned long TYPEWRITER_DELAY = 50;
-const unsigned long GAME4_OPTION_UPDATE_INTERVAL = 500;
-const unsigned long WRONG_FEEDBACK_DURATION = 1200;
+static const char *optionText(int q, int option)
+{
+  if (configuredQuestions() > 0)
+  {
+    return puzzleConfig.item(CFG_GAME4_QUESTIONS, q * 6 + 1 + option, "");
+  }
+  return contentText(CONTENT_QUESTIONS[q].options[option]);
+}
+
+static int correctOption(int q)
+{
+  if (configuredQuestions() > 0)
+  {
+    return puzzleConfig.text(CFG_GAME4_ANSWERS, "")[q] - 'A';
+  }
+  return CONTENT_QUESTIONS[q].answer;
+}
+
+// Timing constants are in GameRules.h
 
 // Buzzer tone settings.
 const int TONE_SUCCESS_FREQ = 1200;
@@ -55,49 +87,96 @@ const unsigned long TONE_SUCCESS_DURATION = 100;
 const int TONE_ERROR_FREQ = 400;
 const unsigned long TONE_ERROR_DURATION = 100;
 
-// Game state definitions.
-enum Game4State
+// Scenes
+static const Cue CORRECT_CUES[] = {
+    textCue(0, "Correct!", ""),
+    colorCue(0, 0, 255, 0)};
+static const Track CORRECT_TRACKS[] = {track(CORRECT_CUES), track(SUCCESS_MELODY)};
+static const Timeline CORRECT_SCENE = timeline(CORRECT_TRACKS, SUCCESS_MELODY_MS);
+
+static const Cue WRONG_CUES[] = {
+    textCue(0, "Wrong Answer!", "Try Again..."),
+    colorCue(0, 255, 0, 0),
+    toneCue(0, TONE_ERROR_FREQ, TONE_ERROR_DURATION)};
+static const Track WRONG_TRACKS[] = {track(WRONG_CUES)};
+static const Timeline WRONG_SCENE = timeline(WRONG_TRACKS, WRONG_FEEDBACK_DURATION);
+
+// The final score line is drawn by the game; the scene adds light and sound.
+static const Cue COMPLETE_CUES[] = {
+    colorCue(0, 0, 224, 0)};
+static const Track COMPLETE_TRACKS[] = {track(COMPLETE_CUES), track(SUCCESS_MELODY)};
+static const Timeline COMPLETE_SCENE = timeline(COMPLETE_TRACKS, SUCCESS_MELODY_MS + GAME4_FEEDBACK_DURATION);
+
+void Game4::begin()
 {
-  GAME4_INIT,
-  GAME4_SHOW_QUESTION,
-  GAME4_WAIT_FOR_ANSWER,
-  GAME4_WRONG,
-  GAME4_SUCCESS,
-  GAME4_COMPLETE,
-  GAME4_TIME_UP
-};
+  Game4Data &data = gameArena.begin<Game4Data>();
+  data.stateStart = sessionClock.now();
+  subscribeGameInput(data, EVENT_BIT(EVENT_BUTTON_PRESSED));
+}
 
-// Global variables to track correct answers.
-static int correctCount = 0;
-static bool firstTry = true;
+void Game4::save(uint8_t *fields)
+{
+  Game4Data &data = gameArena.get<Game4Data>();
+  CheckpointWriter writer(fields);
+  writer.u8(data.gameState == GAME4_INIT ? 0 : 1);
+  writer.u8(data.currentQuestion);
+  writer.u8(data.correctCount);
+  writer.u32(sessionClock.since(data.game4StartTime));
+}
 
-bool updateGame4()
+void Game4::resume(const uint8_t *fields)
 {
+  Game4Data &data = gameArena.get<Game4Data>();
+  CheckpointReader reader(fields);
+  if (reader.u8() == 0)
+  {
+    return;
+  }
+  data.welcomePrinted = true;
+  data.currentQuestion = reader.u8();
+  data.correctCount = reader.u8();
+  data.game4StartTime = sessionClock.now() - reader.u32();
+  data.gameState = data.currentQuestion >= questionCount() ? GAME4_COMPLETE : GAME4_SHOW_QUESTION;
+  data.stateStart = sessionClock.now();
+  rgb.setColor(0, 0, 255);
+}
+
+uint8_t Game4::state()
+{
+  return gameArena.get<Game4Data>().gameState;
+}
+
+bool Game4::update()
+{
+  // Game state lives in the shared game arena.
+  Game4Data &data = gameArena.get<Game4Data>();
+  int &correctCount = data.correctCount;
+  bool &firstTry = data.firstTry;
+  bool buttonPressed = data.input.takePress();
+
   // Print welcome message only once.
-  static bool welcomePrinted = false;
+  bool &welcomePrinted = data.welcomePrinted;
   if (!welcomePrinted)
   {
-    Serial.println("------------------------------------");
-    Serial.println("---------------Game-4---------------");
-    Serial.println("Answer the questions correctly.");
+    telemetry.log(TM_SECTION, "Game-4");
+    telemetry.log(TM_G4_INTRO);
     welcomePrinted = true;
   }
 
-  static bool finalPrinted = false;
-  static Game4State gameState = GAME4_INIT;
-  static unsigned long stateStart = millis();
-  static int currentQuestion = 0;
-  static int selectedOption = 0;
-  static uint32_t game4StartTime = 0;
-  static int charIndex = 0;
-  static unsigned long lastCharTime = 0;
-  static char typedQuestion[17] = {0};
-  static bool typewriterInit = false;
-  static unsigned long lastOptionUpdate = 0;
+  bool &finalPrinted = data.finalPrinted;
+  Game4State &gameState = data.gameState;
+  unsigned long &stateStart = data.stateStart;
+  int &currentQuestion = data.currentQuestion;
+  int &selectedOption = data.selectedOption;
+  uint32_t &game4StartTime = data.game4StartTime;
+  int &charIndex = data.charIndex;
+  unsigned long &lastCharTime = data.lastCharTime;
+  char (&typedQuestion)[17] = data.typedQuestion;
+  bool &typewriterInit = data.typewriterInit;
+  unsigned long &lastOptionUpdate = data.lastOptionUpdate;
 
   // Check global timer expiration.
-  uint32_t elapsedGlobal = millis() - globalStartTime;
-  if (elapsedGlobal >= TOTAL_TIME)
+  if (sessionClock.expired())
   {
     return true;
   }
@@ -107,7 +186,7 @@ bool updateGame4()
   case GAME4_INIT:
   {
     rgb.setColor(0, 0, 255);
-    if (millis() - stateStart < GAME4_INIT_DURATION)
+    if (sessionClock.since(stateStart) < GAME4_INIT_DURATION)
     {
       lcd.updateLCD("Trivia Time!", "Get Ready...");
     }
@@ -115,19 +194,19 @@ bool updateGame4()
     {
       currentQuestion = 0;
       selectedOption = 0;
-      game4StartTime = millis();
+      game4StartTime = sessionClock.now();
       typewriterInit = false;
       firstTry = true;
-      Serial.print("Question ");
-      Serial.println(currentQuestion + 1);
+      telemetry.log(TM_G4_QUESTION, currentQuestion + 1);
       gameState = GAME4_SHOW_QUESTION;
-      stateStart = millis();
+      stateStart = sessionClock.now();
+      requestCheckpoint();
     }
     break;
   }
   case GAME4_SHOW_QUESTION:
   {
-    const char *fullQuestion = questions[currentQuestion].question;
+    const char *fullQuestion = questionText(currentQuestion);
     char truncatedQuestion[17];
     strncpy(truncatedQuestion, fullQuestion, 16);
     truncatedQuestion[16] = '\0';
@@ -135,139 +214,125 @@ bool updateGame4()
     if (!typewriterInit)
     {
       charIndex = 0;
-      lastCharTime = millis();
+      lastCharTime = sessionClock.now();
       memset(typedQuestion, 0, sizeof(typedQuestion));
       typewriterInit = true;
     }
     if (charIndex < len)
     {
-      if (millis() - lastCharTime >= TYPEWRITER_DELAY)
+      if (sessionClock.since(lastCharTime) >= TYPEWRITER_DELAY)
       {
         typedQuestion[charIndex] = truncatedQuestion[charIndex];
         charIndex++;
-        lastCharTime = millis();
+        lastCharTime = sessionClock.now();
       }
-      char optionLine[17];
-      snprintf(optionLine, 17, "Select: A");
-      //lcd.updateLCD(typedQuestion, optionLine);
+      // Redraws only when a character was added.
+      lcd.updateLCD(typedQuestion, "Select: A");
     }
     else
     {
-      Serial.print("Q");
-      Serial.print(currentQuestion + 1);
-      Serial.print(": ");
-      Serial.println(truncatedQuestion);
+      telemetry.log(TM_G4_SHOW, currentQuestion + 1, truncatedQuestion);
       gameState = GAME4_WAIT_FOR_ANSWER;
-      stateStart = millis();
-      lastOptionUpdate = millis();
+      stateStart = sessionClock.now();
+      lastOptionUpdate = sessionClock.now();
     }
     break;
   }
   case GAME4_WAIT_FOR_ANSWER:
   {
     rgb.setColor(0, 0, 255);
-    if (millis() - lastOptionUpdate >= GAME4_OPTION_UPDATE_INTERVAL)
+    if (sessionClock.since(lastOptionUpdate) >= GAME4_OPTION_UPDATE_INTERVAL)
     {
-      int potValue = analogRead(PIN_POT);
+      Potentiometer potentiometer(PIN_POT);
+      int potValue = potentiometer.readValue();
       int mappedOption = map(potValue, 0, 1023, 0, 5);
       if (mappedOption > 4)
         mappedOption = 4;
       selectedOption = mappedOption;
       char questionLine[17];
-      strncpy(questionLine, questions[currentQuestion].question, 16);
+      strncpy(questionLine, questionText(currentQuestion), 16);
       questionLine[16] = '\0';
       char optionLine[17];
-      snprintf(optionLine, 17, "%c: %s", 'A' + selectedOption, questions[currentQuestion].options[selectedOption]);
+      Formatter(optionLine, sizeof(optionLine)).character('A' + selectedOption).text(": ").text(optionText(currentQuestion, selectedOption));
       lcd.updateLCD(questionLine, optionLine);
-      lastOptionUpdate = millis();
+      lastOptionUpdate = sessionClock.now();
     }
-    if (button.isPressed())
+    if (buttonPressed)
     {
-      Serial.print("Question ");
-      Serial.print(currentQuestion + 1);
-      Serial.print(" Answer: ");
-      Serial.print((char)('A' + selectedOption));
-      if (selectedOption == questions[currentQuestion].correctIndex)
+      bool correct = selectedOption == correctOption(currentQuestion);
+      telemetry.log(TM_G4_ANSWER, currentQuestion + 1, 'A' + selectedOption, correct ? "Correct" : "Incorrect");
+      if (correct)
       {
-        Serial.println(" - Correct");
         if (firstTry)
         {
           correctCount++;
         }
         gameState = GAME4_SUCCESS;
-        stateStart = millis();
+        stateStart = sessionClock.now();
+        data.scene.play(CORRECT_SCENE, stateStart);
       }
       else
       {
-        Serial.println(" - Incorrect");
         firstTry = false;
+        analytics.recordAttempt(4);
         gameState = GAME4_WRONG;
-        stateStart = millis();
-        rgb.setColor(255, 0, 0);
-        buzzer.playTone(TONE_ERROR_FREQ, TONE_ERROR_DURATION);
+        stateStart = sessionClock.now();
+        data.scene.play(WRONG_SCENE, stateStart);
       }
-      delay(100);
+      TRACED_DELAY(100);
     }
     break;
   }
   case GAME4_WRONG:
   {
-    lcd.updateLCD("Wrong Answer!", "Try Again...");
-    if (millis() - stateStart >= WRONG_FEEDBACK_DURATION)
+    if (!data.scene.update(sessionClock.now()))
     {
       rgb.setColor(0, 0, 255);
       gameState = GAME4_WAIT_FOR_ANSWER;
-      stateStart = millis();
+      stateStart = sessionClock.now();
     }
     break;
   }
   case GAME4_SUCCESS:
   {
-    lcd.updateLCD("Correct!", "");
-    rgb.setColor(0, 255, 0);
-    buzzer.playSuccessMelody();
-    if (millis() - stateStart >= GAME4_FEEDBACK_DURATION)
+    if (!data.scene.update(sessionClock.now()))
     {
       currentQuestion++;
-      if (currentQuestion >= NUM_QUESTIONS)
+      requestCheckpoint();
+      if (currentQuestion >= questionCount())
       {
         gameState = GAME4_COMPLETE;
       }
       else
       {
-        Serial.print("Question ");
-        Serial.println(currentQuestion + 1);
+        telemetry.log(TM_G4_QUESTION, currentQuestion + 1);
         typewriterInit = false;
         firstTry = true;
         gameState = GAME4_SHOW_QUESTION;
       }
-      stateStart = millis();
+      stateStart = sessionClock.now();
     }
     break;
   }
   case GAME4_COMPLETE:
   {
-    noTone(PIN_BUZZER);
     if (!finalPrinted)
     {
       char finalLine[17];
-      snprintf(finalLine, 17, "Good job %d/%d", correctCount, NUM_QUESTIONS);
-      Serial.println("Final level complete. Game over!");
-      rgb.setColor(0, 224, 0);
-      buzzer.playSuccessMelody();
-      Serial.print("Button presses: ");
-      Serial.println(currentGamePresses);
+      Formatter(finalLine, sizeof(finalLine)).text("Good job ").number(correctCount).character('/').number(questionCount());
+      telemetry.log(TM_FINAL_LEVEL);
+      telemetry.log(TM_BUTTON_PRESSES, currentGamePresses);
       keyLed.printTimeUsed(game4StartTime);
-      unsigned long timeTaken = millis() - game4StartTime;
+      unsigned long timeTaken = sessionClock.since(game4StartTime);
       Score game4Score(4, currentGamePresses, timeTaken);
-      game4FinalScore = game4Score.points;
-      Serial.print("Game 4 Score: ");
-      Serial.println(game4Score.points);
+      game4Score.publish();
+      telemetry.log(TM_GAME_SCORE, 4, game4Score.points);
       lcd.updateLCD("Ohh, good job!", finalLine);
       finalPrinted = true;
-      stateStart = millis();
+      stateStart = sessionClock.now();
+      data.scene.play(COMPLETE_SCENE, stateStart);
     }
-    if (millis() - stateStart >= GAME4_FEEDBACK_DURATION)
+    if (!data.scene.update(sessionClock.now()))
     {
       return true;
     }
@@ -1,25 +1,43 @@
 #include <Arduino.h>
 #include "pins.h"
-#include "Game1.h"
-#include "Game2.h"
-#include "Game3.h"
-#include "Game4.h"
 #include "RGBLed.h"
 #include "LCD.h"
 #include "KeyLed.h"
 #include "Buzzer.h"
 #include "Button.h"
+#include "EventBus.h"
+#include "SessionClock.h"
+#include "Format.h"
 #include "Globals.h"
+#include "GameRegistry.h"
+#include "GameArena.h"
+#include "Checkpoint.h"
+#include "BootProfiler.h"
+#include "Timeline.h"
+#include "HeapGuard.h"
+#include "MemoryMonitor.h"
+#include "Random.h"
+#include "Profiler.h"
+#include "Latency.h"
+#include "Telemetry.h"
+#include "Trace.h"
+#include "Analytics.h"
+#include "ScoreLog.h"
+#include "PuzzleConfig.h"
+#include "FlashLayout.h"
+#include "Content.h"
+#include "InputTrace.h"
+#include "AppState.h"
+#include "GameRules.h"
+#if defined(ARDUINO_ARCH_STM32)
+#include <IWatchdog.h>
+#endif
 
 // Global configuration constants
 static const uint8_t LCD_I2C_ADDRESS = 0x27;
 static const int LCD_COLUMNS = 16;
 static const int LCD_ROWS = 2;
 static const unsigned long BUTTON_DEBOUNCE_MS = 50;
-static const unsigned long INTRO_MESSAGE_INTERVAL_MS = 2000;
-static const unsigned long LOADING_SCREEN_DURATION_MS = 3000;
-static const unsigned long TIME_UP_WARNING_MS = 1000;
-static const unsigned long TIME_UP_DISPLAY_DURATION_MS = 3000;
 static const unsigned long CELEBRATION_CYCLE_MS = 10000;
 static const unsigned long CELEBRATION_BLINK_INTERVAL_MS = 500;
 static const unsigned long CELEBRATION_MELODY_INTERVAL_MS = 5000;
@@ -27,14 +45,16 @@ static const unsigned long CELEBRATION_MELODY_WINDOW_MS = 50;
 static const int LED_RED_R = 255;
 static const int LED_RED_G = 0;
 static const int LED_RED_B = 0;
+// Longest blocking sequence (level-up melody plus pause) is about 4 s
+static const unsigned long WATCHDOG_TIMEOUT_US = 8000000UL;
+static const unsigned long CHECKPOINT_INTERVAL_MS = 1000;
 
-// Total time for all games: 10 minutes
-extern const uint32_t TOTAL_TIME = 600000UL;
-uint32_t globalStartTime;
+// Total time for all games, unless the puzzle config sets it
+extern const uint32_t TOTAL_TIME = SESSION_TIME_MS;
 
 // Global shared objects
 LCD lcd(LCD_I2C_ADDRESS, LCD_COLUMNS, LCD_ROWS);
-KeyLed keyLed(STB_PIN, CLK_PIN, DIO_PIN);
+KeyLed keyLed;
 RGBLed rgb;
 Buzzer buzzer(PIN_BUZZER);
 Button button(PIN_BUTTON, BUTTON_DEBOUNCE_MS);
@@ -43,31 +63,102 @@ Button button(PIN_BUTTON, BUTTON_DEBOUNCE_MS);
 int totalButtonPresses = 0;
 int currentGamePresses = 0;
 
-// Scores for each game and total score
-int game1FinalScore = 0;
-int game2FinalScore = 0;
-int game3FinalScore = 0;
-int game4FinalScore = 0;
+// Scores for each game (by game id) and total score
+int gameFinalScores[PlayOrder::count] = {0};
 int totalScore = 0;
 
-// Application state definitions
-enum AppState
-{
-  STATE_INTRO,
-  STATE_GAME1,
-  STATE_LOADING1,
-  STATE_GAME2,
-  STATE_LOADING2,
-  STATE_GAME3,
-  STATE_LOADING3,
-  STATE_GAME4,
-  STATE_TIME_UP,
-  STATE_GAME_WON
-};
+static_assert(STATE_COUNT <= PROFILE_APP_STATES, "Profiler has no slot for every app state");
 
 AppState currentState = STATE_INTRO;
 uint32_t stateStartTime = 0;
 
+// Scenes played by the app states
+TimelinePlayer scene;
+
+static const Cue INTRO_TEXT[] = {
+    textCue(0, contentText(CONTENT_INTRO[0][0]), contentText(CONTENT_INTRO[0][1])),
+    textCue(INTRO_MESSAGE_INTERVAL_MS, contentText(CONTENT_INTRO[1][0]), contentText(CONTENT_INTRO[1][1])),
+    textCue(2 * INTRO_MESSAGE_INTERVAL_MS, contentText(CONTENT_INTRO[2][0]), contentText(CONTENT_INTRO[2][1]))};
+static const Track INTRO_TRACKS[] = {track(INTRO_TEXT)};
+static const Timeline INTRO_SCENE = timeline(INTRO_TRACKS, 3 * INTRO_MESSAGE_INTERVAL_MS);
+
+static const Cue TIME_UP_CUES[] = {
+    colorCue(0, LED_RED_R, LED_RED_G, LED_RED_B),
+    textCue(0, "You are forever", "Lost...")};
+static const Track TIME_UP_TRACKS[] = {track(TIME_UP_CUES, 0, false), track(GAME_OVER_MELODY)};
+static const Timeline TIME_UP_SCENE = timeline(TIME_UP_TRACKS, GAME_OVER_MELODY_MS, true);
+
+// Stats and leaderboard screen lines, filled in when the game is won
+char wonStatsLine0[17];
+char wonStatsLine1[17];
+char wonRankLine0[17];
+char wonRankLine1[17];
+static const Cue WON_TEXT[] = {
+    textCue(0, "GAME WON!", "Congratulations!"),
+    textCue(CELEBRATION_CYCLE_MS / 3, wonStatsLine0, wonStatsLine1),
+    textCue(2 * CELEBRATION_CYCLE_MS / 3, wonRankLine0, wonRankLine1)};
+static const Track WON_TRACKS[] = {
+    track(WON_TEXT),
+    track(WINNING_MELODY),
+    track(WINNING_MELODY, CELEBRATION_MELODY_INTERVAL_MS)};
+static const Timeline WON_SCENE = timeline(WON_TRACKS, CELEBRATION_CYCLE_MS, true);
+
+// Index into PlayOrder of the game being played (or loaded)
+uint8_t currentGame = 0;
+
+static_assert(PlayOrder::count <= CHECKPOINT_MAX_GAMES, "Checkpoint has no room for every game");
+static_assert(PlayOrder::count <= ANALYTICS_GAMES, "Analytics have no room for every game");
+static_assert(PlayOrder::count <= SCORE_LOG_GAMES, "Score log has no room for every game");
+
+// Save the session so a watchdog or power reset can resume it
+void saveCheckpoint()
+{
+  if (currentState != STATE_GAME && currentState != STATE_LOADING)
+  {
+    checkpointStore.clear();
+    return;
+  }
+  SessionCheckpoint checkpoint;
+  memset(&checkpoint, 0, sizeof(checkpoint));
+  checkpoint.appState = currentState;
+  checkpoint.currentGame = currentGame;
+  checkpoint.runningMs = sessionClock.runningTime();
+  for (uint8_t i = 0; i < PlayOrder::count; i++)
+  {
+    checkpoint.adjustmentSec[i] = sessionClock.adjustmentFor(i + 1) / 1000;
+    checkpoint.scores[i] = gameFinalScores[i];
+  }
+  checkpoint.totalPresses = totalButtonPresses;
+  checkpoint.seedLow = (uint32_t)rng.sessionSeed();
+  checkpoint.seedHigh = (uint32_t)(rng.sessionSeed() >> 32);
+  checkpoint.gamePresses = currentGamePresses;
+  if (currentState == STATE_GAME)
+  {
+    PlayOrder::save(currentGame, checkpoint.gameFields);
+  }
+  checkpointStore.save(checkpoint);
+}
+
+// Count button presses during games
+void onButtonPressed(const Event &event, void *context)
+{
+  if (currentState == STATE_GAME)
+  {
+    totalButtonPresses++;
+    currentGamePresses++;
+  }
+}
+
+// Record each game's score as it finishes
+void onGameScored(const Event &event, void *context)
+{
+  uint8_t gameId = event.score.gameId;
+  if (gameId >= 1 && gameId <= PlayOrder::count)
+  {
+    gameFinalScores[gameId - 1] = event.score.points;
+  }
+}
+
 // Update the 7-seg display with elapsed time and button presses
 void updateTimerDisplay()
 {
@@ -75,66 +166,152 @@ void updateTimerDisplay()
   {
     return;
   }
-  uint32_t elapsed = millis() - globalStartTime;
-  keyLed.displayTime(elapsed, TOTAL_TIME, currentGamePresses);
+  keyLed.displayTime(currentGamePresses);
 }
 
-// Intro state: show introductory messages then transition to Game1
-void updateIntro()
+// Game Won: print the session stats, log the result and prepare the
+// stats and leaderboard screens
+void announceGameWon()
 {
-  uint32_t now = millis();
-  uint32_t elapsedState = now - stateStartTime;
-  static int lastMessageIndex = -1;
-  int messageIndex = -1;
-
-  if (elapsedState < INTRO_MESSAGE_INTERVAL_MS)
+  // Calculate total score from all games.
+  ScoreRecord record;
+  memset(&record, 0, sizeof(record));
+  totalScore = 0;
+  for (uint8_t i = 0; i < PlayOrder::count; i++)
   {
-    messageIndex = 0;
+    totalScore += gameFinalScores[i];
+    record.scores[i] = gameFinalScores[i];
   }
-  else if (elapsedState < 2 * INTRO_MESSAGE_INTERVAL_MS)
+  telemetry.log(TM_SECTION, "Game-Won");
+  telemetry.log(TM_GAME_WON, totalButtonPresses, totalScore);
+  heapGuard.report();
+  memoryMonitor.report();
+  Formatter(wonStatsLine0, sizeof(wonStatsLine0)).text("BTN:").number(totalButtonPresses);
+  Formatter(wonStatsLine1, sizeof(wonStatsLine1)).text("PTS:").number(totalScore);
+
+  // Written to flash over the next frames; ranked right away
+  record.total = totalScore;
+  record.presses = totalButtonPresses;
+  record.timeSec = sessionClock.runningTime() / 1000;
+  uint32_t sequence = scoreLog.append(record);
+  uint8_t rank = scoreLog.rankOf(sequence);
+  telemetry.log(TM_SCORE_SAVED, sequence, totalScore, rank, scoreLog.count());
+  Formatter line0(wonRankLine0, sizeof(wonRankLine0));
+  if (rank > 0)
   {
-    messageIndex = 1;
+    line0.text("RANK ").number(rank).text(" OF ").number(scoreLog.count());
   }
-  else if (elapsedState < 3 * INTRO_MESSAGE_INTERVAL_MS)
+  else
   {
-    messageIndex = 2;
+    line0.text("NOT IN TOP ").number(SCORE_TOP_K);
   }
-  else
+  Formatter(wonRankLine1, sizeof(wonRankLine1)).text("BEST PTS:").number(scoreLog.entry(0).total);
+}
+
+// Session length: the puzzle config's, or the compiled one
+uint32_t sessionTime()
+{
+  return puzzleConfig.number(CFG_SESSION_TIME_MS, TOTAL_TIME);
+}
+
+// Switch app state and start the state's scene, if it has one
+void enterState(AppState state)
+{
+  if (state == STATE_TIME_UP && currentState == STATE_GAME)
   {
-    currentGamePresses = 0;
-    currentState = STATE_GAME1;
-    stateStartTime = now;
-    lastMessageIndex = -1;
-    return;
+    analytics.recordTimeUp(currentGame + 1, currentGamePresses);
+  }
+  if (state == STATE_TIME_UP || state == STATE_GAME_WON)
+  {
+    analytics.recordSessionEnd(state == STATE_GAME_WON);
   }
+  currentState = state;
+  stateStartTime = sessionClock.now();
+  TRACE_INSTANT(TRACE_ENTER_STATE, state);
+  switch (state)
+  {
+  case STATE_INTRO:
+    telemetry.log(TM_SECTION, "Main-Loop");
+    telemetry.log(TM_INTRO, sessionTime() / 60000, sessionTime() / 1000 % 60);
+    scene.play(INTRO_SCENE, stateStartTime);
+    break;
+  case STATE_TIME_UP:
+    scene.play(TIME_UP_SCENE, stateStartTime);
+    break;
+  case STATE_GAME_WON:
+    announceGameWon();
+    scene.play(WON_SCENE, stateStartTime);
+    break;
+  default:
+    scene.stop();
+    break;
+  }
+}
 
-  if (messageIndex != lastMessageIndex)
+// Continue an interrupted session; returns false when there is nothing to resume
+bool resumeFromCheckpoint()
+{
+  SessionCheckpoint checkpoint;
+  if (!checkpointStore.resetAllowsResume() || !checkpointStore.load(checkpoint) ||
+      checkpoint.currentGame >= PlayOrder::count)
   {
-    lcd.clear();
-    switch (messageIndex)
+    return false;
+  }
+  sessionClock.resume(sessionTime(), checkpoint.runningMs);
+  for (uint8_t i = 0; i < PlayOrder::count; i++)
+  {
+    int32_t adjustmentMs = (int32_t)checkpoint.adjustmentSec[i] * 1000;
+    if (adjustmentMs > 0)
     {
-    case 0:
-      lcd.lcdShow("New Adventure", "has begun!");
-      break;
-    case 1:
-      lcd.lcdShow("Have Fun", "Good Luck!");
-      Serial.println("------------------------------------");
-      Serial.println("-------------Main-Loop--------------");
-      Serial.println("The games will begin soon.");
-      Serial.println("Timer: 10 minutes");
-      break;
-    case 2:
-      lcd.lcdShow("Starting Games", "with 10m timer...");
-      break;
+      sessionClock.addPenalty(i + 1, adjustmentMs);
+    }
+    else if (adjustmentMs < 0)
+    {
+      sessionClock.addBonus(i + 1, -adjustmentMs);
     }
-    lastMessageIndex = messageIndex;
+    gameFinalScores[i] = checkpoint.scores[i];
   }
+  totalButtonPresses = checkpoint.totalPresses;
+  // Keep the interrupted session's seed so it stays replayable.
+  rng.seed(((uint64_t)checkpoint.seedHigh << 32) | checkpoint.seedLow);
+  currentGamePresses = checkpoint.gamePresses;
+  currentGame = checkpoint.currentGame;
+  if (checkpoint.appState == STATE_GAME)
+  {
+    enterState(STATE_GAME);
+    PlayOrder::begin(currentGame);
+    PlayOrder::resume(currentGame, checkpoint.gameFields);
+  }
+  else
+  {
+    enterState(STATE_LOADING);
+  }
+  telemetry.log(TM_SESSION_RESUMED, currentGame + 1);
+  return true;
 }
 
-// Loading state: brief loading screen between games
-void updateLoadingGame(const char *loadingMessage, AppState nextState)
+// Intro state: play the intro scene then transition to Game1
+void updateIntro()
 {
-  uint32_t now = millis();
+  // A button press skips the rest of the intro
+  if (button.isPressed())
+  {
+    scene.interrupt();
+  }
+  if (scene.update(sessionClock.now()))
+  {
+    return;
+  }
+  currentGamePresses = 0;
+  currentGame = 0;
+  enterState(STATE_GAME);
+  PlayOrder::begin(currentGame);
+}
+
+// Loading state: brief loading screen before the next game
+void updateLoadingGame()
+{
+  uint32_t now = sessionClock.now();
   uint32_t elapsedState = now - stateStartTime;
   static int lastMsgIndex = -1;
   int messageIndex = -1;
@@ -146,14 +323,16 @@ void updateLoadingGame(const char *loadingMessage, AppState nextState)
   else
   {
     currentGamePresses = 0;
-    currentState = nextState;
-    stateStartTime = now;
+    enterState(STATE_GAME);
+    PlayOrder::begin(currentGame);
     lastMsgIndex = -1;
     return;
   }
 
   if (messageIndex != lastMsgIndex)
   {
+    char loadingMessage[17];
+    Formatter(loadingMessage, sizeof(loadingMessage)).text("Game ").number(currentGame + 1).text(" Loading");
     lcd.clear();
     lcd.lcdShow(loadingMessage, "Loading...");
     lastMsgIndex = messageIndex;
@@ -161,202 +340,281 @@ void updateLoadingGame(const char *loadingMessage, AppState nextState)
   rgb.loadingAnimation(elapsedState);
 }
 
-// Game state handlers calling each game's update function
-void game1()
+// Game state: run the current game, then load the next one or finish
+void updateGame()
 {
-  bool finished = updateGame1();
-  if (finished)
+  bool finished;
   {
-    currentState = STATE_LOADING1;
-    stateStartTime = millis();
+    PROFILE_SCOPE(profileGameSlot(currentGame, PlayOrder::state(currentGame)));
+    TRACE_SPAN(TRACE_GAME1 + currentGame);
+#if defined(TRACING)
+    uint8_t stateBefore = PlayOrder::state(currentGame);
+#endif
+    finished = PlayOrder::update(currentGame);
+#if defined(TRACING)
+    // Game states are game-local; the argument carries game * 100 + state
+    uint8_t stateAfter = PlayOrder::state(currentGame);
+    if (stateAfter != stateBefore)
+    {
+      TRACE_INSTANT(TRACE_GAME_STATE, (currentGame + 1) * 100 + stateAfter);
+    }
+#endif
+  }
+  if (!finished)
+  {
+    return;
+  }
+  currentGame++;
+  if (currentGame < PlayOrder::count)
+  {
+    enterState(STATE_LOADING);
+    return;
   }
+  gameArena.reset();
+  enterState(sessionClock.expired() ? STATE_TIME_UP : STATE_GAME_WON);
 }
 
-void game2()
+// Handle global timeout (no games completed in time)
+void updateTimeUp()
 {
-  bool finished = updateGame2();
-  if (finished)
-  {
-    currentState = STATE_LOADING2;
-    stateStartTime = millis();
-  }
+  scene.update(sessionClock.now());
 }
 
-void game3()
+// Game Won state: celebration display and stats
+void updateGameWon()
 {
-  bool finished = updateGame3();
-  if (finished)
-  {
-    currentState = STATE_LOADING3;
-    stateStartTime = millis();
-  }
+  scene.update(sessionClock.now());
 }
 
-void game4()
+void setup()
 {
-  bool finished = updateGame4();
-  if (finished)
+  bootProfiler.mark(BOOT_SETUP);
+  telemetry.begin();
+  memoryMonitor.reportFault();
+#if defined(ARDUINO_ARCH_STM32)
+  // A firmware image that reaches the flash data would erase itself on
+  // the first save; stop before anything writes there.
+  if (firmwareImageEnd() > flashDataBase())
   {
-    uint32_t elapsedGlobal = millis() - globalStartTime;
-    if (elapsedGlobal >= TOTAL_TIME)
+    telemetry.log(TM_FLASH_OVERLAP, firmwareImageEnd(), flashDataBase());
+    while (true)
     {
-      currentState = STATE_TIME_UP;
+      telemetry.drain();
     }
-    else
-    {
-      currentState = STATE_GAME_WON;
-    }
-    stateStartTime = millis();
   }
+#endif
+  eventBus.subscribe(EVENT_BIT(EVENT_BUTTON_PRESSED), &onButtonPressed, nullptr);
+  eventBus.subscribe(EVENT_BIT(EVENT_GAME_SCORED), &onGameScored, nullptr);
+  analytics.begin();
+  scoreLog.begin();
+  puzzleConfig.begin();
+
+  // Staged boot: start the LCD power-up wait first and bring up the
+  // other peripherals while it runs.
+  lcd.beginPowerUp();
+  bootProfiler.mark(BOOT_LCD_POWER_UP);
+  rgb.begin();
+  buzzer.begin();
+  button.begin();
+  bootProfiler.mark(BOOT_OUTPUTS);
+  keyLed.begin();
+  bootProfiler.mark(BOOT_KEYLED);
+  lcd.begin();
+  bootProfiler.mark(BOOT_LCD_READY);
+
+  sessionClock.begin();
+  sessionClock.start(sessionTime());
+  rng.begin();
+#if defined(INPUT_TRACE)
+  inputTrace.startRecording();
+#endif
+  inputTrace.syncSeed(rng);
+  PROFILE_BEGIN();
+  LATENCY_BEGIN();
+
+  // Pick up an interrupted session where it left off
+  checkpointStore.begin();
+  if (!resumeFromCheckpoint())
+  {
+    enterState(STATE_INTRO);
+  }
+  rng.log();
+  bootProfiler.mark(BOOT_SESSION);
+
+#if defined(ARDUINO_ARCH_STM32)
+  IWatchdog.begin(WATCHDOG_TIMEOUT_US);
+#endif
+
+  // Everything is allocated by now; the session itself must not use the heap
+  heapGuard.lock();
+  memoryMonitor.begin();
 }
 
-// Handle global timeout (no games completed in time)
-void updateTimeUp()
+// Single-character commands from the host: p dumps the frame profile,
+// l the input latencies, r clears both, m dumps the stack and heap peaks,
+// s the leaderboard, a dumps the puzzle analytics, z erases them, c
+// uploads a puzzle config (the bytes that follow are the upload's). Other
+// bytes are ignored.
+void pollConsole()
 {
-  uint32_t now = millis();
-  uint32_t elapsedState = now - stateStartTime;
-  static int lastMsgIndex = -1;
-  int msgIndex = -1;
-  rgb.setColor(LED_RED_R, LED_RED_G, LED_RED_B);
-  buzzer.playGameOverMelody();
-
-  if (elapsedState < TIME_UP_DISPLAY_DURATION_MS)
+  while (Serial.available() > 0)
   {
-    msgIndex = 0;
-    if (msgIndex != lastMsgIndex)
+    if (puzzleConfig.uploading())
+    {
+      puzzleConfig.receive(Serial.read());
+      continue;
+    }
+    switch (Serial.read())
     {
-      lcd.lcdShow("You are forever", "Lost...");
-      lastMsgIndex = msgIndex;
+    case 'p':
+      PROFILE_DUMP();
+      break;
+    case 'l':
+      LATENCY_DUMP();
+      break;
+    case 'r':
+      PROFILE_RESET();
+      LATENCY_RESET();
+      break;
+    case 'm':
+      memoryMonitor.requestDump();
+      break;
+    case 's':
+      scoreLog.requestDump();
+      break;
+    case 'a':
+      analytics.requestDump();
+      break;
+    case 'z':
+      analytics.clear();
+      break;
+    case 'c':
+      // Flash erases stall the CPU; only between games
+      puzzleConfig.startUpload(currentState != STATE_GAME && currentState != STATE_LOADING);
+      break;
     }
   }
 }
 
-// Game Won state: celebration display and stats
-void updateGameWon() {
-  buzzer.playWinningMelody();
-  static bool printedGameWon = false;
-  static int lastMessageIndex = -1;
-
-  // Calculate total score from all games.
-  totalScore = game1FinalScore + game2FinalScore + game3FinalScore + game4FinalScore;
-
-  // On first entry, clear the LCD and print serial info.
-  if (!printedGameWon) {
-    lcd.clear();
-    printedGameWon = true;
-    Serial.println("------------------------------------");
-    Serial.println("--------------Game-Won--------------");
-    Serial.println("Game Won!");
-    Serial.print("BTN PRESSES: ");
-    Serial.println(totalButtonPresses);
-    Serial.print("POINTS: ");
-    Serial.println(totalScore);
+// One frame of work; loop() adds the frame delay.
+void runFrame()
+{
+  PROFILE_SCOPE(PROFILE_FRAME);
+  TRACE_SPAN(TRACE_FRAME);
+#if defined(ARDUINO_ARCH_STM32)
+  IWatchdog.reload();
+#endif
+  sessionClock.beginFrame();
+  inputTrace.beginFrame(sessionClock.now());
+  uint8_t stateSlot = currentState == STATE_GAME ? stateGameSlot(currentGame, PlayOrder::state(currentGame))
+                                                 : stateAppSlot(currentState);
+  LATENCY_FRAME(stateSlot);
+  {
+    PROFILE_SCOPE(PROFILE_TIMER_DISPLAY);
+    TRACE_SPAN(TRACE_TIMER_DISPLAY);
+    updateTimerDisplay();
   }
 
-  uint32_t now = millis();
-  uint32_t elapsedState = now - stateStartTime;
-  int messageIndex = -1;
-
-  // Use a 10-second cycle:
-  if (elapsedState % 10000 < 5000) {
-    messageIndex = 0;
+  // Deliver queued input events, then settle the inputs
+  {
+    PROFILE_SCOPE(PROFILE_EVENTS);
+    eventBus.dispatch();
   }
-  else {
-    messageIndex = 1;
+  {
+    PROFILE_SCOPE(PROFILE_BUTTON);
+    button.update();
   }
-
-  // Only update the LCD output if the message index has changed.
-  if (messageIndex != lastMessageIndex) {
-    lcd.clear();
-    if (messageIndex == 0) {
-      lcd.lcdShow("GAME WON!", "Congratulations!");
-    }
-    else {
-      char line0[17];
-      char line1[17];
-      snprintf(line0, sizeof(line0), "BTN:%d", totalButtonPresses);
-      snprintf(line1, sizeof(line1), "PTS:%d", totalScore);
-      lcd.lcdShow(line0, line1);
-    }
-    lastMessageIndex = messageIndex;
+  {
+    PROFILE_SCOPE(PROFILE_KEYLED);
+    TRACE_SPAN(TRACE_KEY_SCAN);
+    keyLed.update();
   }
-}
 
-void setup()
-{
-  Serial.begin(9600);
-  lcd.begin();
-  keyLed.begin();
-  rgb.begin();
-  buzzer.begin();
-  button.begin();
-
-  globalStartTime = millis();
-  currentState = STATE_INTRO;
-  stateStartTime = millis();
-}
-
-void loop()
-{
-  updateTimerDisplay();
-  button.update();
+  // Check if time is nearly up and trigger time-up state if needed
+  if (sessionClock.remaining() <= TIME_UP_WARNING_MS &&
+      currentState != STATE_TIME_UP && currentState != STATE_GAME_WON)
+  {
+    enterState(STATE_TIME_UP);
+  }
 
-  // Count button presses during games
-  if (currentState == STATE_GAME1 || currentState == STATE_GAME2 ||
-      currentState == STATE_GAME3 || currentState == STATE_GAME4)
+  // State machine: call update function for the current state
   {
-    static bool lastButtonState = false;
-    bool currentButtonState = button.isPressed();
-    if (currentButtonState && !lastButtonState)
+    PROFILE_SCOPE(profileAppSlot(currentState));
+    TRACE_SPAN(TRACE_INTRO + currentState);
+    switch (currentState)
     {
-      totalButtonPresses++;
-      currentGamePresses++;
+    case STATE_INTRO:
+      updateIntro();
+      break;
+    case STATE_GAME:
+      updateGame();
+      break;
+    case STATE_LOADING:
+      updateLoadingGame();
+      break;
+    case STATE_TIME_UP:
+      updateTimeUp();
+      break;
+    case STATE_GAME_WON:
+      updateGameWon();
+      break;
+    default:
+      break;
     }
-    lastButtonState = currentButtonState;
   }
 
-  // Check if time is nearly up and trigger time-up state if needed
-  uint32_t elapsedGlobal = millis() - globalStartTime;
-  if (TOTAL_TIME - elapsedGlobal <= TIME_UP_WARNING_MS &&
-      currentState != STATE_TIME_UP && currentState != STATE_GAME_WON)
+  // Output engines run after the state machine so new cues start this frame
   {
-    currentState = STATE_TIME_UP;
-    stateStartTime = millis();
+    PROFILE_SCOPE(PROFILE_OUTPUTS);
+    buzzer.update();
+    rgb.update();
   }
 
-  // State machine: call update function for the current state
-  switch (currentState)
+  if (!bootProfiler.finished())
   {
-  case STATE_INTRO:
-    updateIntro();
-    break;
-  case STATE_GAME1:
-    game1();
-    break;
-  case STATE_LOADING1:
-    updateLoadingGame("Game 2 Loading", STATE_GAME2);
-    break;
-  case STATE_GAME2:
-    game2();
-    break;
-  case STATE_LOADING2:
-    updateLoadingGame("Game 3 Loading", STATE_GAME3);
-    break;
-  case STATE_GAME3:
-    game3();
-    break;
-  case STATE_LOADING3:
-    updateLoadingGame("Game 4 Loading", STATE_GAME4);
-    break;
-  case STATE_GAME4:
-    game4();
-    break;
-  case STATE_TIME_UP:
-    updateTimeUp();
-    break;
-  case STATE_GAME_WON:
-    updateGameWon();
-    break;
+    bootProfiler.mark(BOOT_FIRST_FRAME);
+    bootProfiler.report();
+  }
+
+  // Checkpoint on every state change, when a game asks, and periodically
+  static AppState lastSavedState = STATE_INTRO;
+  static uint8_t lastSavedGame = 0;
+  static uint32_t lastSaveTime = 0;
+  bool requested = takeCheckpointRequest();
+  if (requested || currentState != lastSavedState || currentGame != lastSavedGame ||
+      sessionClock.since(lastSaveTime) >= CHECKPOINT_INTERVAL_MS)
+  {
+    PROFILE_SCOPE(PROFILE_CHECKPOINT);
+    TRACE_SPAN(TRACE_CHECKPOINT);
+    saveCheckpoint();
+    lastSavedState = currentState;
+    lastSavedGame = currentGame;
+    lastSaveTime = sessionClock.now();
   }
+
+  // Stack depth of this frame, measured back up at the top level
+  memoryMonitor.sample(stateSlot);
+
+  // Host commands, then hand buffered telemetry to the UART without
+  // waiting on the wire
+  pollConsole();
+  puzzleConfig.update();
+  PROFILE_UPDATE();
+  LATENCY_UPDATE();
+  memoryMonitor.update();
+  // Flash page erases stall the CPU; only between sessions
+  bool idle = currentState != STATE_GAME && currentState != STATE_LOADING;
+  analytics.update(idle);
+  scoreLog.update(idle);
+  inputTrace.endFrame(currentState, currentGame, currentState == STATE_GAME ? PlayOrder::state(currentGame) : 0);
+  {
+    PROFILE_SCOPE(PROFILE_TELEMETRY);
+    telemetry.drain();
+  }
+}
+
+void loop()
+{
+  runFrame();
   delay(10);
 }
@@ -1,6 +1,11 @@
 #ifndef PINS_H
 #define PINS_H
 
+#include "FastPin.h"
+
+// Arduino pin numbers, for the APIs that need them (analogRead, tone,
+// attachInterrupt). The hot paths use the FastPin types below.
+
 // Potentiometer
 #define PIN_POT A0
 
@@ -13,9 +18,26 @@
 #define PIN_GREEN 5
 #define PIN_BLUE 6
 
+// The same pins on the Nucleo-F303RE Arduino header.
+typedef Pin<PORT_A, 0> PotPin;     // A0
+typedef Pin<PORT_A, 10> BuzzerPin; // D2
+typedef Pin<PORT_B, 3> ButtonPin;  // D3
+typedef Pin<PORT_B, 5> RedPin;     // D4
+typedef Pin<PORT_B, 4> GreenPin;   // D5
+typedef Pin<PORT_B, 10> BluePin;   // D6
+
 // Key and LED module
-#define DIO_PIN 8
-#define CLK_PIN 9
-#define STB_PIN 10
+typedef Pin<PORT_A, 9> DioPin;  // D8
+typedef Pin<PORT_C, 7> ClkPin;  // D9
+typedef Pin<PORT_B, 6> StbPin;  // D10
+
+// Latency probe output (LATENCY_PROBE builds)
+typedef Pin<PORT_A, 8> LatencyPin; // D7
+
+static_assert(PinSet<PotPin, BuzzerPin, ButtonPin, RedPin, GreenPin, BluePin, DioPin, ClkPin, StbPin,
+                     LatencyPin>::unique,
+              "Two devices are wired to the same pin");
+static_assert(PwmSet<RedPin, GreenPin, BluePin>::unique,
+              "Two LED channels share a timer channel");
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,213 @@
+#include "Analytics.h"
+#include "FlashLayout.h"
+#include "Crc.h"
+#include "Telemetry.h"
+#include <stddef.h>
+
+Analytics analytics;
+
+static const uint32_t ANALYTICS_MAGIC = 0x414E4131; // "ANA1"
+
+// One saved copy. Two flash pages take turns so a reset during a merge
+// always leaves the previous copy intact; the higher sequence wins.
+struct AnalyticsPage
+{
+    uint32_t magic;
+    uint32_t sequence;
+    AnalyticsData data;
+    uint32_t checksum; // CRC-32 of everything above
+};
+
+static_assert(sizeof(AnalyticsPage) % 2 == 0, "Flash is programmed in half-words");
+
+#if defined(ARDUINO_ARCH_STM32)
+static_assert(sizeof(AnalyticsPage) <= FLASH_PAGE_SIZE, "Analytics do not fit in a flash page");
+
+// The last ANALYTICS_PAGES pages of flash (FlashLayout.h).
+static uint32_t pageAddress(uint8_t page)
+{
+    return analyticsBase() + page * FLASH_DATA_PAGE_SIZE;
+}
+
+static const AnalyticsPage *readPage(uint8_t page)
+{
+    return (const AnalyticsPage *)pageAddress(page);
+}
+
+static void writePage(uint8_t page, const AnalyticsPage &copy)
+{
+    HAL_FLASH_Unlock();
+    FLASH_EraseInitTypeDef erase;
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = pageAddress(page);
+    erase.NbPages = 1;
+    uint32_t pageError;
+    if (HAL_FLASHEx_Erase(&erase, &pageError) == HAL_OK)
+    {
+        const uint16_t *halfWords = (const uint16_t *)&copy;
+        for (uint16_t i = 0; i < sizeof(copy) / 2; i++)
+        {
+            HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, erase.PageAddress + i * 2, halfWords[i]);
+        }
+    }
+    HAL_FLASH_Lock();
+}
+#else
+// RAM stand-in off-target.
+static AnalyticsPage flashPages[2];
+
+static const AnalyticsPage *readPage(uint8_t page)
+{
+    return &flashPages[page];
+}
+
+static void writePage(uint8_t page, const AnalyticsPage &copy)
+{
+    flashPages[page] = copy;
+}
+#endif
+
+static bool pageValid(const AnalyticsPage *copy)
+{
+    return copy->magic == ANALYTICS_MAGIC &&
+           copy->checksum == crc32(copy, offsetof(AnalyticsPage, checksum));
+}
+
+static const char *const HISTOGRAM_NAMES[ANALYTICS_HISTOGRAM_COUNT] = {"time s", "attempts", "presses"};
+
+Analytics::Analytics()
+    : sequence(0), dirty(false), dumpCursor(ANALYTICS_GAMES + 1)
+{
+    memset(&totals, 0, sizeof(totals));
+    memset(pendingAttempts, 0, sizeof(pendingAttempts));
+}
+
+void Analytics::begin()
+{
+    const AnalyticsPage *newest = nullptr;
+    for (uint8_t page = 0; page < 2; page++)
+    {
+        const AnalyticsPage *copy = readPage(page);
+        if (pageValid(copy) && (newest == nullptr || copy->sequence > newest->sequence))
+        {
+            newest = copy;
+        }
+    }
+    if (newest != nullptr)
+    {
+        totals = newest->data;
+        sequence = newest->sequence;
+    }
+    eventBus.subscribe(EVENT_BIT(EVENT_GAME_SCORED), &Analytics::onGameScored, this);
+}
+
+void Analytics::onGameScored(const Event &event, void *context)
+{
+    static_cast<Analytics *>(context)->recordCompletion(event.score.gameId, event.score.timeTaken,
+                                                       event.score.presses);
+}
+
+void Analytics::recordAttempt(uint8_t gameId)
+{
+    if (gameId >= 1 && gameId <= ANALYTICS_GAMES && pendingAttempts[gameId - 1] != UINT8_MAX)
+    {
+        pendingAttempts[gameId - 1]++;
+    }
+}
+
+void Analytics::recordCompletion(uint8_t gameId, uint32_t timeMs, uint16_t presses)
+{
+    if (gameId < 1 || gameId > ANALYTICS_GAMES)
+    {
+        return;
+    }
+    GameAnalytics &game = totals.games[gameId - 1];
+    if (game.completions != UINT16_MAX)
+        game.completions++;
+    game.histograms[ANALYTICS_TIME_SEC].add(timeMs / 1000);
+    game.histograms[ANALYTICS_ATTEMPTS].add(pendingAttempts[gameId - 1]);
+    game.histograms[ANALYTICS_PRESSES].add(presses);
+    pendingAttempts[gameId - 1] = 0;
+    dirty = true;
+}
+
+void Analytics::recordTimeUp(uint8_t gameId, uint16_t presses)
+{
+    if (gameId < 1 || gameId > ANALYTICS_GAMES)
+    {
+        return;
+    }
+    GameAnalytics &game = totals.games[gameId - 1];
+    if (game.timeUps != UINT16_MAX)
+        game.timeUps++;
+    game.histograms[ANALYTICS_ATTEMPTS].add(pendingAttempts[gameId - 1]);
+    game.histograms[ANALYTICS_PRESSES].add(presses);
+    pendingAttempts[gameId - 1] = 0;
+    dirty = true;
+}
+
+void Analytics::recordSessionEnd(bool won)
+{
+    if (totals.sessions != UINT16_MAX)
+        totals.sessions++;
+    if (won && totals.sessionsWon != UINT16_MAX)
+        totals.sessionsWon++;
+    dirty = true;
+}
+
+void Analytics::update(bool idle)
+{
+    if (dirty && idle)
+    {
+        merge();
+    }
+
+    // One game per frame keeps the dump from flooding the telemetry ring.
+    if (dumpCursor < ANALYTICS_GAMES)
+    {
+        dumpGame(dumpCursor++);
+    }
+    else if (dumpCursor == ANALYTICS_GAMES)
+    {
+        telemetry.log(TM_ANALYTICS_END, totals.sessions, totals.sessionsWon, sequence);
+        dumpCursor++;
+    }
+}
+
+// Write the totals over the older of the two copies.
+void Analytics::merge()
+{
+    AnalyticsPage copy;
+    memset(&copy, 0, sizeof(copy));
+    copy.magic = ANALYTICS_MAGIC;
+    copy.sequence = sequence + 1;
+    copy.data = totals;
+    copy.checksum = crc32(&copy, offsetof(AnalyticsPage, checksum));
+    writePage(copy.sequence & 1, copy);
+    sequence = copy.sequence;
+    dirty = false;
+}
+
+void Analytics::clear()
+{
+    memset(&totals, 0, sizeof(totals));
+    memset(pendingAttempts, 0, sizeof(pendingAttempts));
+    AnalyticsPage blank;
+    memset(&blank, 0, sizeof(blank));
+    writePage(0, blank);
+    writePage(1, blank);
+    sequence = 0;
+    dirty = false;
+}
+
+void Analytics::dumpGame(uint8_t index) const
+{
+    const GameAnalytics &game = totals.games[index];
+    telemetry.log(TM_ANALYTICS_GAME, index + 1, game.completions + game.timeUps, game.completions, game.timeUps);
+    for (uint8_t h = 0; h < ANALYTICS_HISTOGRAM_COUNT; h++)
+    {
+        const uint16_t *b = game.histograms[h].buckets;
+        telemetry.log(TM_ANALYTICS_HISTOGRAM, HISTOGRAM_NAMES[h], b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7],
+                      b[8], b[9], b[10], b[11]);
+    }
+}
@@ -0,0 +1,36 @@
+#include "BootProfiler.h"
+#include "Telemetry.h"
+
+BootProfiler bootProfiler;
+
+static const char *const BOOT_PHASE_NAMES[BOOT_PHASE_COUNT] = {
+    "setup",
+    "lcd power-up",
+    "outputs",
+    "keyled",
+    "lcd ready",
+    "session",
+    "first frame"};
+
+BootProfiler::BootProfiler()
+{
+    memset(stamps, 0, sizeof(stamps));
+}
+
+void BootProfiler::mark(BootPhase phase)
+{
+    stamps[phase] = micros();
+}
+
+void BootProfiler::report() const
+{
+    telemetry.log(TM_SECTION, "Boot");
+    uint32_t previous = 0;
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        telemetry.log(TM_BOOT_PHASE, BOOT_PHASE_NAMES[i], stamps[i], stamps[i] - previous);
+        previous = stamps[i];
+    }
+    uint32_t total = stamps[BOOT_FIRST_FRAME];
+    telemetry.log(TM_BOOT_TOTAL, total, BOOT_FIRST_FRAME_BUDGET_US, total > BOOT_FIRST_FRAME_BUDGET_US ? "OVER BUDGET" : "ok");
+}
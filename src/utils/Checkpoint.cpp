@@ -0,0 +1,93 @@
+#include "Checkpoint.h"
+#include "Crc.h"
+#include <stddef.h>
+#if defined(ARDUINO_ARCH_STM32)
+#include <backup.h>
+#endif
+
+CheckpointStore checkpointStore;
+
+static const uint8_t CHECKPOINT_WORDS = sizeof(SessionCheckpoint) / 4;
+static bool checkpointRequested = false;
+
+#if !defined(ARDUINO_ARCH_STM32)
+static uint32_t backupWords[CHECKPOINT_WORDS];
+#endif
+
+static uint32_t readWord(uint8_t index)
+{
+#if defined(ARDUINO_ARCH_STM32)
+    return getBackupRegister(index);
+#else
+    return backupWords[index];
+#endif
+}
+
+static void writeWord(uint8_t index, uint32_t value)
+{
+#if defined(ARDUINO_ARCH_STM32)
+    setBackupRegister(index, value);
+#else
+    backupWords[index] = value;
+#endif
+}
+
+void CheckpointStore::begin()
+{
+#if defined(ARDUINO_ARCH_STM32)
+    enableBackupDomain();
+    // Every reset also pulls NRST low, so the pin flag alone means the reset button.
+    resumable = __HAL_RCC_GET_FLAG(RCC_FLAG_IWDGRST) || __HAL_RCC_GET_FLAG(RCC_FLAG_SFTRST) ||
+                __HAL_RCC_GET_FLAG(RCC_FLAG_PORRST) || __HAL_RCC_GET_FLAG(RCC_FLAG_LPWRRST);
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+#else
+    resumable = true;
+#endif
+}
+
+bool CheckpointStore::load(SessionCheckpoint &checkpoint)
+{
+    uint32_t words[CHECKPOINT_WORDS];
+    for (uint8_t i = 0; i < CHECKPOINT_WORDS; i++)
+    {
+        words[i] = readWord(i);
+    }
+    memcpy(&checkpoint, words, sizeof(checkpoint));
+    if (checkpoint.version != CHECKPOINT_VERSION)
+    {
+        return false;
+    }
+    return checkpoint.checksum == crc32(&checkpoint, offsetof(SessionCheckpoint, checksum));
+}
+
+void CheckpointStore::save(SessionCheckpoint &checkpoint)
+{
+    checkpoint.version = CHECKPOINT_VERSION;
+    checkpoint.checksum = crc32(&checkpoint, offsetof(SessionCheckpoint, checksum));
+    uint32_t words[CHECKPOINT_WORDS];
+    memcpy(words, &checkpoint, sizeof(checkpoint));
+    for (uint8_t i = 0; i < CHECKPOINT_WORDS; i++)
+    {
+        writeWord(i, words[i]);
+    }
+}
+
+void CheckpointStore::clear()
+{
+    for (uint8_t i = 0; i < CHECKPOINT_WORDS; i++)
+    {
+        writeWord(i, 0);
+    }
+}
+
+void requestCheckpoint()
+{
+    checkpointRequested = true;
+}
+
+bool takeCheckpointRequest()
+{
+    bool requested = checkpointRequested;
+    checkpointRequested = false;
+    return requested;
+}
@@ -0,0 +1,65 @@
+// Generated by tools/content_compiler.py from content/; do not edit.
+#include "Content.h"
+
+const char CONTENT_STRINGS[CONTENT_STRINGS_SIZE] =
+    "A quartet awaits\0"
+    "Listen carefully\0"
+    "Lucky last touch\0"
+    "Welcome: LEVEL 1\0"
+    "press the button\0"
+    "with a 10m timer\0"
+    "Element 'O' is?\0"
+    "France: Capital\0"
+    "Largest planet?\0"
+    "Middle of magic\0"
+    "Portugal is in?\0"
+    "The lone melody\0"
+    "Water Boils at?\0"
+    "When found, you\0"
+    "A pair in tune\0"
+    "Dont forget to\0"
+    "Escape fast or\0"
+    "Infinite curve\0"
+    "Largest ocean?\0"
+    "Starting Games\0"
+    "New Adventure\0"
+    "Triple allure\0"
+    "find the beep\0"
+    "rocks hit you\0"
+    "Sixth sense\0"
+    "Get Ready!\0"
+    "Good Luck!\0"
+    "are close!\0"
+    "has begun!\0"
+    "Australia\0"
+    "S.America\0"
+    "48215637\0"
+    "Atlantic\0"
+    "Have Fun\0"
+    "Hydrogen\0"
+    "Southern\0"
+    "Jupiter\0"
+    "Neptune\0"
+    "Pacific\0"
+    "100\302\260C\0"
+    "110\302\260C\0"
+    "120\302\260C\0"
+    "Africa\0"
+    "Arctic\0"
+    "Berlin\0"
+    "Europe\0"
+    "Indian\0"
+    "Lisbon\0"
+    "Madrid\0"
+    "Oxygen\0"
+    "Saturn\0"
+    "Silver\0"
+    "80\302\260C\0"
+    "90\302\260C\0"
+    "Earth\0"
+    "Paris\0"
+    "Asia\0"
+    "Gold\0"
+    "Iron\0"
+    "Mars\0"
+    "Rome";
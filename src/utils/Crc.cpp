@@ -0,0 +1,40 @@
+#include "Crc.h"
+
+uint32_t crc32(const void *data, size_t length, uint32_t crc)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t crc32Words(const uint32_t *words, size_t count)
+{
+#if defined(ARDUINO_ARCH_STM32) && defined(CRC)
+    RCC->AHBENR |= RCC_AHBENR_CRCEN;
+    CRC->CR = CRC_CR_RESET;
+    for (size_t i = 0; i < count; i++)
+    {
+        CRC->DR = words[i];
+    }
+    return CRC->DR;
+#else
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (size_t i = 0; i < count; i++)
+    {
+        crc ^= words[i];
+        for (uint8_t bit = 0; bit < 32; bit++)
+        {
+            crc = (crc << 1) ^ (0x04C11DB7UL & (0 - (crc >> 31)));
+        }
+    }
+    return crc;
+#endif
+}
@@ -0,0 +1,120 @@
+#include "EventBus.h"
+
+EventBus eventBus;
+
+Event makeEvent(EventType type)
+{
+    Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.timestamp = millis();
+    return event;
+}
+
+EventBus::EventBus() : subscriberDrops(0)
+{
+    memset(subscribers, 0, sizeof(subscribers));
+}
+
+bool EventBus::subscribe(uint32_t mask, EventHandler handler, void *context)
+{
+    for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++)
+    {
+        if (subscribers[i].handler == nullptr)
+        {
+            subscribers[i].mask = mask;
+            subscribers[i].handler = handler;
+            subscribers[i].context = context;
+            return true;
+        }
+    }
+    subscriberDrops++;
+    return false;
+}
+
+void EventBus::unsubscribe(void *context)
+{
+    for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++)
+    {
+        if (subscribers[i].handler != nullptr && subscribers[i].context == context)
+        {
+            subscribers[i].handler = nullptr;
+            subscribers[i].mask = 0;
+            subscribers[i].context = nullptr;
+        }
+    }
+}
+
+bool EventBus::hasSubscriber(EventType type) const
+{
+    for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++)
+    {
+        if (subscribers[i].handler != nullptr && (subscribers[i].mask & EVENT_BIT(type)))
+            return true;
+    }
+    return false;
+}
+
+bool EventBus::publishFromIsr(const Event &event)
+{
+    return inputQueue.push(event);
+}
+
+void EventBus::publish(const Event &event)
+{
+    uint32_t bit = EVENT_BIT(event.type);
+    for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++)
+    {
+        if (subscribers[i].handler != nullptr && (subscribers[i].mask & bit))
+            subscribers[i].handler(event, subscribers[i].context);
+    }
+}
+
+void EventBus::dispatch()
+{
+    Event event;
+    while (inputQueue.pop(event))
+    {
+        publish(event);
+    }
+}
+
+bool EventBus::queueAudio(const Event &event)
+{
+    return audioQueue.push(event);
+}
+
+bool EventBus::nextAudio(Event &event)
+{
+    return audioQueue.pop(event);
+}
+
+bool EventBus::queueLed(const Event &event)
+{
+    return ledQueue.push(event);
+}
+
+bool EventBus::nextLed(Event &event)
+{
+    return ledQueue.pop(event);
+}
+
+uint32_t EventBus::inputOverflows() const
+{
+    return inputQueue.overflowCount();
+}
+
+uint32_t EventBus::audioOverflows() const
+{
+    return audioQueue.overflowCount();
+}
+
+uint32_t EventBus::ledOverflows() const
+{
+    return ledQueue.overflowCount();
+}
+
+uint32_t EventBus::subscriberOverflows() const
+{
+    return subscriberDrops;
+}
@@ -0,0 +1,14 @@
+#include "FlashLayout.h"
+
+#if defined(ARDUINO_ARCH_STM32)
+// From the core's linker script.
+extern "C"
+{
+    extern uint32_t _sidata, _sdata, _edata;
+}
+
+uint32_t firmwareImageEnd()
+{
+    return (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+}
+#endif
@@ -0,0 +1,95 @@
+#include "Format.h"
+
+Formatter::Formatter(char *buffer, size_t size) : buffer(buffer), size(size), used(0)
+{
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+}
+
+void Formatter::put(char c)
+{
+    if (used + 1 >= size)
+    {
+        return;
+    }
+    buffer[used++] = c;
+    buffer[used] = '\0';
+}
+
+Formatter &Formatter::text(const char *value)
+{
+    while (*value)
+    {
+        put(*value++);
+    }
+    return *this;
+}
+
+Formatter &Formatter::character(char value)
+{
+    put(value);
+    return *this;
+}
+
+Formatter &Formatter::number(long value, NumberFormat format)
+{
+    // Digits come out least significant first.
+    char digits[20];
+    uint8_t count = 0;
+    bool negative = value < 0;
+    unsigned long magnitude = negative ? 0UL - (unsigned long)value : (unsigned long)value;
+    do
+    {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    uint8_t length = count + (negative ? 1 : 0);
+    uint8_t padding = format.width > length ? format.width - length : 0;
+    // Spaces go before the sign, zeros after it.
+    if (format.fill == ' ')
+    {
+        while (padding-- > 0)
+        {
+            put(' ');
+        }
+    }
+    if (negative)
+    {
+        put('-');
+    }
+    if (format.fill != ' ')
+    {
+        while (padding-- > 0)
+        {
+            put(format.fill);
+        }
+    }
+    while (count > 0)
+    {
+        put(digits[--count]);
+    }
+    return *this;
+}
+
+Formatter &Formatter::time(uint32_t seconds, TimeFormat format)
+{
+    number(seconds / 60, PAD2);
+    if (format.separator)
+    {
+        put(format.separator);
+    }
+    return number(seconds % 60, PAD2);
+}
+
+Formatter &Formatter::hex(uint32_t value, uint8_t digits)
+{
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    for (int8_t shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+    {
+        put(HEX_DIGITS[(value >> shift) & 0xF]);
+    }
+    return *this;
+}
@@ -0,0 +1,22 @@
+#include "GameArena.h"
+#include "EventBus.h"
+
+GameArena gameArena;
+
+GameArena::GameArena() : destroy(nullptr) {}
+
+GameArena::~GameArena()
+{
+    reset();
+}
+
+void GameArena::reset()
+{
+    if (destroy)
+    {
+        // Drop the occupant's event subscriptions before destroying it.
+        eventBus.unsubscribe(storage);
+        destroy(storage);
+        destroy = nullptr;
+    }
+}
@@ -0,0 +1,58 @@
+#include "HeapGuard.h"
+#include "Telemetry.h"
+
+HeapGuard heapGuard;
+
+HeapGuard::HeapGuard() : locked(false), totalCount(0), lockedCount(0), lastLockedSize(0) {}
+
+void HeapGuard::record(size_t size)
+{
+    totalCount++;
+    if (!locked)
+    {
+        return;
+    }
+    lockedCount++;
+    lastLockedSize = size;
+#if defined(HEAP_GUARD_FORBID)
+    // Stop right at the offending call so a debugger shows who allocated.
+    __BKPT(0);
+#endif
+}
+
+void HeapGuard::report() const
+{
+    telemetry.log(TM_HEAP, totalCount, lockedCount);
+    if (lockedCount > 0)
+    {
+        telemetry.log(TM_HEAP_LAST, lastLockedSize);
+    }
+}
+
+#if defined(ARDUINO_ARCH_STM32)
+// Linker wrappers (-Wl,--wrap=...): count, then hand over to newlib.
+extern "C"
+{
+    void *__real__malloc_r(struct _reent *reent, size_t size);
+    void *__real__calloc_r(struct _reent *reent, size_t count, size_t size);
+    void *__real__realloc_r(struct _reent *reent, void *ptr, size_t size);
+
+    void *__wrap__malloc_r(struct _reent *reent, size_t size)
+    {
+        heapGuard.record(size);
+        return __real__malloc_r(reent, size);
+    }
+
+    void *__wrap__calloc_r(struct _reent *reent, size_t count, size_t size)
+    {
+        heapGuard.record(count * size);
+        return __real__calloc_r(reent, count, size);
+    }
+
+    void *__wrap__realloc_r(struct _reent *reent, void *ptr, size_t size)
+    {
+        heapGuard.record(size);
+        return __real__realloc_r(reent, ptr, size);
+    }
+}
+#endif
@@ -0,0 +1,294 @@
+#include "InputTrace.h"
+#include "EventBus.h"
+#include "Telemetry.h"
+#include <string.h>
+
+InputTrace inputTrace;
+
+static const uint8_t FRAME_DELTA_ESCAPE = 31;
+
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+InputTrace::InputTrace()
+    : mode(MODE_OFF), frameTime(0), lastKeys(0), frameCount(0), framePrepared(false), chunkLength(0), chunkSequence(0), lastFlush(0),
+      data(nullptr), length(0), position(0), divergenceCount(0), firstDivergentFrame(0),
+      lastDivergentFrame(0)
+{
+    memset(lastAnalog, 0, sizeof(lastAnalog));
+    memset(lastState, 0xFF, sizeof(lastState));
+}
+
+void InputTrace::startRecording()
+{
+    mode = MODE_RECORD;
+}
+
+void InputTrace::startReplay(const uint8_t *replayData, size_t replayLength)
+{
+    mode = MODE_REPLAY;
+    data = replayData;
+    length = replayLength;
+    position = 0;
+}
+
+bool InputTrace::prepareFrame(uint32_t &frameTimeMs)
+{
+    if (mode != MODE_REPLAY)
+    {
+        return false;
+    }
+    // Samples the last frame did not read mean it took another path.
+    while (position < length && !peek(INPUT_RECORD_FRAME))
+    {
+        diverged();
+        take();
+    }
+    if (position >= length)
+    {
+        return false;
+    }
+    uint32_t delta = take() >> 3;
+    if (delta == FRAME_DELTA_ESCAPE)
+    {
+        delta = takeVarint();
+    }
+    frameTime += delta;
+    frameCount++;
+    framePrepared = true;
+    frameTimeMs = frameTime;
+    return true;
+}
+
+void InputTrace::syncSeed(RandomService &rng)
+{
+    if (mode == MODE_RECORD)
+    {
+        uint64_t seed = rng.sessionSeed();
+        put(INPUT_RECORD_SEED, 0);
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            putByte((uint8_t)(seed >> (8 * i)));
+        }
+    }
+    else if (mode == MODE_REPLAY)
+    {
+        if (!peek(INPUT_RECORD_SEED) || length - position < 9)
+        {
+            diverged();
+            return;
+        }
+        take();
+        uint64_t seed = 0;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            seed |= (uint64_t)take() << (8 * i);
+        }
+        rng.seed(seed);
+    }
+}
+
+void InputTrace::beginFrame(uint32_t now)
+{
+    if (mode == MODE_RECORD)
+    {
+        uint32_t delta = now - frameTime;
+        put(INPUT_RECORD_FRAME, delta < FRAME_DELTA_ESCAPE ? delta : FRAME_DELTA_ESCAPE);
+        if (delta >= FRAME_DELTA_ESCAPE)
+        {
+            putVarint(delta);
+        }
+        frameTime = now;
+        frameCount++;
+        return;
+    }
+    if (mode != MODE_REPLAY || !framePrepared)
+    {
+        return;
+    }
+    framePrepared = false;
+    // A frame that started late sees its timers differently.
+    if (now != frameTime)
+    {
+        diverged();
+    }
+    // The frame's button edges, queued as the pin interrupt would have.
+    while (peek(INPUT_RECORD_EDGE))
+    {
+        Event event = makeEvent(EVENT_BUTTON_EDGE);
+        event.button.level = take() >> 3;
+        event.timestamp = frameTime + unzigzag(takeVarint());
+        eventBus.publishFromIsr(event);
+    }
+}
+
+int InputTrace::sampleAnalog(InputChannel channel, int raw)
+{
+    if (mode == MODE_RECORD)
+    {
+        if (raw != lastAnalog[channel])
+        {
+            put(INPUT_RECORD_ANALOG, channel);
+            putVarint(zigzag(raw - lastAnalog[channel]));
+            lastAnalog[channel] = raw;
+        }
+        return raw;
+    }
+    if (peek(INPUT_RECORD_ANALOG) && (data[position] >> 3) == channel)
+    {
+        take();
+        lastAnalog[channel] += unzigzag(takeVarint());
+    }
+    return lastAnalog[channel];
+}
+
+uint8_t InputTrace::sampleKeys(uint8_t raw)
+{
+    if (mode == MODE_RECORD)
+    {
+        if (raw != lastKeys)
+        {
+            put(INPUT_RECORD_KEYS, 0);
+            putByte(raw);
+            lastKeys = raw;
+        }
+        return raw;
+    }
+    if (peek(INPUT_RECORD_KEYS) && length - position >= 2)
+    {
+        take();
+        lastKeys = take();
+    }
+    return lastKeys;
+}
+
+void InputTrace::buttonEdge(uint8_t level, uint32_t timestamp)
+{
+    if (mode != MODE_RECORD)
+    {
+        return;
+    }
+    put(INPUT_RECORD_EDGE, level ? 1 : 0);
+    putVarint(zigzag((int32_t)(timestamp - frameTime)));
+}
+
+void InputTrace::endFrame(uint8_t appState, uint8_t game, uint8_t gameState)
+{
+    if (mode == MODE_OFF)
+    {
+        return;
+    }
+    bool changed = appState != lastState[0] || game != lastState[1] || gameState != lastState[2];
+    lastState[0] = appState;
+    lastState[1] = game;
+    lastState[2] = gameState;
+    if (mode == MODE_RECORD)
+    {
+        if (changed)
+        {
+            put(INPUT_RECORD_STATE, appState);
+            putByte(game);
+            putByte(gameState);
+        }
+        if (chunkLength >= CHUNK_SIZE / 2 || (chunkLength > 0 && millis() - lastFlush >= FLUSH_INTERVAL_MS))
+        {
+            flush();
+        }
+        return;
+    }
+    if (!peek(INPUT_RECORD_STATE) || length - position < 3)
+    {
+        if (changed)
+        {
+            diverged();
+        }
+        return;
+    }
+    bool same = (data[position] >> 3) == appState && data[position + 1] == game && data[position + 2] == gameState;
+    position += 3;
+    if (!same)
+    {
+        diverged();
+    }
+}
+
+void InputTrace::flush()
+{
+    if (chunkLength == 0)
+    {
+        return;
+    }
+    telemetry.log(TM_INPUT_TRACE, chunkSequence++, TelemetryBytes{chunk, chunkLength});
+    chunkLength = 0;
+    lastFlush = millis();
+}
+
+void InputTrace::put(uint8_t kind, uint8_t payload)
+{
+    putByte(kind | (payload << 3));
+}
+
+void InputTrace::putByte(uint8_t byte)
+{
+    if (chunkLength == CHUNK_SIZE)
+    {
+        flush();
+    }
+    chunk[chunkLength++] = byte;
+}
+
+void InputTrace::putVarint(uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        putByte((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    putByte((uint8_t)value);
+}
+
+bool InputTrace::peek(uint8_t kind) const
+{
+    return position < length && (data[position] & 0x07) == kind;
+}
+
+uint8_t InputTrace::take()
+{
+    return position < length ? data[position++] : 0;
+}
+
+uint32_t InputTrace::takeVarint()
+{
+    uint32_t value = 0;
+    for (uint8_t shift = 0; shift < 35 && position < length; shift += 7)
+    {
+        uint8_t byte = data[position++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            break;
+        }
+    }
+    return value;
+}
+
+void InputTrace::diverged()
+{
+    if (divergenceCount > 0 && lastDivergentFrame == frameCount)
+    {
+        return;
+    }
+    if (divergenceCount == 0)
+    {
+        firstDivergentFrame = frameCount;
+    }
+    divergenceCount++;
+    lastDivergentFrame = frameCount;
+}
@@ -0,0 +1,144 @@
+#include "Latency.h"
+
+#if defined(LATENCY_PROBE)
+
+#include "Telemetry.h"
+#include "Format.h"
+#include "pins.h"
+
+LatencyProbe latency;
+
+static uint8_t bucketFor(uint32_t us)
+{
+    uint8_t bits = us ? 32 - __builtin_clz(us) : 0;
+    if (bits <= LATENCY_FIRST_BUCKET_BITS)
+        return 0;
+    uint8_t msb = bits - 1;
+    uint8_t bucket = (msb - LATENCY_FIRST_BUCKET_BITS) * 2 + ((us >> (msb - 1)) & 1) + 1;
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// Smallest latency in bucket b.
+static uint32_t bucketStart(uint8_t b)
+{
+    if (b == 0)
+        return 0;
+    uint8_t msb = LATENCY_FIRST_BUCKET_BITS + (b - 1) / 2;
+    return (1UL << msb) | ((uint32_t)((b - 1) & 1) << (msb - 1));
+}
+
+LatencyProbe::LatencyProbe() : phase(PHASE_IDLE), inputUs(0), inputSlot(0), frameSlot(0), dumpCursor(LATENCY_SLOT_COUNT)
+{
+    reset();
+}
+
+void LatencyProbe::begin()
+{
+    LatencyPin::output();
+    LatencyPin::low();
+}
+
+void LatencyProbe::reset()
+{
+    phase = PHASE_IDLE;
+    memset(slots, 0, sizeof(slots));
+}
+
+void LatencyProbe::beginFrame(uint8_t slot)
+{
+    frameSlot = slot < LATENCY_SLOT_COUNT ? slot : LATENCY_SLOT_COUNT - 1;
+    if (phase != PHASE_IDLE && micros() - inputUs > LATENCY_TIMEOUT_US)
+    {
+        noInterrupts();
+        phase = PHASE_IDLE;
+        LatencyStats &s = slots[inputSlot];
+        interrupts();
+        if (s.unanswered != UINT16_MAX)
+            s.unanswered++;
+        LatencyPin::low();
+    }
+}
+
+void LatencyProbe::input(LatencyInput kind)
+{
+    (void)kind;
+    if (phase != PHASE_IDLE)
+        return;
+    inputUs = micros();
+    inputSlot = frameSlot;
+    phase = PHASE_CAPTURED;
+    LatencyPin::high();
+}
+
+void LatencyProbe::matched(LatencyOutput kind)
+{
+    uint32_t now = micros();
+    noInterrupts();
+    uint32_t us = now - inputUs;
+    uint8_t slot = inputSlot;
+    phase = PHASE_IDLE;
+    interrupts();
+    LatencyPin::low();
+
+    LatencyStats &s = slots[slot];
+    s.count++;
+    if (us > s.max)
+        s.max = us;
+    if (s.byOutput[kind] != UINT16_MAX)
+        s.byOutput[kind]++;
+    uint8_t bucket = bucketFor(us);
+    if (s.buckets[bucket] != UINT16_MAX)
+        s.buckets[bucket]++;
+}
+
+uint32_t LatencyProbe::percentile(uint8_t slot, uint8_t p) const
+{
+    const LatencyStats &s = slots[slot];
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++)
+        total += s.buckets[b];
+    if (total == 0)
+        return 0;
+    uint32_t rank = (total * p + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += s.buckets[b];
+        if (seen >= rank)
+        {
+            uint32_t end = b + 1 < LATENCY_BUCKETS ? bucketStart(b + 1) : s.max;
+            return end < s.max ? end : s.max;
+        }
+    }
+    return s.max;
+}
+
+void LatencyProbe::update()
+{
+    while (dumpCursor < LATENCY_SLOT_COUNT && slots[dumpCursor].count == 0 && slots[dumpCursor].unanswered == 0)
+    {
+        dumpCursor++;
+    }
+    if (dumpCursor < LATENCY_SLOT_COUNT)
+    {
+        dumpSlot(dumpCursor++);
+        if (dumpCursor == LATENCY_SLOT_COUNT)
+        {
+            telemetry.log(TM_LATENCY_END, LATENCY_TIMEOUT_US / 1000);
+        }
+    }
+}
+
+void LatencyProbe::dumpSlot(uint8_t slot) const
+{
+    char name[24];
+    Formatter label(name, sizeof(name));
+    stateSlotLabel(label, slot);
+
+    const LatencyStats &s = slots[slot];
+    telemetry.log(TM_LATENCY_SLOT, name, s.count, percentile(slot, 50), percentile(slot, 99), s.max, s.unanswered);
+    telemetry.log(TM_LATENCY_OUTPUTS, s.byOutput[LATENCY_LCD], s.byOutput[LATENCY_LED], s.byOutput[LATENCY_TONE],
+                  s.byOutput[LATENCY_RGB]);
+}
+
+#endif
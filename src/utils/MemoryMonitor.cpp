@@ -0,0 +1,311 @@
+#include "MemoryMonitor.h"
+#include "HeapGuard.h"
+#include "Telemetry.h"
+#include "Format.h"
+#include "Crc.h"
+#include <stddef.h>
+#include <errno.h>
+
+#if defined(ARDUINO_ARCH_STM32)
+#include <malloc.h>
+#endif
+
+MemoryMonitor memoryMonitor;
+
+static const uint32_t FAULT_MAGIC = 0x464C5431; // "FLT1"
+// Room left for the painting loop's own frame.
+static const uint32_t STACK_MARGIN = 64;
+
+#if defined(ARDUINO_ARCH_STM32)
+// Where the heap must stop once the guard is in place; 0 before begin().
+static uint32_t heapLimit = 0;
+
+extern "C"
+{
+    extern uint32_t _estack;
+    void *_sbrk(ptrdiff_t increment);
+
+    // newlib-nano's free list; weak so a full newlib still links.
+    struct NanoChunk
+    {
+        long size;
+        NanoChunk *next;
+    };
+    extern NanoChunk *__malloc_free_list __attribute__((weak));
+
+    void *__real__sbrk(ptrdiff_t increment);
+
+    // Linker wrapper (-Wl,--wrap=_sbrk): an allocation that would reach
+    // the guard fails with ENOMEM instead of faulting on the MPU.
+    void *__wrap__sbrk(ptrdiff_t increment)
+    {
+        if (heapLimit != 0 && increment > 0 && (uint32_t)__real__sbrk(0) + increment > heapLimit)
+        {
+            errno = ENOMEM;
+            return (void *)-1;
+        }
+        return __real__sbrk(increment);
+    }
+}
+
+// Top of CCM SRAM: the startup code neither clears nor loads it, so the
+// record lives through the reset the handler triggers.
+static FaultRecord &faultRecord = *(FaultRecord *)(CCMDATARAM_BASE + 0x4000 - sizeof(FaultRecord));
+
+static uint32_t stackTop()
+{
+    return (uint32_t)&_estack;
+}
+
+static uint32_t stackPointer()
+{
+    return __get_MSP();
+}
+#else
+static FaultRecord faultRecord;
+#endif
+
+MemoryMonitor::MemoryMonitor() : heapAllocations(0), guardEnd(0), frameSlot(0), dumpCursor(STATE_SLOT_COUNT), painted(false)
+{
+    memset(&session, 0, sizeof(session));
+    memset(stackPeaks, 0, sizeof(stackPeaks));
+    memset(heapPeaks, 0, sizeof(heapPeaks));
+}
+
+void MemoryMonitor::begin()
+{
+#if defined(ARDUINO_ARCH_STM32)
+    // Every allocation is made by now (setup() calls this after
+    // heapGuard.lock()). The guard goes HEAP_HEADROOM above the heap, so
+    // a stray late allocation is counted by HeapGuard but still succeeds.
+    uint32_t guard = ((uint32_t)_sbrk(0) + HEAP_HEADROOM + GUARD_SIZE - 1) & ~(GUARD_SIZE - 1);
+    guardEnd = guard + GUARD_SIZE;
+    heapLimit = guard;
+    session.stackSize = stackTop() - guardEnd;
+
+    // Region 0: 256 bytes, no access for anyone (AP = 0), never executable.
+    MPU->RNR = 0;
+    MPU->RBAR = guard;
+    MPU->RASR = MPU_RASR_XN_Msk | (7 << MPU_RASR_SIZE_Pos) | MPU_RASR_ENABLE_Msk;
+    MPU->CTRL = MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk;
+    __DSB();
+    __ISB();
+
+    uint32_t *low = (uint32_t *)guardEnd;
+    uint32_t *high = (uint32_t *)(stackPointer() - STACK_MARGIN);
+    for (uint32_t *word = low; word < high; word++)
+    {
+        *word = STACK_PAINT;
+    }
+    painted = true;
+    readHeap();
+#endif
+}
+
+void MemoryMonitor::sample(uint8_t slot)
+{
+    frameSlot = slot < STATE_SLOT_COUNT ? slot : STATE_SLOT_COUNT - 1;
+#if defined(ARDUINO_ARCH_STM32)
+    if (!painted)
+    {
+        return;
+    }
+    // Walk down from just below this frame; a run of untouched words means
+    // the deepest write of the frame is behind us.
+    uint32_t *base = (uint32_t *)guardEnd;
+    uint32_t start = (stackPointer() - STACK_MARGIN - guardEnd) / 4;
+    uint32_t deepest = start;
+    uint32_t run = 0;
+    for (uint32_t i = start; i > 0 && run < STACK_GAP_WORDS; i--)
+    {
+        if (base[i - 1] == STACK_PAINT)
+        {
+            run++;
+        }
+        else
+        {
+            run = 0;
+            deepest = i - 1;
+        }
+    }
+    for (uint32_t i = deepest; i < start; i++)
+    {
+        base[i] = STACK_PAINT;
+    }
+
+    uint32_t depth = stackTop() - (guardEnd + deepest * 4);
+    if (depth > session.stackPeak)
+    {
+        session.stackPeak = depth;
+    }
+    if (depth > stackPeaks[frameSlot])
+    {
+        stackPeaks[frameSlot] = depth < UINT16_MAX ? depth : UINT16_MAX;
+    }
+
+    if (heapGuard.total() != heapAllocations)
+    {
+        readHeap();
+    }
+    if (session.heapUsed > heapPeaks[frameSlot])
+    {
+        heapPeaks[frameSlot] = session.heapUsed < UINT16_MAX ? session.heapUsed : UINT16_MAX;
+    }
+#endif
+}
+
+// The lowest word that ever lost its paint: sample() only repaints what
+// its own scans reached, so this bounds every frame since begin().
+void MemoryMonitor::scanStack()
+{
+#if defined(ARDUINO_ARCH_STM32)
+    if (!painted)
+    {
+        return;
+    }
+    const uint32_t *word = (const uint32_t *)guardEnd;
+    const uint32_t *high = (const uint32_t *)stackPointer();
+    while (word < high && *word == STACK_PAINT)
+    {
+        word++;
+    }
+    uint32_t depth = stackTop() - (uint32_t)word;
+    if (depth > session.stackPeak)
+    {
+        session.stackPeak = depth;
+    }
+#endif
+}
+
+void MemoryMonitor::readHeap()
+{
+    heapAllocations = heapGuard.total();
+#if defined(ARDUINO_ARCH_STM32)
+    struct mallinfo info = mallinfo();
+    // Between the top of the heap and the guard is free to grow into.
+    uint32_t room = guardEnd - GUARD_SIZE - (uint32_t)_sbrk(0);
+    uint32_t largest = room;
+    if (&__malloc_free_list != nullptr)
+    {
+        for (NanoChunk *chunk = __malloc_free_list; chunk != nullptr; chunk = chunk->next)
+        {
+            if ((uint32_t)chunk->size > largest)
+            {
+                largest = chunk->size;
+            }
+        }
+    }
+    session.heapUsed = info.uordblks;
+    session.heapFree = info.fordblks + room;
+    session.largestFree = largest;
+    session.fragmentation = session.heapFree ? 100 - (uint64_t)largest * 100 / session.heapFree : 0;
+#endif
+}
+
+void MemoryMonitor::report()
+{
+    scanStack();
+    readHeap();
+    telemetry.log(TM_MEMORY, session.stackPeak, session.stackSize, session.heapUsed, session.heapFree,
+                  session.largestFree, session.fragmentation);
+}
+
+void MemoryMonitor::update()
+{
+    if (dumpCursor == 0)
+    {
+        report();
+    }
+    while (dumpCursor < STATE_SLOT_COUNT && stackPeaks[dumpCursor] == 0 && heapPeaks[dumpCursor] == 0)
+    {
+        dumpCursor++;
+    }
+    if (dumpCursor < STATE_SLOT_COUNT)
+    {
+        dumpSlot(dumpCursor++);
+        if (dumpCursor == STATE_SLOT_COUNT)
+        {
+            telemetry.log(TM_MEMORY_END);
+        }
+    }
+}
+
+void MemoryMonitor::dumpSlot(uint8_t slot) const
+{
+    char name[24];
+    Formatter label(name, sizeof(name));
+    stateSlotLabel(label, slot);
+    telemetry.log(TM_MEMORY_STATE, name, stackPeaks[slot], heapPeaks[slot]);
+}
+
+void MemoryMonitor::recordFault(uint32_t sp, uint32_t excReturn)
+{
+    FaultRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = FAULT_MAGIC;
+    record.sp = sp;
+    record.excReturn = excReturn;
+    record.slot = frameSlot;
+#if defined(ARDUINO_ARCH_STM32)
+    MPU->CTRL = 0;
+    record.cfsr = SCB->CFSR;
+    record.hfsr = SCB->HFSR;
+    if (record.cfsr & SCB_CFSR_MMARVALID_Msk)
+    {
+        record.address = SCB->MMFAR;
+    }
+    else if (record.cfsr & SCB_CFSR_BFARVALID_Msk)
+    {
+        record.address = SCB->BFAR;
+    }
+    uint32_t guard = guardEnd - GUARD_SIZE;
+    bool inGuard = (record.address >= guard && record.address < guardEnd) || (sp >= guard && sp < guardEnd + 32);
+    record.stackOverflow = (record.cfsr & SCB_CFSR_MSTKERR_Msk) || inGuard;
+#endif
+    record.checksum = crc32(&record, offsetof(FaultRecord, checksum));
+    faultRecord = record;
+}
+
+void MemoryMonitor::reportFault()
+{
+    FaultRecord record = faultRecord;
+    if (record.magic != FAULT_MAGIC || record.checksum != crc32(&record, offsetof(FaultRecord, checksum)))
+    {
+        return;
+    }
+    faultRecord.magic = 0;
+    char name[24];
+    Formatter label(name, sizeof(name));
+    stateSlotLabel(label, record.slot < STATE_SLOT_COUNT ? record.slot : 0);
+    const char *kind = record.stackOverflow ? "stack overflow" : record.cfsr & 0xFF ? "memory fault" : "hard fault";
+    telemetry.log(TM_FAULT, name, kind, record.cfsr, record.address, record.sp);
+}
+
+#if defined(ARDUINO_ARCH_STM32)
+extern "C" void memoryFault(uint32_t sp, uint32_t excReturn)
+{
+    memoryMonitor.recordFault(sp, excReturn);
+    NVIC_SystemReset();
+}
+
+// The faulting stack may be the one that overflowed: move to the top of
+// RAM before running any C.
+extern "C" __attribute__((naked)) void MemManage_Handler()
+{
+    __asm volatile("mrs r0, msp\n"
+                   "mov r1, lr\n"
+                   "ldr r2, =_estack\n"
+                   "msr msp, r2\n"
+                   "b memoryFault\n");
+}
+
+extern "C" __attribute__((naked)) void HardFault_Handler()
+{
+    __asm volatile("mrs r0, msp\n"
+                   "mov r1, lr\n"
+                   "ldr r2, =_estack\n"
+                   "msr msp, r2\n"
+                   "b memoryFault\n");
+}
+#endif
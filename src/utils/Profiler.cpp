@@ -0,0 +1,107 @@
+#include "Profiler.h"
+
+#if defined(PROFILING)
+
+#include "Telemetry.h"
+#include "Format.h"
+
+Profiler profiler;
+
+static const char *const PROFILE_PHASE_NAMES[PROFILE_PHASE_COUNT] = {
+    "frame",
+    "timer display",
+    "events",
+    "button",
+    "keyled",
+    "outputs",
+    "checkpoint",
+    "telemetry"};
+
+Profiler::Profiler() : dumpCursor(PROFILE_SLOT_COUNT)
+{
+    reset();
+}
+
+void Profiler::begin()
+{
+#if defined(ARDUINO_ARCH_STM32)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+void Profiler::reset()
+{
+    memset(slots, 0, sizeof(slots));
+    for (uint8_t i = 0; i < PROFILE_SLOT_COUNT; i++)
+    {
+        slots[i].min = UINT32_MAX;
+    }
+}
+
+void Profiler::record(uint8_t slot, uint32_t cycles)
+{
+    ProfileStats &s = slots[slot];
+    s.count++;
+    s.total += cycles;
+    if (cycles < s.min)
+        s.min = cycles;
+    if (cycles > s.max)
+        s.max = cycles;
+
+    uint8_t bits = cycles ? 32 - __builtin_clz(cycles) : 0;
+    uint8_t bucket = bits > PROFILE_FIRST_BUCKET_BITS ? bits - PROFILE_FIRST_BUCKET_BITS : 0;
+    if (bucket >= PROFILE_BUCKETS)
+        bucket = PROFILE_BUCKETS - 1;
+    if (s.buckets[bucket] != UINT16_MAX)
+        s.buckets[bucket]++;
+}
+
+void Profiler::update()
+{
+    // Skip empty slots, then dump one.
+    while (dumpCursor < PROFILE_SLOT_COUNT && slots[dumpCursor].count == 0)
+    {
+        dumpCursor++;
+    }
+    if (dumpCursor < PROFILE_SLOT_COUNT)
+    {
+        dumpSlot(dumpCursor++);
+        if (dumpCursor == PROFILE_SLOT_COUNT)
+        {
+#if defined(ARDUINO_ARCH_STM32)
+            telemetry.log(TM_PROFILE_END, SystemCoreClock / 1000000);
+#else
+            telemetry.log(TM_PROFILE_END, 1); // micros() stands in for the cycle counter
+#endif
+        }
+    }
+}
+
+void Profiler::dumpSlot(uint8_t slot) const
+{
+    char name[24];
+    Formatter label(name, sizeof(name));
+    if (slot < PROFILE_APP_BASE)
+    {
+        label.text(PROFILE_PHASE_NAMES[slot]);
+    }
+    else
+    {
+        stateSlotLabel(label, slot - PROFILE_APP_BASE);
+    }
+
+    const ProfileStats &s = slots[slot];
+    telemetry.log(TM_PROFILE_SLOT, name, s.count, s.min, (uint32_t)(s.total / s.count), s.max);
+    for (uint8_t b = 0; b < PROFILE_BUCKETS; b++)
+    {
+        if (s.buckets[b] > 0)
+        {
+            uint32_t from = b == 0 ? 0 : 1UL << (b + PROFILE_FIRST_BUCKET_BITS - 1);
+            telemetry.log(TM_PROFILE_BUCKET, from, s.buckets[b]);
+        }
+    }
+}
+
+#endif
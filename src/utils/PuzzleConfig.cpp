@@ -0,0 +1,389 @@
+#include "PuzzleConfig.h"
+#include "FlashLayout.h"
+#include "Crc.h"
+#include "Telemetry.h"
+#include <string.h>
+
+PuzzleConfig puzzleConfig;
+
+// Type and limits of each key: min, max and step for numbers, the
+// longest string for texts, the most items and longest item for lists.
+struct ConfigRule
+{
+    uint8_t type;
+    int32_t first;
+    int32_t second;
+    int32_t step;
+};
+
+static const ConfigRule RULES[CONFIG_KEY_COUNT] = {
+#define CONFIG_NUMBER(key, min, max) {CONFIG_TYPE_NUMBER, min, max, 1},
+#define CONFIG_NUMBER_STEP(key, min, max, step) {CONFIG_TYPE_NUMBER, min, max, step},
+#define CONFIG_TEXT(key, maxLength) {CONFIG_TYPE_TEXT, 0, maxLength, 0},
+#define CONFIG_LIST(key, maxItems, maxItemLength) {CONFIG_TYPE_LIST, maxItems, maxItemLength, 0},
+#include "ConfigKeys.def"
+#undef CONFIG_NUMBER
+#undef CONFIG_NUMBER_STEP
+#undef CONFIG_TEXT
+#undef CONFIG_LIST
+};
+
+static const char *const ERROR_NAMES[] = {"ok", "bad header", "bad checksum", "bad entry", "bad value"};
+
+// Written at the start of a slot once the blob after it checks out.
+struct ConfigSlotStamp
+{
+    uint32_t generation;
+    uint32_t check; // ~generation
+};
+
+static const uint32_t BLOB_CAPACITY = PuzzleConfig::SLOT_SIZE - sizeof(ConfigSlotStamp);
+
+static bool checkValue(const ConfigRule &rule, const uint8_t *value, uint16_t length, uint8_t &count)
+{
+    if (rule.type == CONFIG_TYPE_NUMBER)
+    {
+        int32_t number;
+        if (length != sizeof(number))
+            return false;
+        memcpy(&number, value, sizeof(number));
+        return number >= rule.first && number <= rule.second && number % rule.step == 0;
+    }
+    if (length == 0 || value[length - 1] != 0)
+    {
+        return false;
+    }
+    // Texts are a list of one.
+    count = 0;
+    uint16_t start = 0;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if (value[i] == 0)
+        {
+            if (i - start > rule.second)
+                return false;
+            count++;
+            start = i + 1;
+        }
+    }
+    return rule.type == CONFIG_TYPE_TEXT ? count == 1 : count <= rule.first;
+}
+
+void ConfigView::clear()
+{
+    base = nullptr;
+    memset(offsets, 0, sizeof(offsets));
+    memset(counts, 0, sizeof(counts));
+}
+
+ConfigError ConfigView::map(const uint8_t *blob, uint32_t capacity)
+{
+    clear();
+    ConfigBlobHeader header;
+    if (capacity < sizeof(header))
+    {
+        return CONFIG_BAD_HEADER;
+    }
+    memcpy(&header, blob, sizeof(header));
+    if (header.magic != CONFIG_MAGIC || header.version != CONFIG_FORMAT_VERSION || header.length < sizeof(header) ||
+        header.length > capacity || header.length % 4 != 0 || header.length > UINT16_MAX)
+    {
+        return CONFIG_BAD_HEADER;
+    }
+    if (crc32(blob + sizeof(header), header.length - sizeof(header)) != header.crc)
+    {
+        return CONFIG_BAD_CHECKSUM;
+    }
+
+    uint32_t pos = sizeof(header);
+    for (uint16_t e = 0; e < header.entries; e++)
+    {
+        ConfigEntryHeader entry;
+        if (pos + sizeof(entry) > header.length)
+        {
+            clear();
+            return CONFIG_BAD_ENTRY;
+        }
+        memcpy(&entry, blob + pos, sizeof(entry));
+        uint32_t value = pos + sizeof(entry);
+        uint32_t next = value + ((entry.length + 3u) & ~3u);
+        if (next > header.length)
+        {
+            clear();
+            return CONFIG_BAD_ENTRY;
+        }
+        pos = next;
+        if (entry.key >= CONFIG_KEY_COUNT)
+        {
+            continue; // From a newer tool; not ours to read
+        }
+        const ConfigRule &rule = RULES[entry.key];
+        if (entry.type != rule.type || offsets[entry.key] != 0)
+        {
+            clear();
+            return CONFIG_BAD_ENTRY;
+        }
+        if (!checkValue(rule, blob + value, entry.length, counts[entry.key]))
+        {
+            clear();
+            return CONFIG_BAD_VALUE;
+        }
+        offsets[entry.key] = value;
+    }
+    if (pos != header.length)
+    {
+        clear();
+        return CONFIG_BAD_ENTRY;
+    }
+    base = blob;
+    return CONFIG_OK;
+}
+
+uint8_t ConfigView::keys() const
+{
+    uint8_t count = 0;
+    for (uint8_t key = 0; key < CONFIG_KEY_COUNT; key++)
+    {
+        if (offsets[key] != 0)
+            count++;
+    }
+    return count;
+}
+
+int32_t ConfigView::number(ConfigKey key, int32_t fallback) const
+{
+    if (offsets[key] == 0 || RULES[key].type != CONFIG_TYPE_NUMBER)
+    {
+        return fallback;
+    }
+    int32_t value;
+    memcpy(&value, base + offsets[key], sizeof(value));
+    return value;
+}
+
+const char *ConfigView::text(ConfigKey key, const char *fallback) const
+{
+    if (offsets[key] == 0 || RULES[key].type != CONFIG_TYPE_TEXT)
+    {
+        return fallback;
+    }
+    return (const char *)(base + offsets[key]);
+}
+
+const char *ConfigView::item(ConfigKey key, uint8_t index, const char *fallback) const
+{
+    if (index >= counts[key] || RULES[key].type != CONFIG_TYPE_LIST)
+    {
+        return fallback;
+    }
+    const char *item = (const char *)(base + offsets[key]);
+    while (index-- > 0)
+    {
+        item += strlen(item) + 1;
+    }
+    return item;
+}
+
+#if defined(ARDUINO_ARCH_STM32)
+// The two slots just below the score log (FlashLayout.h).
+static uint32_t slotAddress(uint8_t slot)
+{
+    return configBase() + slot * PuzzleConfig::SLOT_SIZE;
+}
+
+static const uint8_t *readSlot(uint8_t slot)
+{
+    return (const uint8_t *)slotAddress(slot);
+}
+
+static void programHalfWord(uint8_t slot, uint32_t offset, uint16_t value)
+{
+    HAL_FLASH_Unlock();
+    HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, slotAddress(slot) + offset, value);
+    HAL_FLASH_Lock();
+}
+
+static void eraseSlot(uint8_t slot)
+{
+    HAL_FLASH_Unlock();
+    FLASH_EraseInitTypeDef erase;
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = slotAddress(slot);
+    erase.NbPages = PuzzleConfig::SLOT_SIZE / FLASH_PAGE_SIZE;
+    uint32_t pageError;
+    HAL_FLASHEx_Erase(&erase, &pageError);
+    HAL_FLASH_Lock();
+}
+#else
+// RAM stand-in off-target, with flash semantics.
+static uint8_t flashSlots[2][PuzzleConfig::SLOT_SIZE];
+static bool flashFormatted = false;
+
+static const uint8_t *readSlot(uint8_t slot)
+{
+    if (!flashFormatted)
+    {
+        memset(flashSlots, 0xFF, sizeof(flashSlots));
+        flashFormatted = true;
+    }
+    return flashSlots[slot];
+}
+
+static void programHalfWord(uint8_t slot, uint32_t offset, uint16_t value)
+{
+    readSlot(slot);
+    flashSlots[slot][offset] &= value & 0xFF;
+    flashSlots[slot][offset + 1] &= value >> 8;
+}
+
+static void eraseSlot(uint8_t slot)
+{
+    readSlot(slot);
+    memset(flashSlots[slot], 0xFF, PuzzleConfig::SLOT_SIZE);
+}
+#endif
+
+static uint32_t stampedGeneration(uint8_t slot)
+{
+    ConfigSlotStamp stamp;
+    memcpy(&stamp, readSlot(slot), sizeof(stamp));
+    if (stamp.generation == 0 || stamp.generation == 0xFFFFFFFFUL || stamp.check != ~stamp.generation)
+    {
+        return 0;
+    }
+    return stamp.generation;
+}
+
+PuzzleConfig::PuzzleConfig()
+    : activeGeneration(0), activeSlot(0), phase(PHASE_IDLE), allowed(false), slot(0), length(0), received(0),
+      pendingByte(0), lastByteTime(0)
+{
+}
+
+void PuzzleConfig::begin()
+{
+    active.clear();
+    activeGeneration = 0;
+    for (uint8_t s = 0; s < 2; s++)
+    {
+        uint32_t generation = stampedGeneration(s);
+        ConfigView view;
+        if (generation > activeGeneration && view.map(readSlot(s) + sizeof(ConfigSlotStamp), BLOB_CAPACITY) == CONFIG_OK)
+        {
+            active = view;
+            activeGeneration = generation;
+            activeSlot = s;
+        }
+    }
+    if (activeGeneration == 0)
+    {
+        telemetry.log(TM_CONFIG_DEFAULTS);
+        return;
+    }
+    telemetry.log(TM_CONFIG_LOADED, activeGeneration, activeSlot, active.length(), active.keys());
+}
+
+void PuzzleConfig::startUpload(bool allowed)
+{
+    this->allowed = allowed;
+    phase = PHASE_LENGTH;
+    length = 0;
+    received = 0;
+    lastByteTime = millis();
+}
+
+void PuzzleConfig::receive(uint8_t byte)
+{
+    lastByteTime = millis();
+    if (phase == PHASE_LENGTH)
+    {
+        length |= (uint32_t)byte << (8 * received);
+        if (++received == sizeof(length))
+        {
+            lengthReceived();
+        }
+        return;
+    }
+    if (phase != PHASE_DATA)
+    {
+        return;
+    }
+    uint32_t offset = sizeof(ConfigSlotStamp) + received;
+    if (received & 1)
+    {
+        programHalfWord(slot, offset - 1, pendingByte | (uint16_t)byte << 8);
+    }
+    else
+    {
+        pendingByte = byte;
+    }
+    received++;
+    if (received % CHUNK_SIZE == 0 || received == length)
+    {
+        telemetry.log(TM_CONFIG_ACK, received);
+    }
+    if (received == length)
+    {
+        finishUpload();
+    }
+}
+
+void PuzzleConfig::update()
+{
+    if (phase != PHASE_IDLE && millis() - lastByteTime > UPLOAD_TIMEOUT_MS)
+    {
+        reject("timeout");
+    }
+}
+
+void PuzzleConfig::lengthReceived()
+{
+    if (!allowed)
+    {
+        reject("a game is running");
+        return;
+    }
+    if (length < sizeof(ConfigBlobHeader) || length > BLOB_CAPACITY || length % 4 != 0)
+    {
+        reject("bad length");
+        return;
+    }
+    // Blocks for the page erases; uploads only run between games.
+    slot = activeGeneration != 0 ? 1 - activeSlot : 0;
+    eraseSlot(slot);
+    phase = PHASE_DATA;
+    received = 0;
+    telemetry.log(TM_CONFIG_READY, length, CHUNK_SIZE);
+}
+
+void PuzzleConfig::finishUpload()
+{
+    ConfigView view;
+    ConfigError error = view.map(readSlot(slot) + sizeof(ConfigSlotStamp), BLOB_CAPACITY);
+    if (error != CONFIG_OK)
+    {
+        reject(ERROR_NAMES[error]);
+        return;
+    }
+    // The stamp is the switch: until its last half-word lands, the old
+    // slot stays the newest valid one.
+    ConfigSlotStamp stamp;
+    stamp.generation = activeGeneration + 1;
+    stamp.check = ~stamp.generation;
+    const uint16_t *halfWords = (const uint16_t *)&stamp;
+    for (uint8_t i = 0; i < sizeof(stamp) / 2; i++)
+    {
+        programHalfWord(slot, i * 2, halfWords[i]);
+    }
+    active = view;
+    activeGeneration = stamp.generation;
+    activeSlot = slot;
+    phase = PHASE_IDLE;
+    telemetry.log(TM_CONFIG_LOADED, activeGeneration, activeSlot, active.length(), active.keys());
+}
+
+void PuzzleConfig::reject(const char *reason)
+{
+    phase = PHASE_IDLE;
+    telemetry.log(TM_CONFIG_REJECTED, reason);
+}
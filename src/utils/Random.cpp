@@ -0,0 +1,117 @@
+#include "Random.h"
+#include "Telemetry.h"
+
+RandomService rng;
+
+// SplitMix64 step, to spread a seed (or raw entropy) over all bits.
+static uint64_t splitMix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+Xoshiro128::Xoshiro128()
+{
+    seed(0);
+}
+
+void Xoshiro128::seed(uint64_t seed)
+{
+    uint64_t state = seed;
+    uint64_t a = splitMix64(state);
+    uint64_t b = splitMix64(state);
+    s[0] = (uint32_t)a;
+    s[1] = (uint32_t)(a >> 32);
+    s[2] = (uint32_t)b;
+    s[3] = (uint32_t)(b >> 32);
+}
+
+void Xoshiro128::jump()
+{
+    static const uint32_t JUMP[4] = {0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b};
+    uint32_t t[4] = {0, 0, 0, 0};
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        for (uint8_t b = 0; b < 32; b++)
+        {
+            if (JUMP[i] & (1UL << b))
+            {
+                t[0] ^= s[0];
+                t[1] ^= s[1];
+                t[2] ^= s[2];
+                t[3] ^= s[3];
+            }
+            next();
+        }
+    }
+    memcpy(s, t, sizeof(s));
+}
+
+RandomService::RandomService() : current(0) {}
+
+void RandomService::begin()
+{
+#if defined(SESSION_SEED)
+    seed(SESSION_SEED);
+#else
+    seed(gatherEntropy());
+#endif
+}
+
+void RandomService::seed(uint64_t sessionSeed)
+{
+    current = sessionSeed;
+    streams[0].seed(sessionSeed);
+    for (uint8_t i = 1; i < RANDOM_STREAMS; i++)
+    {
+        streams[i] = streams[i - 1];
+        streams[i].jump();
+    }
+}
+
+void RandomService::log() const
+{
+    telemetry.log(TM_SESSION_SEED, (uint32_t)(current >> 32), (uint32_t)current);
+}
+
+uint64_t RandomService::gatherEntropy()
+{
+    uint64_t pool = 0;
+    uint64_t state = 0;
+    // ADC noise: the low bits of a floating input and of the sensor
+    // channel change from sample to sample.
+    for (uint8_t i = 0; i < 32; i++)
+    {
+        pool = (pool << 2) | (pool >> 62);
+        pool ^= (uint64_t)(analogRead(A1) & 0x3);
+#if defined(ARDUINO_ARCH_STM32) && defined(ATEMP)
+        pool ^= (uint64_t)(analogRead(ATEMP) & 0x3) << 2;
+#endif
+    }
+    state ^= pool;
+    splitMix64(state);
+
+    // Timer jitter: the cycle counter against the microsecond clock across
+    // ADC conversions whose length varies.
+#if defined(ARDUINO_ARCH_STM32)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        uint32_t start = DWT->CYCCNT;
+        analogRead(A1);
+        state ^= (uint64_t)(DWT->CYCCNT - start) << (i * 4 % 60);
+        splitMix64(state);
+    }
+#endif
+    state ^= (uint64_t)micros() << 32;
+    splitMix64(state);
+
+    // Hardware unique ID: different boards never share a seed.
+#if defined(ARDUINO_ARCH_STM32)
+    state ^= ((uint64_t)HAL_GetUIDw0() << 32) ^ HAL_GetUIDw1() ^ ((uint64_t)HAL_GetUIDw2() << 16);
+#endif
+    return splitMix64(state);
+}
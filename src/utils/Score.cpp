@@ -1,4 +1,5 @@
 #include "Score.h"
+#include "EventBus.h"
 
 Score::Score() : gameId(0), buttonPresses(0), timeTaken(0), points(0) {}
 
@@ -11,3 +12,12 @@ void Score::calculatePoints(int presses, unsigned long time) {
   unsigned long seconds = time / 1000; // convert milliseconds to seconds
   points = seconds * presses;
 }
+
+void Score::publish() const {
+  Event event = makeEvent(EVENT_GAME_SCORED);
+  event.score.gameId = gameId;
+  event.score.presses = buttonPresses;
+  event.score.timeTaken = timeTaken;
+  event.score.points = points;
+  eventBus.publish(event);
+}
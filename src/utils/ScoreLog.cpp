@@ -0,0 +1,334 @@
+#include "ScoreLog.h"
+#include "Crc.h"
+#include "Telemetry.h"
+#include <stddef.h>
+
+ScoreLog scoreLog;
+
+static const uint16_t LOG_SLOTS = SCORE_LOG_PAGES * ScoreLog::RECORDS_PER_PAGE;
+static const uint16_t NO_LOCATION = 0xFFFF;
+static const uint8_t RECORD_HALF_WORDS = sizeof(ScoreRecord) / 2;
+static const uint8_t RECORD_CRC_WORDS = offsetof(ScoreRecord, crc) / 4;
+
+#if defined(ARDUINO_ARCH_STM32)
+// The SCORE_LOG_PAGES pages just below the analytics pages (FlashLayout.h).
+static uint32_t logBase()
+{
+    return scoreLogBase();
+}
+
+static const ScoreRecord *readSlot(uint16_t location)
+{
+    return (const ScoreRecord *)(logBase() + location * sizeof(ScoreRecord));
+}
+
+static void programHalfWord(uint16_t location, uint8_t index, uint16_t value)
+{
+    HAL_FLASH_Unlock();
+    HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, logBase() + location * sizeof(ScoreRecord) + index * 2, value);
+    HAL_FLASH_Lock();
+}
+
+static void erasePage(uint8_t page)
+{
+    HAL_FLASH_Unlock();
+    FLASH_EraseInitTypeDef erase;
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = logBase() + page * FLASH_PAGE_SIZE;
+    erase.NbPages = 1;
+    uint32_t pageError;
+    HAL_FLASHEx_Erase(&erase, &pageError);
+    HAL_FLASH_Lock();
+}
+#else
+// RAM stand-in off-target, with flash semantics: erased to 0xFF, and
+// programming can only clear bits.
+static ScoreRecord flashSlots[LOG_SLOTS];
+static bool flashFormatted = false;
+
+static const ScoreRecord *readSlot(uint16_t location)
+{
+    if (!flashFormatted)
+    {
+        memset(flashSlots, 0xFF, sizeof(flashSlots));
+        flashFormatted = true;
+    }
+    return &flashSlots[location];
+}
+
+static void programHalfWord(uint16_t location, uint8_t index, uint16_t value)
+{
+    readSlot(location);
+    ((uint16_t *)&flashSlots[location])[index] &= value;
+}
+
+static void erasePage(uint8_t page)
+{
+    readSlot(0);
+    memset(&flashSlots[page * ScoreLog::RECORDS_PER_PAGE], 0xFF, ScoreLog::PAGE_SIZE);
+}
+#endif
+
+static bool slotBlank(const ScoreRecord *record)
+{
+    const uint32_t *words = (const uint32_t *)record;
+    for (uint8_t i = 0; i < sizeof(ScoreRecord) / 4; i++)
+    {
+        if (words[i] != 0xFFFFFFFFUL)
+            return false;
+    }
+    return true;
+}
+
+static bool slotValid(const ScoreRecord *record)
+{
+    return record->sequence != 0 && record->sequence != 0xFFFFFFFFUL &&
+           record->crc == crc32Words((const uint32_t *)record, RECORD_CRC_WORDS);
+}
+
+// Lower total first, then the quicker session, then the earlier one.
+static bool better(const ScoreEntry &a, const ScoreEntry &b)
+{
+    if (a.total != b.total)
+        return a.total < b.total;
+    if (a.timeSec != b.timeSec)
+        return a.timeSec < b.timeSec;
+    return a.sequence < b.sequence;
+}
+
+ScoreLog::ScoreLog()
+    : entries(0), lastSequence(0), headPage(0), headSlot(0), queued(false), writeLocation(NO_LOCATION),
+      writeHalfWord(0), writing(false), compactPage(-1), compactSlot(0), compactDirty(false),
+      dumpCursor(SCORE_TOP_K + 1)
+{
+    memset(top, 0, sizeof(top));
+    memset(&queuedRecord, 0, sizeof(queuedRecord));
+    memset(&writeRecord, 0, sizeof(writeRecord));
+}
+
+void ScoreLog::begin()
+{
+    entries = 0;
+    lastSequence = 0;
+    queued = false;
+    writing = false;
+
+    // The head page holds the newest record.
+    headPage = 0;
+    for (uint16_t location = 0; location < LOG_SLOTS; location++)
+    {
+        const ScoreRecord *record = readSlot(location);
+        if (slotValid(record) && record->sequence > lastSequence)
+        {
+            lastSequence = record->sequence;
+            headPage = location / RECORDS_PER_PAGE;
+        }
+    }
+    headSlot = RECORDS_PER_PAGE;
+    while (headSlot > 0 && slotBlank(readSlot(headPage * RECORDS_PER_PAGE + headSlot - 1)))
+    {
+        headSlot--;
+    }
+
+    // Oldest page first, so a carried record's newest copy wins.
+    for (uint8_t i = 1; i <= SCORE_LOG_PAGES; i++)
+    {
+        uint8_t page = (headPage + i) % SCORE_LOG_PAGES;
+        for (uint8_t slot = 0; slot < RECORDS_PER_PAGE; slot++)
+        {
+            uint16_t location = page * RECORDS_PER_PAGE + slot;
+            const ScoreRecord *record = readSlot(location);
+            if (slotValid(record))
+            {
+                insert(*record, location);
+            }
+        }
+    }
+
+    // The page after the head must be erased before the head reaches it;
+    // a reset may have left it half compacted.
+    compactPage = (headPage + 1) % SCORE_LOG_PAGES;
+    compactSlot = 0;
+    compactDirty = false;
+}
+
+void ScoreLog::insert(const ScoreRecord &record, uint16_t location)
+{
+    for (uint8_t i = 0; i < entries; i++)
+    {
+        if (top[i].sequence == record.sequence)
+        {
+            top[i].location = location;
+            return;
+        }
+    }
+    ScoreEntry entry;
+    entry.sequence = record.sequence;
+    entry.total = record.total;
+    entry.presses = record.presses;
+    entry.timeSec = record.timeSec;
+    entry.location = location;
+
+    uint8_t rank = entries;
+    while (rank > 0 && better(entry, top[rank - 1]))
+    {
+        rank--;
+    }
+    if (rank >= SCORE_TOP_K)
+    {
+        return;
+    }
+    uint8_t last = entries < SCORE_TOP_K ? entries : SCORE_TOP_K - 1;
+    for (uint8_t i = last; i > rank; i--)
+    {
+        top[i] = top[i - 1];
+    }
+    top[rank] = entry;
+    if (entries < SCORE_TOP_K)
+    {
+        entries++;
+    }
+}
+
+uint8_t ScoreLog::rankOf(uint32_t sequence) const
+{
+    for (uint8_t i = 0; i < entries; i++)
+    {
+        if (top[i].sequence == sequence)
+            return i + 1;
+    }
+    return 0;
+}
+
+uint32_t ScoreLog::append(ScoreRecord record)
+{
+    if (queued)
+    {
+        return 0;
+    }
+    record.sequence = ++lastSequence;
+    record.crc = crc32Words((const uint32_t *)&record, RECORD_CRC_WORDS);
+    queuedRecord = record;
+    queued = true;
+    // On the leaderboard straight away; the location follows once a slot is free.
+    insert(record, NO_LOCATION);
+    return record.sequence;
+}
+
+// Next free slot. The head moves on to the next page only once that page
+// is compacted and erased; until then there is no slot.
+uint16_t ScoreLog::allocate()
+{
+    if (headSlot >= RECORDS_PER_PAGE)
+    {
+        uint8_t next = (headPage + 1) % SCORE_LOG_PAGES;
+        if (compactPage == next)
+        {
+            return NO_LOCATION;
+        }
+        headPage = next;
+        headSlot = 0;
+        compactPage = (next + 1) % SCORE_LOG_PAGES;
+        compactSlot = 0;
+        compactDirty = false;
+    }
+    return headPage * RECORDS_PER_PAGE + headSlot++;
+}
+
+void ScoreLog::startWrite(const ScoreRecord &record, uint16_t location)
+{
+    writeRecord = record;
+    writeLocation = location;
+    writeHalfWord = 0;
+    writing = true;
+    insert(record, location);
+}
+
+void ScoreLog::update(bool idle)
+{
+    // One leaderboard entry per frame keeps the dump from flooding the telemetry ring.
+    if (dumpCursor < entries)
+    {
+        const ScoreEntry &e = top[dumpCursor++];
+        telemetry.log(TM_SCORE_ENTRY, dumpCursor, e.sequence, e.total, e.presses, e.timeSec / 60, e.timeSec % 60);
+    }
+    else if (dumpCursor <= SCORE_TOP_K)
+    {
+        telemetry.log(TM_SCORE_END, lastSequence);
+        dumpCursor = SCORE_TOP_K + 1;
+    }
+
+    if (!writing && queued)
+    {
+        uint16_t location = allocate();
+        if (location != NO_LOCATION)
+        {
+            queued = false;
+            startWrite(queuedRecord, location);
+        }
+    }
+    if (writing)
+    {
+        // The sequence goes first and the CRC last: a reset part way leaves
+        // a slot that is neither blank nor valid, and the scan skips it.
+        const uint16_t *halfWords = (const uint16_t *)&writeRecord;
+        programHalfWord(writeLocation, writeHalfWord, halfWords[writeHalfWord]);
+        if (++writeHalfWord == RECORD_HALF_WORDS)
+        {
+            writing = false;
+        }
+        return;
+    }
+    if (idle && compactPage >= 0)
+    {
+        compactStep();
+    }
+}
+
+// One slot of the page being compacted per call; then the erase.
+void ScoreLog::compactStep()
+{
+    if (compactSlot < RECORDS_PER_PAGE)
+    {
+        uint16_t location = compactPage * RECORDS_PER_PAGE + compactSlot++;
+        const ScoreRecord *record = readSlot(location);
+        if (slotBlank(record))
+        {
+            return;
+        }
+        compactDirty = true;
+        if (!slotValid(record))
+        {
+            return;
+        }
+        for (uint8_t i = 0; i < entries; i++)
+        {
+            if (top[i].sequence == record->sequence && top[i].location == location)
+            {
+                // Still on the leaderboard: carry it to the head. With the
+                // head page full it is dropped from flash, not from the index.
+                uint16_t destination = allocate();
+                if (destination != NO_LOCATION)
+                {
+                    startWrite(*record, destination);
+                }
+                break;
+            }
+        }
+        return;
+    }
+    if (compactDirty)
+    {
+        erasePage(compactPage);
+    }
+    compactPage = -1;
+}
+
+void ScoreLog::clear()
+{
+    for (uint8_t page = 0; page < SCORE_LOG_PAGES; page++)
+    {
+        erasePage(page);
+    }
+    begin();
+}
@@ -0,0 +1,128 @@
+#include "SessionClock.h"
+#include "pins.h"
+
+SessionClock sessionClock;
+
+volatile uint32_t SessionClock::ticks = 0;
+
+#if defined(ARDUINO_ARCH_STM32) && defined(TIM4)
+#define SESSION_TICK_TIMER TIM4
+static const uint8_t SESSION_TICK_TIMER_NUMBER = 4;
+
+// The tick needs a timer of its own: a second HardwareTimer on it (tone()
+// creates one on TIMER_TONE, TIM6 here, at its first note; Servo uses
+// TIMER_SERVO, TIM7) takes over its interrupt and overflow. TIM4 drives
+// no pin of ours; the LED PWM is on TIM2/TIM3.
+static_assert(PwmChannel<RedPin>::timer != SESSION_TICK_TIMER_NUMBER &&
+                  PwmChannel<GreenPin>::timer != SESSION_TICK_TIMER_NUMBER &&
+                  PwmChannel<BluePin>::timer != SESSION_TICK_TIMER_NUMBER,
+              "An LED channel's PWM timer is the session tick timer");
+// Timers are pointer constants, which static_assert cannot compare; a call
+// left behind by a comparison that does not fold away fails the build.
+extern void sessionTickTimerIsShared() __attribute__((error("SessionClock's tick timer is TIMER_TONE or TIMER_SERVO")));
+
+static HardwareTimer *tickTimer = nullptr;
+#endif
+
+SessionClock::SessionClock()
+    : startTick(0), duration(0), frameTick(0), frameElapsed(0), pendingTotal(0), appliedTotal(0), ledgerLength(0)
+{
+    memset(perGame, 0, sizeof(perGame));
+}
+
+void SessionClock::onTick()
+{
+    ticks = ticks + 1;
+}
+
+void SessionClock::begin()
+{
+    // Start counting from millis() so event timestamps share the same base.
+    ticks = millis();
+#if defined(ARDUINO_ARCH_STM32) && defined(TIM4)
+#if defined(TIMER_TONE)
+    if (SESSION_TICK_TIMER == TIMER_TONE)
+    {
+        sessionTickTimerIsShared();
+    }
+#endif
+#if defined(TIMER_SERVO)
+    if (SESSION_TICK_TIMER == TIMER_SERVO)
+    {
+        sessionTickTimerIsShared();
+    }
+#endif
+    tickTimer = new HardwareTimer(SESSION_TICK_TIMER);
+    tickTimer->setOverflow(1000, HERTZ_FORMAT);
+    tickTimer->attachInterrupt(&SessionClock::onTick);
+    tickTimer->resume();
+#endif
+    frameTick = live();
+}
+
+uint32_t SessionClock::live() const
+{
+#if defined(ARDUINO_ARCH_STM32) && defined(TIM4)
+    return ticks;
+#else
+    return millis();
+#endif
+}
+
+void SessionClock::start(uint32_t durationMs)
+{
+    duration = durationMs;
+    startTick = frameTick;
+    frameElapsed = 0;
+    pendingTotal = 0;
+    appliedTotal = 0;
+    ledgerLength = 0;
+    memset(perGame, 0, sizeof(perGame));
+}
+
+void SessionClock::resume(uint32_t durationMs, uint32_t runningMs)
+{
+    start(durationMs);
+    startTick = frameTick - runningMs;
+    frameElapsed = runningMs;
+}
+
+void SessionClock::beginFrame()
+{
+    frameTick = live();
+    appliedTotal = pendingTotal;
+    int32_t elapsedMs = (int32_t)(frameTick - startTick) + appliedTotal;
+    frameElapsed = elapsedMs > 0 ? (uint32_t)elapsedMs : 0;
+}
+
+void SessionClock::addPenalty(uint8_t gameId, uint32_t ms)
+{
+    record(gameId, (int32_t)ms);
+}
+
+void SessionClock::addBonus(uint8_t gameId, uint32_t ms)
+{
+    record(gameId, -(int32_t)ms);
+}
+
+void SessionClock::record(uint8_t gameId, int32_t deltaMs)
+{
+    pendingTotal += deltaMs;
+    if (gameId < MAX_GAMES)
+    {
+        perGame[gameId] += deltaMs;
+    }
+    // The ledger keeps the first entries; totals stay exact when it is full.
+    if (ledgerLength < LEDGER_SIZE)
+    {
+        ledger[ledgerLength].gameId = gameId;
+        ledger[ledgerLength].deltaMs = deltaMs;
+        ledger[ledgerLength].atTick = frameTick;
+        ledgerLength++;
+    }
+}
+
+int32_t SessionClock::adjustmentFor(uint8_t gameId) const
+{
+    return gameId < MAX_GAMES ? perGame[gameId] : 0;
+}
@@ -0,0 +1,145 @@
+#include "Telemetry.h"
+
+// drain() can only hand the UART what fits in its TX buffer each frame.
+static_assert(SERIAL_TX_BUFFER_SIZE >= 256, "Serial TX buffer too small for telemetry, see platformio.ini");
+
+Telemetry telemetry;
+
+TelemetryRecord::TelemetryRecord(TelemetryEvent event, uint32_t timestamp) : length(0)
+{
+    bytes[length++] = event;
+    putVarint(timestamp);
+}
+
+bool TelemetryRecord::putVarint(uint64_t value)
+{
+    uint8_t start = length;
+    do
+    {
+        if (length == MAX_SIZE)
+        {
+            length = start;
+            return false;
+        }
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        bytes[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    return true;
+}
+
+void TelemetryRecord::add(int64_t value)
+{
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    putVarint(zigzag << 1);
+}
+
+void TelemetryRecord::add(const char *value)
+{
+    add((const uint8_t *)value, strlen(value));
+}
+
+void TelemetryRecord::add(const uint8_t *data, size_t count)
+{
+    uint8_t start = length;
+    if (!putVarint(((uint64_t)count << 1) | 1) || length + count > MAX_SIZE)
+    {
+        length = start;
+        return;
+    }
+    memcpy(bytes + length, data, count);
+    length += count;
+}
+
+Telemetry::Telemetry() : head(0), tail(0), droppedTotal(0), droppedUnreported(0) {}
+
+void Telemetry::begin(unsigned long baud)
+{
+    Serial.begin(baud);
+}
+
+uint16_t Telemetry::freeSpace() const
+{
+    uint16_t h = head.load(std::memory_order_relaxed);
+    uint16_t t = tail.load(std::memory_order_acquire);
+    return RING_SIZE - (uint16_t)(h - t);
+}
+
+void Telemetry::commit(const TelemetryRecord &record)
+{
+    // COBS adds one byte per 254 plus the leading code and the delimiter.
+    uint16_t needed = record.size() + record.size() / 254 + 2;
+    if (droppedUnreported > 0)
+    {
+        // Report drops ahead of the next record once both fit.
+        TelemetryRecord report(TM_DROPPED, millis());
+        report.add((int64_t)droppedUnreported);
+        uint16_t reportNeeded = report.size() + 2;
+        if (freeSpace() < needed + reportNeeded)
+        {
+            droppedTotal++;
+            droppedUnreported++;
+            return;
+        }
+        droppedUnreported = 0;
+        commit(report);
+    }
+    if (freeSpace() < needed)
+    {
+        droppedTotal++;
+        droppedUnreported++;
+        return;
+    }
+
+    uint16_t h = head.load(std::memory_order_relaxed);
+    const uint8_t *data = record.data();
+    uint8_t size = record.size();
+    // COBS: each block starts with the distance to the next zero.
+    uint16_t codeAt = h++;
+    uint8_t code = 1;
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (data[i] == 0)
+        {
+            ring[codeAt % RING_SIZE] = code;
+            codeAt = h++;
+            code = 1;
+            continue;
+        }
+        ring[h++ % RING_SIZE] = data[i];
+        if (++code == 0xFF)
+        {
+            ring[codeAt % RING_SIZE] = code;
+            codeAt = h++;
+            code = 1;
+        }
+    }
+    ring[codeAt % RING_SIZE] = code;
+    ring[h++ % RING_SIZE] = 0;
+    head.store(h, std::memory_order_release);
+}
+
+void Telemetry::drain()
+{
+    uint16_t t = tail.load(std::memory_order_relaxed);
+    uint16_t h = head.load(std::memory_order_acquire);
+    int room = Serial.availableForWrite();
+    while (t != h && room > 0)
+    {
+        // Write the contiguous part up to the end of the ring.
+        uint16_t start = t % RING_SIZE;
+        uint16_t count = (uint16_t)(h - t);
+        if (count > RING_SIZE - start)
+        {
+            count = RING_SIZE - start;
+        }
+        if (count > room)
+        {
+            count = room;
+        }
+        Serial.write(ring + start, count);
+        t += count;
+        room -= count;
+    }
+    tail.store(t, std::memory_order_release);
+}
@@ -0,0 +1,121 @@
+#include "Timeline.h"
+#include "LCD.h"
+#include "KeyLed.h"
+#include "RGBLed.h"
+#include "Buzzer.h"
+#include "Button.h"
+#include "Globals.h"
+
+const Cue SUCCESS_MELODY[8] = {
+    toneCue(0, 261, 200),
+    toneCue(400, 293, 100),
+    toneCue(650, 329, 100),
+    toneCue(900, 349, 100),
+    toneCue(1150, 392, 100),
+    toneCue(1400, 440, 100),
+    toneCue(1650, 493, 100),
+    toneCue(1900, 523, 200)};
+
+const Cue GAME_OVER_MELODY[8] = {
+    toneCue(0, 523, 100),
+    toneCue(150, 493, 100),
+    toneCue(300, 440, 100),
+    toneCue(450, 392, 100),
+    toneCue(600, 349, 100),
+    toneCue(750, 329, 100),
+    toneCue(900, 293, 100),
+    toneCue(1050, 261, 100)};
+
+const Cue WINNING_MELODY[8] = {
+    toneCue(0, 261, 100),
+    toneCue(150, 293, 100),
+    toneCue(300, 329, 100),
+    toneCue(450, 349, 100),
+    toneCue(600, 392, 100),
+    toneCue(750, 440, 100),
+    toneCue(900, 493, 100),
+    toneCue(1050, 523, 100)};
+
+const Cue ERROR_TONE[1] = {
+    toneCue(0, 300, 200)};
+
+TimelinePlayer::TimelinePlayer() : current(nullptr), startTime(0), firstPass(true), interrupted(false)
+{
+    memset(cursors, 0, sizeof(cursors));
+}
+
+void TimelinePlayer::play(const Timeline &timeline, uint32_t now)
+{
+    current = &timeline;
+    startTime = now;
+    firstPass = true;
+    interrupted = false;
+    memset(cursors, 0, sizeof(cursors));
+}
+
+bool TimelinePlayer::update(uint32_t now)
+{
+    if (current == nullptr)
+    {
+        return false;
+    }
+    uint32_t elapsed = now - startTime;
+    for (uint8_t t = 0; t < current->trackCount; t++)
+    {
+        const Track &track = current->tracks[t];
+        if (!firstPass && !track.repeats)
+        {
+            continue;
+        }
+        while (cursors[t] < track.count &&
+               track.cues[cursors[t]].atMs + track.offsetMs <= elapsed)
+        {
+            fire(track.cues[cursors[t]]);
+            cursors[t]++;
+        }
+    }
+    if (elapsed < current->lengthMs)
+    {
+        return true;
+    }
+    if (current->loops)
+    {
+        startTime += current->lengthMs;
+        firstPass = false;
+        memset(cursors, 0, sizeof(cursors));
+        return true;
+    }
+    current = nullptr;
+    return false;
+}
+
+void TimelinePlayer::interrupt()
+{
+    if (current != nullptr)
+    {
+        interrupted = true;
+        current = nullptr;
+    }
+}
+
+void TimelinePlayer::stop()
+{
+    current = nullptr;
+    interrupted = false;
+}
+
+void TimelinePlayer::fire(const Cue &cue)
+{
+    switch (cue.type)
+    {
+    case CUE_TEXT:
+        lcd.lcdShow(cue.line1, cue.line2);
+        break;
+    case CUE_COLOR:
+        rgb.setColor(cue.r, cue.g, cue.b);
+        break;
+    case CUE_TONE:
+        buzzer.queueTone(cue.frequency, cue.duration);
+        break;
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Helpers the test_native_* suites share: playing the firmware through
+// the host shim's pins and clock, reading where the session is, and the
+// per-suite budgets.json files. Include as "../HostTest.h".
+#include <Arduino.h>
+#include <HostArduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "../src/pins.h"
+#include "AppState.h"
+#include "GameRegistry.h"
+#include "EventBus.h"
+#include "Content.h"
+
+static const uint32_t FRAME_MS = 20;
+static const uint32_t GAME_TIMEOUT_MS = 120000;
+
+// Game2's hidden tune, from the compiled content pack (content/pack.json);
+// no puzzle config overrides it in these tests.
+static const char *const MELODY = contentText(CONTENT_GAME2_MELODY);
+
+// Run frames until done() holds; false if it does not within timeoutMs.
+template <typename Done>
+inline bool runUntil(Done done, uint32_t timeoutMs = GAME_TIMEOUT_MS)
+{
+    uint64_t end = hostClock.millis() + timeoutMs;
+    while (!done())
+    {
+        if (hostClock.millis() >= end)
+            return false;
+        hostRunFor(FRAME_MS);
+    }
+    return true;
+}
+
+inline void pressButton()
+{
+    hostPins.drive(PIN_BUTTON, LOW);
+    hostRunFor(100);
+    hostPins.drive(PIN_BUTTON, HIGH);
+    hostRunFor(100);
+}
+
+// Pot position that reads back as value after map(pot, 0, 1023, 0, range).
+inline void setPot(long value, long range)
+{
+    hostPins.setAnalog(PIN_POT, (int)((value * 1023 + range - 1) / range));
+}
+
+// Hold keys down (mask) the way KeyLed reports them, without the TM1638.
+inline void setKeys(uint8_t mask)
+{
+    Event event = makeEvent(EVENT_KEYS_CHANGED);
+    event.keys.mask = mask;
+    eventBus.publish(event);
+}
+
+inline uint8_t gameState()
+{
+    return PlayOrder::state(currentGame);
+}
+
+inline bool playing(uint8_t game)
+{
+    return currentState == STATE_GAME && currentGame == game;
+}
+
+// budgets.json next to testFile (pass __FILE__), or under test/ relative
+// to the project when built from there. Empty if there is none.
+inline std::string loadBudgets(const char *testFile)
+{
+    std::string dir = testFile;
+    dir = dir.substr(0, dir.find_last_of('/') + 1);
+    FILE *f = fopen((dir + "budgets.json").c_str(), "r");
+    if (f == nullptr)
+    {
+        std::string suite = dir.substr(0, dir.size() - 1);
+        suite = suite.substr(suite.find_last_of('/') + 1);
+        f = fopen(("test/" + suite + "/budgets.json").c_str(), "r");
+    }
+    std::string budgets;
+    if (f == nullptr)
+        return budgets;
+    char buffer[512];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        budgets.append(buffer, n);
+    fclose(f);
+    return budgets;
+}
+
+// Budget for metric of name, or NAN if there is none. The file is an
+// object of objects of numbers, so a plain scan finds it.
+inline double budget(const std::string &budgets, const char *name, const char *metric)
+{
+    size_t at = budgets.find(std::string("\"") + name + "\"");
+    if (at == std::string::npos)
+        return NAN;
+    size_t open = budgets.find('{', at);
+    size_t close = budgets.find('}', open);
+    size_t key = budgets.find(std::string("\"") + metric + "\"", open);
+    if (open == std::string::npos || key == std::string::npos || key > close)
+        return NAN;
+    size_t colon = budgets.find(':', key);
+    return strtod(budgets.c_str() + colon + 1, nullptr);
+}
+
+#endif
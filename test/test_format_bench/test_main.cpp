@@ -0,0 +1,105 @@
+// Formatting benchmark: Formatter against the sprintf calls it replaced,
+// in CPU cycles per call, with a check that both produce the same text.
+// Run on the board with
+// `pio test -e nucleo_f303re_bench -f test_format_bench`.
+//
+// Flash: this test links both, so compare `pio run -t size` on the main
+// firmware before and after the switch instead (newlib's vfprintf is no
+// longer linked once no call site uses it).
+#include <Arduino.h>
+#include <stdio.h>
+#include <unity.h>
+#include "Format.h"
+
+static const uint16_t ITERATIONS = 200;
+
+static void startCycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+template <typename Body>
+static uint32_t cyclesPerCall(const char *name, Body body)
+{
+    noInterrupts();
+    uint32_t start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < ITERATIONS; i++)
+    {
+        body(i);
+    }
+    uint32_t cycles = (DWT->CYCCNT - start) / ITERATIONS;
+    interrupts();
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(cycles);
+    Serial.println(" cycles");
+    return cycles;
+}
+
+// KeyLed::displayTime: "mmss" and a right-aligned press count.
+void test_display_time()
+{
+    static char expected[9], actual[9];
+    uint32_t slow = cyclesPerCall("sprintf %02d%02d%4d", [](uint16_t i) {
+        snprintf(expected, sizeof(expected), "%02d%02d%4d", (600 - i) / 60, (600 - i) % 60, i);
+    });
+    uint32_t fast = cyclesPerCall("Formatter time+number", [](uint16_t i) {
+        Formatter(actual, sizeof(actual)).time(600 - i, MMSS).number(i, rightAligned(4));
+    });
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+    TEST_ASSERT_LESS_THAN_UINT32(slow, fast);
+}
+
+// Game3's guess lines.
+void test_color_line()
+{
+    static char expected[17], actual[17];
+    uint32_t slow = cyclesPerCall("sprintf Lv:%d R:%03d", [](uint16_t i) {
+        snprintf(expected, sizeof(expected), "Lv:%d R:%03d", 1 + i % 3, (i * 32) % 256);
+    });
+    uint32_t fast = cyclesPerCall("Formatter Lv/R", [](uint16_t i) {
+        Formatter(actual, sizeof(actual)).text("Lv:").number(1 + i % 3).text(" R:").number((i * 32) % 256, PAD3);
+    });
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+    TEST_ASSERT_LESS_THAN_UINT32(slow, fast);
+}
+
+// Game3's serial debug line.
+void test_debug_line()
+{
+    static char expected[50], actual[50];
+    uint32_t slow = cyclesPerCall("sprintf Color to match", [](uint16_t i) {
+        snprintf(expected, sizeof(expected), "Color to match: R:%03d G:%03d B:%03d", i % 256, (i * 7) % 256, (i * 13) % 256);
+    });
+    uint32_t fast = cyclesPerCall("Formatter Color to match", [](uint16_t i) {
+        Formatter(actual, sizeof(actual)).text("Color to match: R:").number(i % 256, PAD3).text(" G:").number((i * 7) % 256, PAD3).text(" B:").number((i * 13) % 256, PAD3);
+    });
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+    TEST_ASSERT_LESS_THAN_UINT32(slow, fast);
+}
+
+// Truncation matches snprintf.
+void test_truncation()
+{
+    char expected[6], actual[6];
+    snprintf(expected, sizeof(expected), "Game %d Loading", 12);
+    Formatter(actual, sizeof(actual)).text("Game ").number(12).text(" Loading");
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+void setup()
+{
+    delay(2000);
+    Serial.begin(115200);
+    startCycleCounter();
+    UNITY_BEGIN();
+    RUN_TEST(test_display_time);
+    RUN_TEST(test_color_line);
+    RUN_TEST(test_debug_line);
+    RUN_TEST(test_truncation);
+    UNITY_END();
+}
+
+void loop() {}
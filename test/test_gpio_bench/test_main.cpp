@@ -0,0 +1,73 @@
+// GPIO microbenchmark: FastPin against the Arduino pin API, in CPU cycles
+// per call. Run on the board with
+// `pio test -e nucleo_f303re_bench -f test_gpio_bench`.
+#include <Arduino.h>
+#include <unity.h>
+#include "../../src/pins.h"
+
+static const uint16_t ITERATIONS = 1000;
+
+static void startCycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+template <typename Body>
+static uint32_t cyclesPerCall(const char *name, Body body)
+{
+    noInterrupts();
+    uint32_t start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < ITERATIONS; i++)
+    {
+        body(i);
+    }
+    uint32_t cycles = (DWT->CYCCNT - start) / ITERATIONS;
+    interrupts();
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(cycles);
+    Serial.println(" cycles");
+    return cycles;
+}
+
+void test_write()
+{
+    RedPin::output();
+    uint32_t arduino = cyclesPerCall("digitalWrite", [](uint16_t i) { digitalWrite(PIN_RED, i & 1); });
+    uint32_t fast = cyclesPerCall("RedPin::write", [](uint16_t i) { RedPin::write(i & 1); });
+    TEST_ASSERT_LESS_THAN_UINT32(arduino, fast);
+}
+
+void test_read()
+{
+    ButtonPin::inputPullup();
+    static volatile int sink;
+    uint32_t arduino = cyclesPerCall("digitalRead", [](uint16_t) { sink = digitalRead(PIN_BUTTON); });
+    uint32_t fast = cyclesPerCall("ButtonPin::read", [](uint16_t) { sink = ButtonPin::read(); });
+    TEST_ASSERT_LESS_THAN_UINT32(arduino, fast);
+}
+
+void test_pwm()
+{
+    PwmPin<RedPin>::begin();
+    uint32_t arduino = cyclesPerCall("analogWrite", [](uint16_t i) { analogWrite(PIN_RED, i & 0xFF); });
+    uint32_t fast = cyclesPerCall("PwmPin<RedPin>::write", [](uint16_t i) { PwmPin<RedPin>::write(i & 0xFF); });
+    PwmPin<RedPin>::write(0);
+    TEST_ASSERT_LESS_THAN_UINT32(arduino, fast);
+}
+
+void setup()
+{
+    delay(2000);
+    Serial.begin(115200);
+    startCycleCounter();
+    UNITY_BEGIN();
+    RUN_TEST(test_write);
+    RUN_TEST(test_read);
+    RUN_TEST(test_pwm);
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,333 @@
+// Loop-cost benchmarks on the host (env:native). Each benchmark puts the
+// unchanged firmware into one app or game state, feeds it representative
+// input and measures runFrame() (loop() without its frame delay) over a
+// run of frames: virtual time (blocking delays and waits), CPU
+// instructions where the kernel exposes a counter, and simulated bus
+// traffic, with the time the LCD's I2C transfers and the TM1638's
+// bit-banged transactions hold their buses (from the device models in
+// lib/HostArduino). Means per frame are checked against the budgets in
+// budgets.json next to this file and printed as one JSON line each for
+// tools/bench.py. Every benchmark runs in its own process so it starts
+// from a fresh boot. Run with `pio test -e native -f test_native_bench`.
+//
+// On the board the same states are measured by the DWT frame profiler
+// (env:nucleo_f303re_profile); see tools/bench.py target.
+#include <Hd44780Model.h>
+#include <Tm1638Model.h>
+#include <unity.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#include "../HostTest.h"
+#include "Game1.h"
+#include "Game2.h"
+#include "Game3.h"
+#include "Game4.h"
+
+void setup();
+void runFrame();
+void enterState(AppState state);
+
+static const uint32_t FRAME_DELAY_MS = 10; // loop()'s delay
+static const uint16_t FRAMES = 200;
+static const uint32_t SETTLE_TIMEOUT_MS = 60000;
+
+struct Metrics
+{
+    double virtualUs;
+    double instructions; // < 0 when no counter is available
+    double i2cBytes;
+    double pinWrites;
+    double lcdBusUs;
+    double keyLedBusUs;
+    double maxVirtualUs;
+    uint32_t frames;
+};
+
+// CPU instructions retired in user space, from the kernel's hardware
+// counter. Virtual machines and containers often have none.
+class InstructionCounter {
+public:
+    InstructionCounter()
+    {
+#if defined(__linux__)
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    bool available() const { return fd >= 0; }
+
+    uint64_t read() const
+    {
+        uint64_t count = 0;
+        if (fd >= 0 && ::read(fd, &count, sizeof(count)) != sizeof(count))
+            count = 0;
+        return count;
+    }
+
+private:
+    int fd = -1;
+};
+
+static Hd44780Model lcdModel;
+static Tm1638Model keyModel(StbPin::arduinoPin(), ClkPin::arduinoPin(), DioPin::arduinoPin());
+
+static void frame()
+{
+    runFrame();
+    hostClock.advanceMs(FRAME_DELAY_MS);
+}
+
+template <typename Done>
+static bool settle(Done done)
+{
+    uint64_t end = hostClock.millis() + SETTLE_TIMEOUT_MS;
+    while (!done())
+    {
+        if (hostClock.millis() >= end)
+            return false;
+        frame();
+    }
+    return true;
+}
+
+// Boot, then start game (0-based) the way the loading screen does.
+static bool startGame(uint8_t game, uint8_t state)
+{
+    setup();
+    currentGame = game;
+    enterState(STATE_GAME);
+    PlayOrder::begin(game);
+    return settle([&] { return currentState == STATE_GAME && gameState() == state; });
+}
+
+// Measure frames while stillIn() holds, calling input(i) before frame i.
+template <typename StillIn, typename Input>
+static Metrics measure(StillIn stillIn, Input input)
+{
+    InstructionCounter counter;
+    Metrics m = {0, counter.available() ? 0.0 : -1.0, 0, 0, 0, 0, 0, 0};
+    for (uint16_t i = 0; i < FRAMES && stillIn(); i++)
+    {
+        input(i);
+        uint64_t us = hostClock.micros();
+        HostBusCounters bus = hostBus;
+        BusCost lcdCost = lcdModel.cost();
+        BusCost keyCost = keyModel.cost();
+        uint64_t instructions = counter.read();
+        runFrame();
+        if (counter.available())
+            m.instructions += (double)(counter.read() - instructions);
+        double frameUs = (double)(hostClock.micros() - us);
+        m.virtualUs += frameUs;
+        m.maxVirtualUs = fmax(m.maxVirtualUs, frameUs);
+        m.i2cBytes += (double)(hostBus.i2cBytes - bus.i2cBytes);
+        m.pinWrites += (double)(hostBus.pinWrites - bus.pinWrites);
+        m.lcdBusUs += (double)(lcdModel.cost() - lcdCost).busUs;
+        m.keyLedBusUs += (double)(keyModel.cost() - keyCost).busUs;
+        m.frames++;
+        hostClock.advanceMs(FRAME_DELAY_MS);
+    }
+    if (m.frames > 0)
+    {
+        m.virtualUs /= m.frames;
+        if (m.instructions > 0)
+            m.instructions /= m.frames;
+        m.i2cBytes /= m.frames;
+        m.pinWrites /= m.frames;
+        m.lcdBusUs /= m.frames;
+        m.keyLedBusUs /= m.frames;
+    }
+    return m;
+}
+
+static void sweepPot(uint16_t i)
+{
+    hostPins.setAnalog(PIN_POT, (int)((i * 41) % 1024));
+}
+
+static void noInput(uint16_t) {}
+
+// Benchmarks; each returns frames measured in the named state.
+static Metrics benchIntro()
+{
+    setup();
+    return measure([] { return currentState == STATE_INTRO; }, noInput);
+}
+
+static Metrics benchLoading()
+{
+    setup();
+    currentGame = 1;
+    enterState(STATE_LOADING);
+    return measure([] { return currentState == STATE_LOADING; }, noInput);
+}
+
+static Metrics benchTimeUp()
+{
+    setup();
+    enterState(STATE_TIME_UP);
+    return measure([] { return currentState == STATE_TIME_UP; }, noInput);
+}
+
+static Metrics benchGameWon()
+{
+    setup();
+    enterState(STATE_GAME_WON);
+    return measure([] { return currentState == STATE_GAME_WON; }, noInput);
+}
+
+static Metrics benchGame1Play()
+{
+    if (!startGame(0, GAME1_PLAY))
+        return Metrics();
+    return measure([] { return gameState() == GAME1_PLAY; }, sweepPot);
+}
+
+static Metrics benchGame2Play()
+{
+    if (!startGame(1, GAME2_PLAY))
+        return Metrics();
+    // Tap through the keys, one tap every few frames.
+    return measure([] { return gameState() == GAME2_PLAY; },
+                   [](uint16_t i) { setKeys(i % 8 == 0 ? 1 << (i / 8 % 8) : 0); });
+}
+
+static Metrics benchGame3ShowColor()
+{
+    if (!startGame(2, GAME3_SHOW_COLOR))
+        return Metrics();
+    return measure([] { return gameState() == GAME3_SHOW_COLOR; }, noInput);
+}
+
+static Metrics benchGame3UserGuess()
+{
+    if (!startGame(2, GAME3_USER_GUESS))
+        return Metrics();
+    // Pick a channel now and then and dial it.
+    return measure([] { return gameState() == GAME3_USER_GUESS; },
+                   [](uint16_t i) {
+                       setKeys(i % 20 == 0 ? 1 << (i / 20 % 3) : 0);
+                       sweepPot(i);
+                   });
+}
+
+static Metrics benchGame4WaitForAnswer()
+{
+    if (!startGame(3, GAME4_WAIT_FOR_ANSWER))
+        return Metrics();
+    return measure([] { return gameState() == GAME4_WAIT_FOR_ANSWER; }, sweepPot);
+}
+
+// Run bench in a child process and get its metrics back through a pipe.
+static Metrics runIsolated(Metrics (*bench)())
+{
+    int fds[2];
+    Metrics m = Metrics();
+    if (pipe(fds) != 0)
+        return m;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        hostSerial.setOutput(nullptr);
+        lcdModel.attach();
+        keyModel.connect();
+        Metrics result = bench();
+        _exit(write(fds[1], &result, sizeof(result)) == (ssize_t)sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (read(fds[0], &m, sizeof(m)) != (ssize_t)sizeof(m))
+        m = Metrics();
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return m;
+}
+
+static std::string budgets;
+
+static void report(const char *name, const Metrics &m)
+{
+    char instructions[32];
+    if (m.instructions < 0)
+        snprintf(instructions, sizeof(instructions), "null");
+    else
+        snprintf(instructions, sizeof(instructions), "%.0f", m.instructions);
+    printf("BENCH {\"name\": \"%s\", \"frames\": %u, \"virtual_us\": %.1f, \"max_virtual_us\": %.0f, "
+           "\"instructions\": %s, \"i2c_bytes\": %.2f, \"pin_writes\": %.1f, \"lcd_bus_us\": %.1f, "
+           "\"keyled_bus_us\": %.1f}\n",
+           name, m.frames, m.virtualUs, m.maxVirtualUs, instructions, m.i2cBytes, m.pinWrites, m.lcdBusUs,
+           m.keyLedBusUs);
+}
+
+static void check(const char *name, const char *metric, double value)
+{
+    double limit = budget(budgets, name, metric);
+    if (isnan(limit) || value < 0)
+        return;
+    if (value > limit)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "%s %s: %.1f per frame, budget %.1f", name, metric, value, limit);
+        TEST_FAIL_MESSAGE(message);
+    }
+}
+
+static void runBench(const char *name, Metrics (*bench)())
+{
+    Metrics m = runIsolated(bench);
+    report(name, m);
+    TEST_ASSERT_TRUE(m.frames > 0);
+    check(name, "virtual_us", m.virtualUs);
+    check(name, "instructions", m.instructions);
+    check(name, "i2c_bytes", m.i2cBytes);
+    check(name, "pin_writes", m.pinWrites);
+    check(name, "lcd_bus_us", m.lcdBusUs);
+    check(name, "keyled_bus_us", m.keyLedBusUs);
+}
+
+#define BENCH(name, fn) \
+    void test_##name() { runBench(#name, fn); }
+
+BENCH(INTRO, benchIntro)
+BENCH(LOADING, benchLoading)
+BENCH(TIME_UP, benchTimeUp)
+BENCH(GAME_WON, benchGameWon)
+BENCH(GAME1_PLAY, benchGame1Play)
+BENCH(GAME2_PLAY, benchGame2Play)
+BENCH(GAME3_SHOW_COLOR, benchGame3ShowColor)
+BENCH(GAME3_USER_GUESS, benchGame3UserGuess)
+BENCH(GAME4_WAIT_FOR_ANSWER, benchGame4WaitForAnswer)
+
+int main(int argc, char **argv)
+{
+    budgets = loadBudgets(__FILE__);
+    UNITY_BEGIN();
+    TEST_ASSERT_FALSE(budgets.empty());
+    RUN_TEST(test_INTRO);
+    RUN_TEST(test_LOADING);
+    RUN_TEST(test_TIME_UP);
+    RUN_TEST(test_GAME_WON);
+    RUN_TEST(test_GAME1_PLAY);
+    RUN_TEST(test_GAME2_PLAY);
+    RUN_TEST(test_GAME3_SHOW_COLOR);
+    RUN_TEST(test_GAME3_USER_GUESS);
+    RUN_TEST(test_GAME4_WAIT_FOR_ANSWER);
+    return UNITY_END();
+}
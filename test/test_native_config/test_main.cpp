@@ -0,0 +1,239 @@
+// Puzzle config blobs on the host (env:native): the parser's checks, and
+// uploads over the console into the flash stand-in during the intro, the
+// way tools/puzzle_config.py sends them. A fresh PuzzleConfig that runs
+// begin() is a reboot. Run with `pio test -e native`.
+#include <Arduino.h>
+#include <HostArduino.h>
+#include <unity.h>
+#include "AppState.h"
+#include "PuzzleConfig.h"
+#include "Crc.h"
+
+void setup();
+
+static const uint32_t FRAME_MS = 20;
+
+// Builds a blob the way the host tool does.
+class BlobBuilder {
+public:
+    BlobBuilder() : size(sizeof(ConfigBlobHeader)), entries(0) { memset(blob, 0, sizeof(blob)); }
+
+    BlobBuilder &raw(uint8_t key, uint8_t type, const void *value, uint16_t length)
+    {
+        ConfigEntryHeader entry = {key, type, length};
+        memcpy(blob + size, &entry, sizeof(entry));
+        memcpy(blob + size + sizeof(entry), value, length);
+        size += sizeof(entry) + ((length + 3u) & ~3u);
+        entries++;
+        return *this;
+    }
+    BlobBuilder &number(ConfigKey key, int32_t value) { return raw(key, CONFIG_TYPE_NUMBER, &value, sizeof(value)); }
+    BlobBuilder &text(ConfigKey key, const char *value) { return raw(key, CONFIG_TYPE_TEXT, value, strlen(value) + 1); }
+    // Items separated by '|'.
+    BlobBuilder &list(ConfigKey key, const char *items)
+    {
+        char value[256];
+        uint16_t length = strlen(items) + 1;
+        memcpy(value, items, length);
+        for (uint16_t i = 0; i < length; i++)
+        {
+            if (value[i] == '|')
+                value[i] = 0;
+        }
+        return raw(key, CONFIG_TYPE_LIST, value, length);
+    }
+
+    const uint8_t *finish()
+    {
+        ConfigBlobHeader header = {CONFIG_MAGIC, CONFIG_FORMAT_VERSION, entries, size, 0};
+        header.crc = crc32(blob + sizeof(header), size - sizeof(header));
+        memcpy(blob, &header, sizeof(header));
+        return blob;
+    }
+
+    uint8_t blob[512];
+    uint32_t size;
+    uint16_t entries;
+};
+
+static ConfigError mapped(BlobBuilder &builder)
+{
+    ConfigView view;
+    return view.map(builder.finish(), builder.size);
+}
+
+// 'c', the length, then chunks paced by the board's frames.
+static void upload(const uint8_t *blob, uint32_t length)
+{
+    TEST_ASSERT_EQUAL(STATE_INTRO, currentState);
+    hostSerial.feed('c');
+    for (uint8_t i = 0; i < 4; i++)
+        hostSerial.feed((uint8_t)(length >> (8 * i)));
+    hostRunFor(FRAME_MS);
+    for (uint32_t sent = 0; sent < length; sent++)
+    {
+        hostSerial.feed(blob[sent]);
+        if ((sent + 1) % PuzzleConfig::CHUNK_SIZE == 0)
+            hostRunFor(FRAME_MS);
+    }
+    hostRunFor(FRAME_MS);
+    TEST_ASSERT_FALSE(puzzleConfig.uploading());
+}
+
+static void upload(BlobBuilder &builder)
+{
+    upload(builder.finish(), builder.size);
+}
+
+void test_parser_checks_blobs()
+{
+    BlobBuilder good;
+    good.number(CFG_GAME3_TOLERANCE, 20).text(CFG_GAME2_MELODY, "12345678").list(CFG_GAME2_TIPS, "a|b|c");
+    TEST_ASSERT_EQUAL(CONFIG_OK, mapped(good));
+
+    BlobBuilder corrupt;
+    corrupt.number(CFG_GAME3_TOLERANCE, 20).finish();
+    corrupt.blob[sizeof(ConfigBlobHeader) + 4] ^= 1;
+    ConfigView view;
+    TEST_ASSERT_EQUAL(CONFIG_BAD_CHECKSUM, view.map(corrupt.blob, corrupt.size));
+    TEST_ASSERT_FALSE(view.mapped());
+    TEST_ASSERT_EQUAL(CONFIG_BAD_HEADER, view.map(good.blob, good.size - 4));
+
+    int32_t value = 20;
+    BlobBuilder pastEnd;
+    pastEnd.raw(CFG_GAME3_TOLERANCE, CONFIG_TYPE_NUMBER, &value, sizeof(value));
+    pastEnd.entries = 2;
+    TEST_ASSERT_EQUAL(CONFIG_BAD_ENTRY, mapped(pastEnd));
+
+    BlobBuilder wrongType;
+    wrongType.raw(CFG_GAME3_TOLERANCE, CONFIG_TYPE_TEXT, "20", 3);
+    TEST_ASSERT_EQUAL(CONFIG_BAD_ENTRY, mapped(wrongType));
+
+    BlobBuilder twice;
+    twice.number(CFG_GAME3_TOLERANCE, 20).number(CFG_GAME3_TOLERANCE, 30);
+    TEST_ASSERT_EQUAL(CONFIG_BAD_ENTRY, mapped(twice));
+
+    BlobBuilder outOfRange;
+    outOfRange.number(CFG_GAME3_TOLERANCE, 65);
+    TEST_ASSERT_EQUAL(CONFIG_BAD_VALUE, mapped(outOfRange));
+
+    BlobBuilder offStep;
+    offStep.number(CFG_GAME2_PENALTY_MS, 1500);
+    TEST_ASSERT_EQUAL(CONFIG_BAD_VALUE, mapped(offStep));
+
+    BlobBuilder unterminated;
+    unterminated.raw(CFG_GAME2_MELODY, CONFIG_TYPE_TEXT, "1234", 4);
+    TEST_ASSERT_EQUAL(CONFIG_BAD_VALUE, mapped(unterminated));
+
+    BlobBuilder longItem;
+    longItem.list(CFG_GAME2_TIPS, "short|seventeen chars!!");
+    TEST_ASSERT_EQUAL(CONFIG_BAD_VALUE, mapped(longItem));
+
+    BlobBuilder manyItems;
+    manyItems.list(CFG_GAME2_TIPS, "1|2|3|4|5|6|7|8|9");
+    TEST_ASSERT_EQUAL(CONFIG_BAD_VALUE, mapped(manyItems));
+
+    // Keys from a newer tool are skipped.
+    BlobBuilder newer;
+    newer.raw(CONFIG_KEY_COUNT, CONFIG_TYPE_NUMBER, &value, sizeof(value)).number(CFG_GAME3_TOLERANCE, 20);
+    TEST_ASSERT_EQUAL(CONFIG_OK, view.map(newer.finish(), newer.size));
+    TEST_ASSERT_EQUAL(1, view.keys());
+    TEST_ASSERT_EQUAL(20, view.number(CFG_GAME3_TOLERANCE, 0));
+}
+
+void test_defaults_without_config()
+{
+    TEST_ASSERT_EQUAL(0, (int)puzzleConfig.generation());
+    TEST_ASSERT_EQUAL(123, puzzleConfig.number(CFG_SESSION_TIME_MS, 123));
+    TEST_ASSERT_EQUAL_STRING("tip", puzzleConfig.item(CFG_GAME2_TIPS, 0, "tip"));
+}
+
+void test_upload_applies()
+{
+    BlobBuilder builder;
+    builder.number(CFG_SESSION_TIME_MS, 1800000)
+        .number(CFG_GAME3_TOLERANCE, 20)
+        .list(CFG_GAME2_TIPS, "Do|Re|Mi|Fa|So|La|Ti|Do!")
+        .text(CFG_GAME4_ANSWERS, "ABC");
+    TEST_ASSERT_TRUE(builder.size > PuzzleConfig::CHUNK_SIZE);
+    upload(builder);
+
+    TEST_ASSERT_EQUAL(1, (int)puzzleConfig.generation());
+    TEST_ASSERT_EQUAL(1800000, puzzleConfig.number(CFG_SESSION_TIME_MS, 0));
+    TEST_ASSERT_EQUAL(20, puzzleConfig.number(CFG_GAME3_TOLERANCE, 0));
+    TEST_ASSERT_EQUAL(8, puzzleConfig.items(CFG_GAME2_TIPS));
+    TEST_ASSERT_EQUAL_STRING("Do!", puzzleConfig.item(CFG_GAME2_TIPS, 7, ""));
+    TEST_ASSERT_EQUAL_STRING("ABC", puzzleConfig.text(CFG_GAME4_ANSWERS, ""));
+    // Absent keys keep their compiled values.
+    TEST_ASSERT_EQUAL(500, puzzleConfig.number(CFG_GAME1_CONFIRM_MS, 500));
+}
+
+void test_second_upload_switches_slot()
+{
+    BlobBuilder builder;
+    builder.number(CFG_GAME3_TOLERANCE, 5);
+    upload(builder);
+    TEST_ASSERT_EQUAL(2, (int)puzzleConfig.generation());
+    TEST_ASSERT_EQUAL(5, puzzleConfig.number(CFG_GAME3_TOLERANCE, 0));
+    TEST_ASSERT_EQUAL(7, puzzleConfig.number(CFG_SESSION_TIME_MS, 7));
+
+    PuzzleConfig rebooted;
+    rebooted.begin();
+    TEST_ASSERT_EQUAL(2, (int)rebooted.generation());
+    TEST_ASSERT_EQUAL(5, rebooted.number(CFG_GAME3_TOLERANCE, 0));
+}
+
+void test_bad_upload_keeps_config()
+{
+    BlobBuilder builder;
+    builder.number(CFG_GAME3_TOLERANCE, 40).finish();
+    builder.blob[builder.size - 1] ^= 0xFF;
+    upload(builder.blob, builder.size);
+    TEST_ASSERT_EQUAL(2, (int)puzzleConfig.generation());
+    TEST_ASSERT_EQUAL(5, puzzleConfig.number(CFG_GAME3_TOLERANCE, 0));
+
+    PuzzleConfig rebooted;
+    rebooted.begin();
+    TEST_ASSERT_EQUAL(2, (int)rebooted.generation());
+    TEST_ASSERT_EQUAL(5, rebooted.number(CFG_GAME3_TOLERANCE, 0));
+}
+
+void test_upload_refused_during_a_game()
+{
+    puzzleConfig.startUpload(false);
+    for (uint8_t i = 0; i < 4; i++)
+        puzzleConfig.receive(i == 0 ? 32 : 0);
+    TEST_ASSERT_FALSE(puzzleConfig.uploading());
+    TEST_ASSERT_EQUAL(2, (int)puzzleConfig.generation());
+}
+
+void test_stalled_upload_times_out()
+{
+    hostSerial.feed('c');
+    hostSerial.feed((uint8_t)32);
+    hostRunFor(FRAME_MS);
+    TEST_ASSERT_TRUE(puzzleConfig.uploading());
+    hostRunFor(PuzzleConfig::UPLOAD_TIMEOUT_MS + FRAME_MS * 2);
+    TEST_ASSERT_FALSE(puzzleConfig.uploading());
+
+    // The console is back to commands, and the next upload goes through.
+    BlobBuilder builder;
+    builder.number(CFG_GAME3_TOLERANCE, 9);
+    upload(builder);
+    TEST_ASSERT_EQUAL(3, (int)puzzleConfig.generation());
+    TEST_ASSERT_EQUAL(9, puzzleConfig.number(CFG_GAME3_TOLERANCE, 0));
+}
+
+int main(int argc, char **argv)
+{
+    setup();
+    UNITY_BEGIN();
+    RUN_TEST(test_parser_checks_blobs);
+    RUN_TEST(test_defaults_without_config);
+    RUN_TEST(test_upload_applies);
+    RUN_TEST(test_second_upload_switches_slot);
+    RUN_TEST(test_bad_upload_keeps_config);
+    RUN_TEST(test_upload_refused_during_a_game);
+    RUN_TEST(test_stalled_upload_times_out);
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+// Input-to-feedback latency on the host (env:native_latency, which builds
+// the firmware with -DLATENCY_PROBE). Plays a full session the way the
+// session test does, with the button on its pin and the keys pressed
+// through the TM1638 model's key scan, while the firmware's latency probe
+// matches each input to its first LCD, LED, tone or RGB output on the
+// virtual clock. p50/p99/max per state are printed as one JSON line each
+// for tools/bench.py and checked against budgets.json next to this file.
+// Run with `pio test -e native_latency`.
+#include <Hd44780Model.h>
+#include <Tm1638Model.h>
+#include <unity.h>
+#include "../HostTest.h"
+#include "GameArena.h"
+#include "Latency.h"
+#include "Game1.h"
+#include "Game2.h"
+#include "Game3.h"
+#include "Game4.h"
+
+void setup();
+
+// Slot names, as in tools/bench.py and the budgets.
+static const char *const APP_STATE_NAMES[] = {"INTRO", "GAME", "LOADING", "TIME_UP", "GAME_WON"};
+static const char *const GAME_STATE_NAMES[PROFILE_GAMES][PROFILE_GAME_STATES] = {
+    {"GAME1_INIT", "GAME1_PLAY", "GAME1_COMPLETE", "GAME1_TIME_UP"},
+    {"GAME2_INIT", "GAME2_PLAY", "GAME2_WRONG", "GAME2_COMPLETE", "GAME2_TIME_UP"},
+    {"GAME3_INIT", "GAME3_SHOW_COLOR", "GAME3_USER_GUESS", "GAME3_VALIDATE", "GAME3_SUCCESS", "GAME3_LEVEL_UP",
+     "GAME3_FAIL"},
+    {"GAME4_INIT", "GAME4_SHOW_QUESTION", "GAME4_WAIT_FOR_ANSWER", "GAME4_WRONG", "GAME4_SUCCESS",
+     "GAME4_COMPLETE", "GAME4_TIME_UP"}};
+
+static Hd44780Model lcdModel;
+static Tm1638Model keyModel(StbPin::arduinoPin(), ClkPin::arduinoPin(), DioPin::arduinoPin());
+
+static void playSession()
+{
+    hostRunFor(500);
+    pressButton(); // Skip the intro
+
+    TEST_ASSERT_TRUE(runUntil([] { return playing(0) && gameState() == GAME1_PLAY; }));
+    Game1Data &data1 = gameArena.get<Game1Data>();
+    for (int step = 0; step < NUM_LEVELS; step++)
+    {
+        setPot(data1.combo[step], 3600);
+        pressButton();
+        TEST_ASSERT_TRUE(runUntil([&] { return !playing(0) || data1.currentStep > step || gameState() != GAME1_PLAY; }));
+    }
+
+    TEST_ASSERT_TRUE(runUntil([] { return playing(1) && gameState() == GAME2_PLAY; }));
+    for (const char *note = MELODY; *note; note++)
+    {
+        keyModel.setKeys(1 << (*note - '1'));
+        hostRunFor(200);
+        keyModel.setKeys(0);
+        hostRunFor(200);
+    }
+    pressButton();
+
+    TEST_ASSERT_TRUE(runUntil([] { return playing(2); }));
+    Game3Data &data3 = gameArena.get<Game3Data>();
+    while (playing(2))
+    {
+        TEST_ASSERT_TRUE(runUntil([] { return !playing(2) || gameState() == GAME3_USER_GUESS; }));
+        if (!playing(2))
+            break;
+        const int target[3] = {data3.targetRed, data3.targetGreen, data3.targetBlue};
+        for (uint8_t channel = 0; channel < 3; channel++)
+        {
+            keyModel.setKeys(1 << channel);
+            hostRunFor(FRAME_MS * 2);
+            keyModel.setKeys(0);
+            setPot((target[channel] + 16) / 32, 9);
+            hostRunFor(100);
+        }
+        pressButton();
+        TEST_ASSERT_TRUE(runUntil([] { return !playing(2) || gameState() == GAME3_SHOW_COLOR; }));
+    }
+
+    TEST_ASSERT_TRUE(runUntil([] { return playing(3); }));
+    while (runUntil([] { return !playing(3) || gameState() == GAME4_WAIT_FOR_ANSWER; }) && playing(3))
+    {
+        for (int option = 0; option < 5; option++)
+        {
+            setPot(option, 5);
+            hostRunFor(600);
+            pressButton();
+            TEST_ASSERT_TRUE(runUntil([] { return !playing(3) || gameState() != GAME4_WAIT_FOR_ANSWER; }));
+            if (gameState() != GAME4_WRONG)
+                break;
+            TEST_ASSERT_TRUE(runUntil([] { return gameState() == GAME4_WAIT_FOR_ANSWER; }));
+        }
+        TEST_ASSERT_TRUE(runUntil([] { return !playing(3) || gameState() != GAME4_SUCCESS; }));
+    }
+    TEST_ASSERT_TRUE(runUntil([] { return currentState == STATE_GAME_WON; }));
+    hostRunFor(3000);
+}
+
+static const char *slotName(uint8_t slot)
+{
+    if (slot < PROFILE_APP_STATES)
+        return APP_STATE_NAMES[slot];
+    uint8_t index = slot - PROFILE_APP_STATES;
+    return GAME_STATE_NAMES[index / PROFILE_GAME_STATES][index % PROFILE_GAME_STATES];
+}
+
+static std::string budgets;
+
+static void check(const char *name, const char *metric, double value)
+{
+    double limit = budget(budgets, name, metric);
+    if (!isnan(limit) && value > limit)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "%s %s: %.0f us, budget %.0f", name, metric, value, limit);
+        TEST_FAIL_MESSAGE(message);
+    }
+}
+
+void test_session_latencies()
+{
+    lcdModel.attach();
+    keyModel.connect();
+    hostSerial.setOutput(nullptr);
+    setup();
+    playSession();
+
+    uint32_t samples = 0;
+    for (uint8_t slot = 0; slot < LATENCY_SLOT_COUNT; slot++)
+    {
+        const LatencyStats &s = latency.stats(slot);
+        if (s.count == 0 && s.unanswered == 0)
+            continue;
+        const char *name = slotName(slot);
+        uint32_t p50 = latency.percentile(slot, 50);
+        uint32_t p99 = latency.percentile(slot, 99);
+        printf("LATENCY {\"name\": \"%s\", \"count\": %u, \"p50_us\": %u, \"p99_us\": %u, \"max_us\": %u, "
+               "\"unanswered\": %u}\n",
+               name ? name : "?", (unsigned)s.count, (unsigned)p50, (unsigned)p99, (unsigned)s.max,
+               (unsigned)s.unanswered);
+        samples += s.count;
+        if (name != nullptr)
+        {
+            check(name, "p50_us", p50);
+            check(name, "p99_us", p99);
+            check(name, "max_us", s.max);
+        }
+    }
+    TEST_ASSERT_TRUE(samples > 20);
+}
+
+int main(int argc, char **argv)
+{
+    budgets = loadBudgets(__FILE__);
+    UNITY_BEGIN();
+    TEST_ASSERT_FALSE(budgets.empty());
+    RUN_TEST(test_session_latencies);
+    return UNITY_END();
+}
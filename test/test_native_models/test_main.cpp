@@ -0,0 +1,168 @@
+// Display and key models on the host (env:native). The firmware drives a
+// behavioural HD44780 behind its PCF8574 backpack and a bit-level TM1638;
+// the tests read the screens back from the models' memories, press keys
+// through the TM1638's key scan, and check the bus costs the models
+// count. Run with `pio test -e native`.
+#include <Hd44780Model.h>
+#include <Tm1638Model.h>
+#include <unity.h>
+#include "../HostTest.h"
+#include "LCD.h"
+#include "KeyLed.h"
+#include "RGBLed.h"
+#include "Buzzer.h"
+#include "Button.h"
+#include "Globals.h"
+#include "SessionClock.h"
+#include "Game2.h"
+#include "Telemetry.h"
+#include "Timeline.h"
+
+void setup();
+void enterState(AppState state);
+
+static Hd44780Model lcdModel;
+static Tm1638Model keyModel(StbPin::arduinoPin(), ClkPin::arduinoPin(), DioPin::arduinoPin());
+
+static std::string padded(const char *text)
+{
+    std::string line = text;
+    line.resize(16, ' ');
+    return line;
+}
+
+void test_lcd_shows_intro()
+{
+    lcdModel.attach();
+    keyModel.connect();
+    setup();
+    hostRunFor(FRAME_MS);
+    TEST_ASSERT_TRUE(lcdModel.fourBitMode());
+    TEST_ASSERT_TRUE(lcdModel.twoLines());
+    TEST_ASSERT_TRUE(lcdModel.displayOn());
+    TEST_ASSERT_FALSE(lcdModel.cursorOn());
+    TEST_ASSERT_TRUE(lcdModel.backlight());
+    TEST_ASSERT_EQUAL_STRING(padded("New Adventure").c_str(), lcdModel.line(0).c_str());
+    TEST_ASSERT_EQUAL_STRING(padded("has begun!").c_str(), lcdModel.line(1).c_str());
+
+    TEST_ASSERT_TRUE(runUntil([] { return lcdModel.line(0) == padded("Have Fun"); }));
+    TEST_ASSERT_EQUAL_STRING(padded("Good Luck!").c_str(), lcdModel.line(1).c_str());
+}
+
+void test_lcd_never_outruns_the_controller()
+{
+    TEST_ASSERT_TRUE(lcdModel.instructions() > 0);
+    TEST_ASSERT_EQUAL(0, (int)lcdModel.busyViolations());
+}
+
+void test_keyled_shows_time()
+{
+    TEST_ASSERT_TRUE(keyModel.displayOn());
+    TEST_ASSERT_EQUAL(0, (int)keyModel.protocolErrors());
+    // Into Game2: the 7-segment display counts the session down.
+    currentGame = 1;
+    enterState(STATE_GAME);
+    PlayOrder::begin(1);
+    TEST_ASSERT_TRUE(runUntil([] { return PlayOrder::state(1) == GAME2_PLAY; }));
+    hostRunFor(FRAME_MS);
+    // MMSS of the last frame's snapshot, then the press count.
+    unsigned long seconds = sessionClock.remaining() / 1000;
+    char expected[16];
+    snprintf(expected, sizeof(expected), "%02lu%02lu   0", seconds / 60, seconds % 60);
+    TEST_ASSERT_EQUAL_STRING(expected, keyModel.text().c_str());
+}
+
+void test_keys_go_through_the_scan()
+{
+    uint64_t scans = keyModel.keyScans();
+    keyModel.setKeys(1 << 3);
+    hostRunFor(200);
+    TEST_ASSERT_TRUE(keyModel.keyScans() > scans);
+    TEST_ASSERT_TRUE(keyModel.led(3));
+    TEST_ASSERT_FALSE(keyModel.led(2));
+    TEST_ASSERT_EQUAL_STRING(padded("Tip for note 2").c_str(), lcdModel.line(0).c_str());
+    keyModel.setKeys(0);
+    hostRunFor(200);
+    TEST_ASSERT_FALSE(keyModel.led(3));
+    TEST_ASSERT_EQUAL(0, (int)keyModel.protocolErrors());
+}
+
+void test_bus_costs()
+{
+    // All I2C traffic is the LCD's.
+    TEST_ASSERT_EQUAL((double)hostBus.i2cBytes, (double)lcdModel.cost().bytes);
+    TEST_ASSERT_EQUAL((double)hostBus.i2cTransmissions, (double)lcdModel.cost().transactions);
+
+    // One screen: clear, two cursor moves and 32 characters, each byte two
+    // 3-byte nibble transfers at 100 kHz (29 clocks, 290 us).
+    BusCost before = lcdModel.cost();
+    lcd.lcdShow("0123456789ABCDEF", "0123456789ABCDEF");
+    BusCost screen = lcdModel.cost() - before;
+    TEST_ASSERT_EQUAL(35 * 2, (int)screen.transactions);
+    TEST_ASSERT_EQUAL(35 * 2 * 3, (int)screen.bytes);
+    TEST_ASSERT_EQUAL(35 * 2 * 290, (int)screen.busUs);
+    TEST_ASSERT_EQUAL_STRING("0123456789ABCDEF", lcdModel.line(1).c_str());
+
+    // A key scan: the command byte out and four bytes in, 2 us a bit.
+    before = keyModel.cost();
+    keyLed.readButtons();
+    BusCost scan = keyModel.cost() - before;
+    TEST_ASSERT_EQUAL(1, (int)scan.transactions);
+    TEST_ASSERT_EQUAL(5, (int)scan.bytes);
+    TEST_ASSERT_TRUE(scan.busUs >= 5 * 8 * 2 && scan.busUs < 5 * 8 * 4);
+}
+
+// Cue times past 65535 ms.
+void test_long_timeline()
+{
+    static const Cue CUES[] = {textCue(0, "Start", ""), textCue(70000, "Seventy", "")};
+    static const Track TRACKS[] = {track(CUES, 1000)};
+    static const Timeline LONG_SCENE = timeline(TRACKS, 80000);
+    TimelinePlayer player;
+    player.play(LONG_SCENE, 0);
+    TEST_ASSERT_TRUE(player.update(1000));
+    TEST_ASSERT_EQUAL_STRING(padded("Start").c_str(), lcdModel.line(0).c_str());
+    TEST_ASSERT_TRUE(player.update(70999));
+    TEST_ASSERT_EQUAL_STRING(padded("Start").c_str(), lcdModel.line(0).c_str());
+    TEST_ASSERT_TRUE(player.update(71000));
+    TEST_ASSERT_EQUAL_STRING(padded("Seventy").c_str(), lcdModel.line(0).c_str());
+    TEST_ASSERT_TRUE(player.update(79999));
+    TEST_ASSERT_FALSE(player.update(80000));
+}
+
+void test_serial_tx_buffer()
+{
+    // The UART sends a byte in ten bit times at the telemetry baud rate.
+    hostRunFor(FRAME_MS);
+    TEST_ASSERT_EQUAL(SERIAL_TX_BUFFER_SIZE - 1, Serial.availableForWrite());
+    uint8_t block[100] = {0};
+    Serial.write(block, sizeof(block));
+    TEST_ASSERT_EQUAL(SERIAL_TX_BUFFER_SIZE - 1 - 100, Serial.availableForWrite());
+    hostClock.advance(100 * 10000000ULL / TELEMETRY_BAUD + 1);
+    TEST_ASSERT_EQUAL(SERIAL_TX_BUFFER_SIZE - 1, Serial.availableForWrite());
+
+    // A busy frame's telemetry leaves in one drain, not 63 bytes of it.
+    uint64_t before = hostSerial.bytesWritten();
+    for (uint8_t i = 0; i < 12; i++)
+        telemetry.log(TM_SECTION, "a section title of some length");
+    telemetry.drain();
+    uint64_t drained = hostSerial.bytesWritten() - before;
+    TEST_ASSERT_TRUE(drained > 400);
+    hostClock.advance(drained * 10000000ULL / TELEMETRY_BAUD + 1);
+    telemetry.drain();
+    TEST_ASSERT_EQUAL((double)drained, (double)(hostSerial.bytesWritten() - before));
+    TEST_ASSERT_EQUAL(0, (int)hostSerial.blockedUs());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lcd_shows_intro);
+    RUN_TEST(test_lcd_never_outruns_the_controller);
+    RUN_TEST(test_keyled_shows_time);
+    RUN_TEST(test_keys_go_through_the_scan);
+    RUN_TEST(test_bus_costs);
+    RUN_TEST(test_long_timeline);
+    RUN_TEST(test_serial_tx_buffer);
+    return UNITY_END();
+}
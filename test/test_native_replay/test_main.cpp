@@ -0,0 +1,183 @@
+// Input trace record and replay on the host (env:native). A child process
+// records a session (Game1 played through the pot and button, then a pot
+// sweep and a few presses) as TM_INPUT_TRACE telemetry; fresh child
+// processes then replay the trace and must end in the same state with no
+// divergent frame. Each run gets its own process so the firmware's
+// globals start clean. Run with `pio test -e native`.
+#include <unity.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "../HostTest.h"
+#include "GameArena.h"
+#include "InputTrace.h"
+#include "Telemetry.h"
+#include "Game1.h"
+
+void setup();
+void loop();
+
+static const uint32_t RECORD_MS = 150000;
+
+static std::vector<uint8_t> trace;
+static int recordedEnd = -1;
+
+// Run body in a child process and return its exit code.
+template <typename Body>
+static int inChild(Body body)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        _exit(body());
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static int endState()
+{
+    return currentState * 8 + currentGame;
+}
+
+static int record(FILE *out)
+{
+    hostSerial.setOutput(out);
+    inputTrace.startRecording();
+    setup();
+    hostRunFor(500);
+    pressButton(); // Skip the intro
+    while (!(playing(0) && PlayOrder::state(0) == GAME1_PLAY))
+        hostRunFor(FRAME_MS);
+    Game1Data &data = gameArena.get<Game1Data>();
+    for (int step = 0; step < NUM_LEVELS; step++)
+    {
+        // Sweep onto the combo the way a hand would, then press.
+        int target = (int)((data.combo[step] * 1023L + 3599) / 3600);
+        for (int pot = 0; pot <= target; pot += 37)
+        {
+            hostPins.setAnalog(PIN_POT, pot);
+            hostRunFor(FRAME_MS);
+        }
+        hostPins.setAnalog(PIN_POT, target);
+        hostRunFor(FRAME_MS);
+        pressButton();
+        while (playing(0) && data.currentStep <= step && PlayOrder::state(0) == GAME1_PLAY)
+            hostRunFor(FRAME_MS);
+    }
+    while (hostClock.millis() < RECORD_MS)
+    {
+        hostPins.setAnalog(PIN_POT, (int)(hostClock.millis() / 7 % 1024));
+        hostRunFor(FRAME_MS);
+        if (hostClock.millis() % 5000 < FRAME_MS)
+            pressButton();
+    }
+    inputTrace.flush();
+    telemetry.drain();
+    fflush(out);
+    return endState();
+}
+
+static uint64_t readVarint(const std::vector<uint8_t> &data, size_t &pos)
+{
+    uint64_t value = 0;
+    for (int shift = 0; pos < data.size(); shift += 7)
+    {
+        uint8_t byte = data[pos++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            break;
+    }
+    return value;
+}
+
+// Pull the chunk bytes out of the TM_INPUT_TRACE records in a capture.
+static void extractTrace(FILE *in)
+{
+    std::vector<uint8_t> frame;
+    int c;
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c != 0)
+        {
+            frame.push_back((uint8_t)c);
+            continue;
+        }
+        // COBS decode
+        std::vector<uint8_t> record;
+        for (size_t i = 0; i < frame.size();)
+        {
+            uint8_t code = frame[i];
+            record.insert(record.end(), frame.begin() + i + 1, frame.begin() + std::min(frame.size(), i + code));
+            i += code;
+            if (code < 0xFF && i < frame.size())
+                record.push_back(0);
+        }
+        frame.clear();
+        if (record.empty() || record[0] != TM_INPUT_TRACE)
+            continue;
+        size_t pos = 1;
+        readVarint(record, pos);                 // Timestamp
+        readVarint(record, pos);                 // Sequence
+        size_t length = readVarint(record, pos) >> 1;
+        trace.insert(trace.end(), record.begin() + pos, record.begin() + pos + length);
+    }
+}
+
+static int replay(const std::vector<uint8_t> &data)
+{
+    hostSerial.setOutput(nullptr);
+    inputTrace.startReplay(data.data(), data.size());
+    setup();
+    uint32_t frameTime;
+    while (inputTrace.prepareFrame(frameTime))
+    {
+        uint64_t start = (uint64_t)frameTime * 1000;
+        if (hostClock.micros() < start)
+            hostClock.advance(start - hostClock.micros());
+        loop();
+    }
+    if (inputTrace.divergences() > 0)
+        return 100;
+    return inputTrace.frames() > RECORD_MS / 20 ? endState() : 101;
+}
+
+void test_record_session()
+{
+    FILE *capture = tmpfile();
+    TEST_ASSERT_NOT_NULL(capture);
+    recordedEnd = inChild([&] { return record(capture); });
+    // Game1 was won, so the session got past it.
+    TEST_ASSERT_TRUE(recordedEnd >= 0 && recordedEnd % 8 >= 1);
+    rewind(capture);
+    extractTrace(capture);
+    fclose(capture);
+    TEST_ASSERT_TRUE(trace.size() > 100);
+    TEST_ASSERT_EQUAL(INPUT_RECORD_SEED, trace[0] & 0x07);
+}
+
+void test_replay_reproduces_states()
+{
+    TEST_ASSERT_FALSE(trace.empty());
+    TEST_ASSERT_EQUAL(recordedEnd, inChild([] { return replay(trace); }));
+}
+
+void test_replay_detects_divergence()
+{
+    TEST_ASSERT_FALSE(trace.empty());
+    // Another seed means other combos, so the recorded presses miss.
+    std::vector<uint8_t> tampered = trace;
+    tampered[1] ^= 0x5A;
+    TEST_ASSERT_EQUAL(100, inChild([&] { return replay(tampered); }));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_record_session);
+    RUN_TEST(test_replay_reproduces_states);
+    RUN_TEST(test_replay_detects_divergence);
+    return UNITY_END();
+}
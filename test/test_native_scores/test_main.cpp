@@ -0,0 +1,171 @@
+// Flash score log on the host (env:native). The log's flash stand-in
+// keeps flash semantics, and a fresh ScoreLog that runs begin() over it
+// is a reboot. Run with `pio test -e native`.
+#include <Arduino.h>
+#include <unity.h>
+#include "ScoreLog.h"
+
+// Enough update() calls to write a record and compact a page.
+static const int SETTLE_UPDATES = ScoreLog::RECORDS_PER_PAGE * 3;
+
+static ScoreRecord result(int32_t total, uint16_t timeSec = 300)
+{
+    ScoreRecord record;
+    memset(&record, 0, sizeof(record));
+    record.total = total;
+    record.scores[0] = total;
+    record.presses = 10;
+    record.timeSec = timeSec;
+    return record;
+}
+
+static void settle(ScoreLog &log)
+{
+    for (int i = 0; i < SETTLE_UPDATES; i++)
+        log.update(true);
+    TEST_ASSERT_FALSE(log.busy());
+}
+
+static uint32_t sessionsAfterReboot()
+{
+    ScoreLog rebooted;
+    rebooted.begin();
+    return rebooted.sessions();
+}
+
+void setUp()
+{
+    scoreLog.clear();
+}
+
+void tearDown() {}
+
+void test_empty_log()
+{
+    TEST_ASSERT_EQUAL(0, (int)scoreLog.count());
+    TEST_ASSERT_EQUAL(0, (int)scoreLog.sessions());
+    TEST_ASSERT_EQUAL(0, (int)sessionsAfterReboot());
+}
+
+void test_append_writes_one_half_word_per_update()
+{
+    uint32_t sequence = scoreLog.append(result(500));
+    TEST_ASSERT_EQUAL(1, (int)sequence);
+    TEST_ASSERT_EQUAL(1, (int)scoreLog.rankOf(sequence));
+    TEST_ASSERT_TRUE(scoreLog.busy());
+    TEST_ASSERT_EQUAL(0, (int)scoreLog.append(result(600)));
+
+    // A record is 16 half-words; the CRC lands with the last one.
+    for (uint8_t i = 0; i < sizeof(ScoreRecord) / 2 - 1; i++)
+    {
+        scoreLog.update(false);
+        TEST_ASSERT_EQUAL(0, (int)sessionsAfterReboot());
+    }
+    scoreLog.update(false);
+    TEST_ASSERT_FALSE(scoreLog.busy());
+    TEST_ASSERT_EQUAL(1, (int)sessionsAfterReboot());
+}
+
+void test_torn_record_is_skipped()
+{
+    scoreLog.append(result(400));
+    settle(scoreLog);
+    scoreLog.append(result(100));
+    for (int i = 0; i < 5; i++)
+        scoreLog.update(false);
+
+    ScoreLog rebooted;
+    rebooted.begin();
+    TEST_ASSERT_EQUAL(1, (int)rebooted.sessions());
+    TEST_ASSERT_EQUAL(400, rebooted.entry(0).total);
+    uint32_t sequence = rebooted.append(result(200));
+    TEST_ASSERT_EQUAL(2, (int)sequence);
+    settle(rebooted);
+
+    ScoreLog again;
+    again.begin();
+    TEST_ASSERT_EQUAL(2, (int)again.count());
+    TEST_ASSERT_EQUAL(200, again.entry(0).total);
+    TEST_ASSERT_EQUAL(400, again.entry(1).total);
+}
+
+void test_leaderboard_keeps_the_best()
+{
+    const int32_t totals[] = {900, 300, 700, 100, 500, 800, 200};
+    uint32_t worst = 0;
+    for (int32_t total : totals)
+    {
+        uint32_t sequence = scoreLog.append(result(total));
+        if (total == 900)
+            worst = sequence;
+        settle(scoreLog);
+    }
+    const int32_t expected[SCORE_TOP_K] = {100, 200, 300, 500, 700};
+    TEST_ASSERT_EQUAL(SCORE_TOP_K, (int)scoreLog.count());
+    TEST_ASSERT_EQUAL(0, (int)scoreLog.rankOf(worst));
+
+    ScoreLog rebooted;
+    rebooted.begin();
+    TEST_ASSERT_EQUAL(7, (int)rebooted.sessions());
+    for (uint8_t rank = 0; rank < SCORE_TOP_K; rank++)
+    {
+        TEST_ASSERT_EQUAL(expected[rank], scoreLog.entry(rank).total);
+        TEST_ASSERT_EQUAL(expected[rank], rebooted.entry(rank).total);
+    }
+
+    // Ties go to the quicker session.
+    scoreLog.append(result(100, 200));
+    settle(scoreLog);
+    TEST_ASSERT_EQUAL(200, scoreLog.entry(0).timeSec);
+    TEST_ASSERT_EQUAL(300, scoreLog.entry(1).timeSec);
+}
+
+void test_leaderboard_survives_wrapping()
+{
+    // Twice round the ring: every page is compacted and erased.
+    const uint32_t sessions = 2 * SCORE_LOG_PAGES * ScoreLog::RECORDS_PER_PAGE + 10;
+    scoreLog.append(result(1));
+    settle(scoreLog);
+    for (uint32_t i = 1; i < sessions; i++)
+    {
+        TEST_ASSERT_TRUE(scoreLog.append(result(1000 + i)) != 0);
+        settle(scoreLog);
+    }
+
+    ScoreLog rebooted;
+    rebooted.begin();
+    TEST_ASSERT_EQUAL(sessions, rebooted.sessions());
+    TEST_ASSERT_EQUAL(SCORE_TOP_K, (int)rebooted.count());
+    TEST_ASSERT_EQUAL(1, rebooted.entry(0).total);
+    TEST_ASSERT_EQUAL(1, (int)rebooted.entry(0).sequence);
+    for (uint8_t rank = 1; rank < SCORE_TOP_K; rank++)
+        TEST_ASSERT_EQUAL(1000 + rank, rebooted.entry(rank).total);
+}
+
+void test_compaction_waits_for_idle()
+{
+    // Fill the head page without idle time: the next result waits, since
+    // the head cannot move onto a page that has not been compacted.
+    for (uint32_t i = 0; i <= ScoreLog::RECORDS_PER_PAGE; i++)
+    {
+        TEST_ASSERT_TRUE(scoreLog.append(result(100 + i)) != 0);
+        for (int j = 0; j < SETTLE_UPDATES; j++)
+            scoreLog.update(false);
+    }
+    TEST_ASSERT_TRUE(scoreLog.busy());
+    TEST_ASSERT_EQUAL(ScoreLog::RECORDS_PER_PAGE, (int)sessionsAfterReboot());
+    settle(scoreLog);
+    TEST_ASSERT_EQUAL(ScoreLog::RECORDS_PER_PAGE + 1, (int)sessionsAfterReboot());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_log);
+    RUN_TEST(test_append_writes_one_half_word_per_update);
+    RUN_TEST(test_torn_record_is_skipped);
+    RUN_TEST(test_leaderboard_keeps_the_best);
+    RUN_TEST(test_leaderboard_survives_wrapping);
+    RUN_TEST(test_compaction_waits_for_idle);
+    return UNITY_END();
+}
@@ -0,0 +1,189 @@
+// Scripted full session on the host (env:native): boots the unchanged
+// firmware on the virtual clock and plays all four games through the
+// simulated pot, button and keys, reading each game's state from the
+// game arena the way a player would read the LCD. Ten minutes of play run
+// in well under a second. Run with `pio test -e native`.
+#include <unity.h>
+#include "../HostTest.h"
+#include "GameArena.h"
+#include "SessionClock.h"
+#include "Analytics.h"
+#include "ScoreLog.h"
+#include "HeapGuard.h"
+#include "Telemetry.h"
+#include "Game1.h"
+#include "Game2.h"
+#include "Game3.h"
+#include "Game4.h"
+
+void setup();
+extern int totalScore;
+
+static uint32_t mergesBeforePlay;
+
+void play_game1()
+{
+    TEST_ASSERT_TRUE(runUntil([] { return playing(0) && gameState() == GAME1_PLAY; }));
+    mergesBeforePlay = analytics.merges();
+    Game1Data &data = gameArena.get<Game1Data>();
+    for (int step = 0; step < NUM_LEVELS; step++)
+    {
+        setPot(data.combo[step], 3600);
+        pressButton();
+        TEST_ASSERT_TRUE(runUntil([&] { return !playing(0) || data.currentStep > step || gameState() != GAME1_PLAY; }));
+    }
+    TEST_ASSERT_TRUE(runUntil([] { return !playing(0); }));
+}
+
+void play_game2()
+{
+    TEST_ASSERT_TRUE(runUntil([] { return playing(1) && gameState() == GAME2_PLAY; }));
+    for (const char *note = MELODY; *note; note++)
+    {
+        setKeys(1 << (*note - '1'));
+        hostRunFor(200);
+        setKeys(0);
+        hostRunFor(200);
+    }
+    pressButton();
+    TEST_ASSERT_TRUE(runUntil([] { return !playing(1); }));
+}
+
+void play_game3()
+{
+    TEST_ASSERT_TRUE(runUntil([] { return playing(2); }));
+    Game3Data &data = gameArena.get<Game3Data>();
+    while (playing(2))
+    {
+        // The target shows, then hides after a few seconds.
+        TEST_ASSERT_TRUE(runUntil([] { return !playing(2) || gameState() == GAME3_USER_GUESS; }));
+        if (!playing(2))
+            break;
+        const int target[3] = {data.targetRed, data.targetGreen, data.targetBlue};
+        for (uint8_t channel = 0; channel < 3; channel++)
+        {
+            setKeys(1 << channel);
+            hostRunFor(FRAME_MS);
+            setKeys(0);
+            setPot((target[channel] + 16) / 32, 9);
+            hostRunFor(100);
+        }
+        pressButton();
+        TEST_ASSERT_TRUE(runUntil([] { return !playing(2) || gameState() != GAME3_USER_GUESS; }));
+        TEST_ASSERT_NOT_EQUAL(GAME3_FAIL, gameState());
+        TEST_ASSERT_TRUE(runUntil([] { return !playing(2) || gameState() == GAME3_SHOW_COLOR; }));
+    }
+}
+
+// No answer key: try A..E until one is right, like a guessing player.
+void play_game4()
+{
+    TEST_ASSERT_TRUE(runUntil([] { return playing(3); }));
+    while (runUntil([] { return !playing(3) || gameState() == GAME4_WAIT_FOR_ANSWER; }) && playing(3))
+    {
+        for (int option = 0; option < 5; option++)
+        {
+            setPot(option, 5);
+            hostRunFor(600); // The option line refreshes every 500 ms
+            pressButton();
+            TEST_ASSERT_TRUE(runUntil([] { return !playing(3) || gameState() != GAME4_WAIT_FOR_ANSWER; }));
+            if (gameState() != GAME4_WRONG)
+                break;
+            TEST_ASSERT_TRUE(runUntil([] { return gameState() == GAME4_WAIT_FOR_ANSWER; }));
+        }
+        TEST_ASSERT_TRUE(runUntil([] { return !playing(3) || gameState() != GAME4_SUCCESS; }));
+    }
+}
+
+void test_session_is_won()
+{
+    TEST_ASSERT_TRUE(runUntil([] { return currentState == STATE_GAME_WON; }));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, sessionClock.remaining());
+    // Not one heap allocation from the end of setup() through the session.
+    TEST_ASSERT_TRUE(heapGuard.isLocked());
+    TEST_ASSERT_EQUAL_UINT32(0, heapGuard.afterLock());
+    // Every record made it through the modelled UART, traces included
+    // under env:native_trace, and none of the writes had to wait.
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.dropped());
+    TEST_ASSERT_EQUAL(0, (int)hostSerial.blockedUs());
+}
+
+void test_analytics_recorded()
+{
+    const AnalyticsData &data = analytics.data();
+    TEST_ASSERT_EQUAL_UINT16(1, data.sessions);
+    TEST_ASSERT_EQUAL_UINT16(1, data.sessionsWon);
+    for (uint8_t game = 0; game < PlayOrder::count; game++)
+    {
+        TEST_ASSERT_EQUAL_UINT16(1, data.games[game].completions);
+        TEST_ASSERT_EQUAL_UINT16(0, data.games[game].timeUps);
+    }
+    // One flash merge, after the session: none stalled a game frame.
+    TEST_ASSERT_EQUAL_UINT32(mergesBeforePlay + 1, analytics.merges());
+}
+
+void test_score_logged()
+{
+    TEST_ASSERT_EQUAL(1, (int)scoreLog.sessions());
+    TEST_ASSERT_EQUAL(1, (int)scoreLog.rankOf(1));
+    TEST_ASSERT_EQUAL(totalScore, scoreLog.entry(0).total);
+    hostRunFor(1000);
+    TEST_ASSERT_FALSE(scoreLog.busy());
+}
+
+// The zero above means something: the host hook does see the firmware's
+// allocations.
+void test_heap_hook_counts()
+{
+    uint32_t before = heapGuard.afterLock();
+    {
+        HostFirmwareScope firmware;
+        void *volatile block = malloc(24);
+        free(block);
+        int *volatile value = new int(1);
+        delete value;
+    }
+    void *volatile own = malloc(24); // The test's own: not counted
+    free(own);
+    TEST_ASSERT_EQUAL_UINT32(before + 2, heapGuard.afterLock());
+}
+
+static void countPress(const Event &event, void *context)
+{
+    (*static_cast<uint32_t *>(context))++;
+}
+
+// A bounce with more edges than the input queue holds loses the last one;
+// the button still ends up on the pin's level.
+void test_bounce_overflowing_the_queue()
+{
+    uint32_t presses = 0;
+    eventBus.subscribe(EVENT_BIT(EVENT_BUTTON_PRESSED), &countPress, &presses);
+    uint32_t overflows = eventBus.inputOverflows();
+    for (uint8_t edge = 0; edge <= EventBus::INPUT_QUEUE_SIZE; edge++)
+        hostPins.drive(PIN_BUTTON, edge % 2 == 0 ? LOW : HIGH);
+    TEST_ASSERT_EQUAL_UINT32(overflows + 1, eventBus.inputOverflows());
+    hostRunFor(200);
+    TEST_ASSERT_EQUAL_UINT32(1, presses);
+    hostPins.drive(PIN_BUTTON, HIGH);
+    hostRunFor(200);
+    pressButton();
+    TEST_ASSERT_EQUAL_UINT32(2, presses);
+    eventBus.unsubscribe(&presses);
+}
+
+int main(int argc, char **argv)
+{
+    setup();
+    UNITY_BEGIN();
+    RUN_TEST(play_game1);
+    RUN_TEST(play_game2);
+    RUN_TEST(play_game3);
+    RUN_TEST(play_game4);
+    RUN_TEST(test_session_is_won);
+    RUN_TEST(test_analytics_recorded);
+    RUN_TEST(test_score_logged);
+    RUN_TEST(test_heap_hook_counts);
+    RUN_TEST(test_bounce_overflowing_the_queue);
+    return UNITY_END();
+}
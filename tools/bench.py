@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""Run the loop-cost and latency benchmarks and check them against their budgets.
+
+Budgets live in test/test_native_bench/budgets.json: for each app or game
+state (INTRO, GAME1_PLAY, ...) the allowed mean cost of one frame.
+Latency budgets, in test/test_native_latency/budgets.json, bound the
+p50/p99/max input-to-feedback latency of each state.
+
+    native   runs test/test_native_bench on the host: virtual_us (blocking
+             time), instructions (where the kernel has a counter),
+             i2c_bytes, pin_writes, and the bus time of the LCD's I2C
+             transfers and the TM1638's transactions (lcd_bus_us,
+             keyled_bus_us) from the host's device models, per frame
+    target   reads a frame profile from a PROFILING build
+             (env:nucleo_f303re_profile): mean DWT cycles of each visited
+             state's update, checked as target_cycles. Target budgets are
+             added with --update from a run on the board.
+    latency  input-to-feedback latency per state from the LATENCY_PROBE
+             host session (test/test_native_latency), or with --target
+             from a board running env:nucleo_f303re_latency
+
+    python3 tools/bench.py native -o bench_native.json
+    python3 tools/bench.py target /dev/ttyACM0 --seconds 300 -o bench_target.json
+    python3 tools/bench.py target capture.bin            # a saved capture with a dump
+    python3 tools/bench.py native --update               # re-base the budgets
+    python3 tools/bench.py latency
+    python3 tools/bench.py latency --target /dev/ttyACM0 --seconds 600
+
+Exits non-zero when any benchmark is over budget. --update writes the
+measured values plus --headroom into the budgets instead.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import subprocess
+import sys
+import time
+
+from telemetry_decode import ROOT, cobs_decode, frames, load_events, open_source, parse_record
+
+BUDGETS = os.path.join(ROOT, "test", "test_native_bench", "budgets.json")
+LATENCY_BUDGETS = os.path.join(ROOT, "test", "test_native_latency", "budgets.json")
+NATIVE_METRICS = ["virtual_us", "instructions", "i2c_bytes", "pin_writes", "lcd_bus_us", "keyled_bus_us"]
+LATENCY_METRICS = ["p50_us", "p99_us", "max_us"]
+ENUM_RE = re.compile(r"enum\s+(\w+)\s*(?::\s*\w+\s*)?\{([^}]*)\}", re.S)
+
+
+def load_budgets(path):
+    with open(path, encoding="utf-8") as f:
+        return json.load(f)
+
+
+def save_budgets(budgets, path):
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump(budgets, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+
+def enum_names(header, enum):
+    """Enumerator names of enum in include/<header>, in value order."""
+    with open(os.path.join(ROOT, "include", header), encoding="utf-8") as f:
+        for name, body in ENUM_RE.findall(f.read()):
+            if name == enum:
+                body = re.sub(r"//[^\n]*", "", body)
+                return [item.split("=")[0].strip() for item in body.split(",") if item.strip()]
+    return []
+
+
+def run_host(args, environment, test, tag):
+    """Return {name: metrics} from a host test's `tag {json}` lines."""
+    if args.binary:
+        command = [args.binary]
+    else:
+        command = ["pio", "test", "-e", environment, "-f", test, "-v"]
+    process = subprocess.run(command, cwd=ROOT, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    results = {}
+    for line in process.stdout.splitlines():
+        at = line.find(tag + " {")
+        if at >= 0:
+            entry = json.loads(line[at + len(tag) + 1:])
+            results[entry.pop("name")] = entry
+    if not results:
+        sys.stdout.write(process.stdout)
+        raise SystemExit("no benchmark results (exit %d)" % process.returncode)
+    return results
+
+
+def profile_names():
+    """Map the profiler's slot labels to state names."""
+    names = {}
+    for index, state in enumerate(enum_names("AppState.h", "AppState")):
+        if state != "STATE_COUNT":
+            names["app state %d" % index] = state.replace("STATE_", "", 1)
+    for game in range(1, 5):
+        for index, state in enumerate(enum_names("Game%d.h" % game, "Game%dState" % game)):
+            names["game %d state %d" % (game, index)] = state
+    return names
+
+
+def read_dump(source_name, seconds, command, slot_name, end_name, entry):
+    """Return {name: metrics} from a dump of slot_name records, made
+    into metrics by entry(fields). A live board is reset and run for
+    seconds first, then sent command."""
+    events = [name for name, _ in load_events()]
+    slot_event, end_event = events.index(slot_name), events.index(end_name)
+    source = open_source(source_name)
+    if hasattr(source, "in_waiting"):
+        # Live board: clear the statistics, let the session run, then dump.
+        source.write(b"r")
+        print("measuring for %d s..." % seconds, file=sys.stderr)
+        deadline = time.time() + seconds
+        while time.time() < deadline:
+            source.read(source.in_waiting or 1)
+        source.write(command)
+    names = profile_names()
+    results = {}
+    for frame in frames(source):
+        try:
+            event, _, fields = parse_record(cobs_decode(frame))
+        except ValueError:
+            continue
+        if event == slot_event and fields and fields[0] in names:
+            results[names[fields[0]]] = entry(fields)
+        elif event == end_event:
+            break
+    return results
+
+
+def run_target(args):
+    """Return {name: metrics} from a frame profile dump."""
+    results = read_dump(args.source, args.seconds, b"p", "TM_PROFILE_SLOT", "TM_PROFILE_END",
+                        lambda f: {"frames": f[1], "min_cycles": f[2], "target_cycles": f[3], "max_cycles": f[4]})
+    if not results:
+        raise SystemExit("no profile dump in %s (is it a PROFILING build?)" % args.source)
+    return results
+
+
+def run_latency(args):
+    """Return {name: metrics} from the host session or a board's dump."""
+    if not args.target:
+        return run_host(args, "native_latency", "test_native_latency", "LATENCY")
+    results = read_dump(args.target, args.seconds, b"l", "TM_LATENCY_SLOT", "TM_LATENCY_END",
+                        lambda f: {"count": f[1], "p50_us": f[2], "p99_us": f[3], "max_us": f[4],
+                                   "unanswered": f[5]})
+    if not results:
+        raise SystemExit("no latency dump in %s (is it a LATENCY_PROBE build?)" % args.target)
+    return results
+
+
+def check(results, budgets, metrics):
+    """Return the list of over-budget lines and print a table."""
+    failures = []
+    print("%-24s %-14s %14s %14s" % ("benchmark", "metric", "measured", "budget"))
+    for name in sorted(results):
+        for metric in metrics:
+            value = results[name].get(metric)
+            limit = budgets.get(name, {}).get(metric)
+            if value is None:
+                continue
+            status = ""
+            if limit is None:
+                status = "  (no budget)"
+            elif value > limit:
+                status = "  OVER BUDGET"
+                failures.append("%s %s: %.1f > %.1f" % (name, metric, value, limit))
+            print("%-24s %-14s %14.1f %14s%s" % (name, metric, value, "-" if limit is None else "%.1f" % limit,
+                                                 status))
+    return failures
+
+
+def update(results, budgets, metrics, headroom, path):
+    for name, values in results.items():
+        for metric in metrics:
+            if values.get(metric) is not None:
+                budgets.setdefault(name, {})[metric] = math.ceil(values[metric] * headroom)
+    save_budgets(budgets, path)
+    print("budgets updated: %s" % os.path.relpath(path))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    native = commands.add_parser("native", help="host benchmarks")
+    native.add_argument("--binary", help="prebuilt test program instead of `pio test`")
+    target = commands.add_parser("target", help="frame profile from the board")
+    target.add_argument("source", help="serial port of a PROFILING build, or a capture file")
+    target.add_argument("--seconds", type=int, default=120, help="how long to profile a live board")
+    latency = commands.add_parser("latency", help="input-to-feedback latency")
+    latency.add_argument("--binary", help="prebuilt test program instead of `pio test`")
+    latency.add_argument("--target", help="serial port of a LATENCY_PROBE build, or a capture file")
+    latency.add_argument("--seconds", type=int, default=300, help="how long to measure a live board")
+    for command in (native, target, latency):
+        command.add_argument("-o", "--output", help="write the results as JSON")
+        command.add_argument("--update", action="store_true", help="re-base the budgets on this run")
+        command.add_argument("--headroom", type=float, default=1.25, help="budget = measured * headroom")
+    args = parser.parse_args()
+
+    path = BUDGETS
+    if args.command == "native":
+        results, metrics = run_host(args, "native", "test_native_bench", "BENCH"), NATIVE_METRICS
+    elif args.command == "target":
+        results, metrics = run_target(args), ["target_cycles"]
+    else:
+        results, metrics, path = run_latency(args), LATENCY_METRICS, LATENCY_BUDGETS
+    budgets = load_budgets(path)
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump({"kind": args.command, "results": results}, f, indent=2, sort_keys=True)
+            f.write("\n")
+    if args.update:
+        update(results, budgets, metrics, args.headroom, path)
+        return
+    failures = check(results, budgets, metrics)
+    if failures:
+        print("\n%d benchmark(s) over budget:" % len(failures), file=sys.stderr)
+        for line in failures:
+            print("  " + line, file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
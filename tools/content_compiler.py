@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""Compile the puzzle content pack into flash tables.
+
+content/pack.json holds the text and colours the games show: the intro
+screens, Game1's briefing, Game2's melody and tips, Game3's palettes per
+level, and Game4's questions (a CSV file the pack names). This script
+checks every entry against what the hardware can show and writes
+
+    include/Content.h        constexpr tables of string offsets, colours
+                             and questions
+    src/utils/Content.cpp    the string pool they index
+
+Strings are stored once: duplicates, and strings that end another one,
+share its bytes. Offsets are 16-bit, so a table entry costs two bytes
+instead of a four-byte pointer, and everything is constant data that
+stays in flash. The games' counts (tips, levels, options, questions)
+are read from the firmware headers and the screen counts match the
+scenes' timings, so a pack that does not fit fails here rather than in
+a static_assert.
+
+An over-long string is an error, never truncated. PlatformIO runs this
+before every build (extra_scripts in platformio.ini) and stops the build
+on an error; it only rewrites the outputs when they change. By hand:
+
+    python3 tools/content_compiler.py            # check and regenerate
+    python3 tools/content_compiler.py --check    # fail if the outputs are stale
+"""
+
+import argparse
+import csv
+import json
+import os
+import re
+import sys
+
+LCD_COLUMNS = 16
+OPTION_PREFIX = len("A: ")  # Game4 shows an option after its letter
+CHANNEL_MAX = 255
+
+CONSTANT_RE = re.compile(r"^\s*const\s+int\s+(\w+)\s*=\s*(\d+)\s*;")
+
+
+class ContentError(Exception):
+    pass
+
+
+def read_constants(root, *headers):
+    """Return {name: value} of the `const int` lines in the headers."""
+    constants = {}
+    for header in headers:
+        with open(os.path.join(root, "include", header), encoding="utf-8") as f:
+            for line in f:
+                match = CONSTANT_RE.match(line)
+                if match:
+                    constants[match.group(1)] = int(match.group(2))
+    return constants
+
+
+def check_text(where, text, columns=LCD_COLUMNS):
+    if not isinstance(text, str):
+        raise ContentError("%s: %r is not a string" % (where, text))
+    data = text.encode("utf-8")
+    if len(data) > columns:
+        raise ContentError("%s: %r is %d columns, the limit is %d" % (where, text, len(data), columns))
+    if any(byte < 0x20 for byte in data):
+        raise ContentError("%s: %r has a control character" % (where, text))
+    return data
+
+
+def check_count(where, items, count):
+    if not isinstance(items, list) or len(items) != count:
+        raise ContentError("%s: expected %d entries" % (where, count))
+
+
+def check_screens(where, screens, count):
+    check_count(where, screens, count)
+    for i, screen in enumerate(screens):
+        check_count("%s[%d]" % (where, i), screen, 2)
+        for line, text in enumerate(screen):
+            check_text("%s[%d] line %d" % (where, i, line + 1), text)
+    return screens
+
+
+def load_questions(path, options):
+    questions = []
+    with open(path, encoding="utf-8", newline="") as f:
+        rows = list(csv.reader(f))
+    name = os.path.basename(path)
+    if not rows or rows[0] != ["question"] + [chr(ord("A") + o) for o in range(options)] + ["answer"]:
+        raise ContentError("%s: header must be question, A..%s, answer" % (name, chr(ord("A") + options - 1)))
+    for line, row in enumerate(rows[1:], start=2):
+        where = "%s:%d" % (name, line)
+        if len(row) != options + 2:
+            raise ContentError("%s: expected %d columns" % (where, options + 2))
+        check_text(where + " question", row[0])
+        for o in range(options):
+            check_text("%s option %s" % (where, chr(ord("A") + o)), row[1 + o], LCD_COLUMNS - OPTION_PREFIX)
+        answer = row[-1].strip()
+        if len(answer) != 1 or not 0 <= ord(answer) - ord("A") < options:
+            raise ContentError("%s: answer %r is not a letter A-%s" % (where, answer, chr(ord("A") + options - 1)))
+        questions.append((row[0], row[1:1 + options], ord(answer) - ord("A")))
+    if not questions:
+        raise ContentError("%s: no questions" % name)
+    return questions
+
+
+def load_pack(root):
+    """Check the pack and return it with the questions read in."""
+    constants = read_constants(root, "GameRules.h", "Game2.h")
+    pack_path = os.path.join(root, "content", "pack.json")
+    with open(pack_path, encoding="utf-8") as f:
+        pack = json.load(f)
+
+    check_screens("intro", pack["intro"], 3)
+    check_screens("game1.intro", pack["game1"]["intro"], 5)
+
+    melody_length = constants["MELODY_LENGTH"]
+    melody = pack["game2"]["melody"]
+    if not isinstance(melody, str) or len(melody) != melody_length or \
+            any(not "1" <= note <= str(melody_length) for note in melody):
+        raise ContentError("game2.melody: expected %d key digits 1-%d" % (melody_length, melody_length))
+    tips = pack["game2"]["tips"]
+    check_count("game2.tips", tips, melody_length)
+    for i, tip in enumerate(tips):
+        check_text("game2.tips[%d]" % i, tip)
+
+    # Game3's pot only reaches multiples of the step, so any other target
+    # could never be matched exactly.
+    step = constants["GAME3_DISCRETE_VALUE_MULTIPLIER"]
+    reach = min(constants["GAME3_POT_MAX_STEP"] * step, CHANNEL_MAX)
+    palettes = pack["game3"]["palettes"]
+    check_count("game3.palettes", palettes, constants["GAME3_LEVELS"])
+    for level, palette in enumerate(palettes):
+        if not isinstance(palette, list) or not 1 <= len(palette) <= 255:
+            raise ContentError("game3.palettes[%d]: expected 1 to 255 colours" % level)
+        for i, color in enumerate(palette):
+            check_count("game3.palettes[%d][%d]" % (level, i), color, 3)
+            for channel in color:
+                if not isinstance(channel, int) or not 0 <= channel <= reach or channel % step:
+                    raise ContentError("game3.palettes[%d][%d]: %r is not a multiple of %d in 0..%d"
+                                       % (level, i, channel, step, reach))
+
+    options = constants["GAME4_OPTION_COUNT"]
+    questions = load_questions(os.path.join(root, "content", pack["game4"]["questions"]), options)
+    if len(questions) != constants["GAME4_QUESTION_COUNT"]:
+        raise ContentError("game4: %d questions, GAME4_QUESTION_COUNT in GameRules.h is %d"
+                           % (len(questions), constants["GAME4_QUESTION_COUNT"]))
+    pack["game4"]["questions"] = questions
+    return pack
+
+
+class StringPool:
+    """Strings packed end to end, each NUL-terminated, stored once."""
+
+    def __init__(self, strings):
+        self.data = b""
+        self.offsets = {}
+        # Longest first, so a string that ends another one finds it placed.
+        for text in sorted(set(strings), key=lambda text: (-len(text.encode("utf-8")), text)):
+            encoded = text.encode("utf-8") + b"\0"
+            at = self.data.find(encoded)
+            if at < 0:
+                at = len(self.data)
+                self.data += encoded
+            self.offsets[text] = at
+        if len(self.data) > 0xFFFF:
+            raise ContentError("string pool is %d bytes, over the 16-bit offsets" % len(self.data))
+
+    def __getitem__(self, text):
+        return self.offsets[text]
+
+    def literal(self):
+        """The pool as C string literals, one string per line. The last
+        NUL is the literal's own."""
+        lines = []
+        start = 0
+        while start < len(self.data):
+            end = self.data.index(b"\0", start)
+            text = "".join(c if 0x20 <= ord(c) < 0x7F and c not in '"\\' else "\\%03o" % ord(c)
+                           for c in self.data[start:end].decode("latin-1"))
+            lines.append('    "%s%s"' % (text, "\\0" if end + 1 < len(self.data) else ""))
+            start = end + 1
+        return "\n".join(lines)
+
+
+BANNER = "// Generated by tools/content_compiler.py from content/; do not edit.\n"
+
+
+def offsets(pool, texts):
+    return "{" + ", ".join(str(pool[text]) for text in texts) + "}"
+
+
+def generate(pack):
+    """Return (header, source) text."""
+    screens = pack["intro"] + pack["game1"]["intro"]
+    questions = pack["game4"]["questions"]
+    strings = [line for screen in screens for line in screen]
+    strings += [pack["game2"]["melody"]] + pack["game2"]["tips"]
+    for question, options, _ in questions:
+        strings += [question] + options
+    pool = StringPool(strings)
+
+    palettes = pack["game3"]["palettes"]
+    starts = [0]
+    for palette in palettes:
+        starts.append(starts[-1] + len(palette))
+
+    h = [BANNER, "#ifndef CONTENT_H\n#define CONTENT_H\n\n#include <Arduino.h>\n\n"]
+    h.append("// Puzzle content from content/pack.json (see tools/content_compiler.py).\n")
+    h.append("// Strings are offsets into CONTENT_STRINGS; contentText() turns one into\n")
+    h.append("// a pointer, and is a constant expression for scene cues.\n\n")
+    h.append("const uint16_t CONTENT_STRINGS_SIZE = %d;\n" % len(pool.data))
+    h.append("extern const char CONTENT_STRINGS[CONTENT_STRINGS_SIZE];\n\n")
+    h.append("constexpr const char *contentText(uint16_t offset)\n{\n"
+             "    return CONTENT_STRINGS + offset;\n}\n\n")
+    h.append("struct ContentColor\n{\n    uint8_t r, g, b;\n};\n\n")
+    h.append("struct ContentQuestion\n{\n    uint16_t question;\n    uint16_t options[%d];\n"
+             "    uint8_t answer; // 0 = A\n};\n\n" % len(questions[0][1]))
+
+    h.append("// Intro screens, two lines each\n")
+    h.append("constexpr uint16_t CONTENT_INTRO[][2] = {\n%s};\n" % ",\n".join(
+        "    " + offsets(pool, screen) for screen in pack["intro"]))
+    h.append("constexpr uint16_t CONTENT_GAME1_INTRO[][2] = {\n%s};\n\n" % ",\n".join(
+        "    " + offsets(pool, screen) for screen in pack["game1"]["intro"]))
+
+    h.append("// Game2: the melody as key digits, and a tip per note\n")
+    h.append("constexpr uint16_t CONTENT_GAME2_MELODY = %d;\n" % pool[pack["game2"]["melody"]])
+    h.append("constexpr uint16_t CONTENT_GAME2_TIPS[] = %s;\n\n" % offsets(pool, pack["game2"]["tips"]))
+
+    h.append("// Game3: target colours, level n is entries [START[n - 1], START[n])\n")
+    h.append("constexpr uint8_t CONTENT_PALETTE_LEVELS = %d;\n" % len(palettes))
+    h.append("constexpr uint8_t CONTENT_PALETTE_START[] = {%s};\n" % ", ".join(str(s) for s in starts))
+    h.append("constexpr ContentColor CONTENT_PALETTE[] = {\n%s};\n\n" % ",\n".join(
+        "    {%d, %d, %d}" % tuple(color) for palette in palettes for color in palette))
+
+    h.append("// Game4: questions and their five options\n")
+    h.append("constexpr uint8_t CONTENT_QUESTION_COUNT = %d;\n" % len(questions))
+    h.append("constexpr ContentQuestion CONTENT_QUESTIONS[] = {\n%s};\n\n" % ",\n".join(
+        "    {%d, %s, %d}" % (pool[question], offsets(pool, options), answer)
+        for question, options, answer in questions))
+    h.append("#endif\n")
+
+    source = BANNER + '#include "Content.h"\n\n'
+    source += "const char CONTENT_STRINGS[CONTENT_STRINGS_SIZE] =\n%s;\n" % pool.literal()
+    return "".join(h), source
+
+
+def outputs(root):
+    return (os.path.join(root, "include", "Content.h"), os.path.join(root, "src", "utils", "Content.cpp"))
+
+
+def compile_content(root, check_only=False):
+    """Check the pack and bring the outputs up to date. Returns the stale
+    outputs (written, unless check_only)."""
+    stale = []
+    for path, text in zip(outputs(root), generate(load_pack(root))):
+        current = None
+        if os.path.exists(path):
+            with open(path, encoding="utf-8") as f:
+                current = f.read()
+        if current == text:
+            continue
+        stale.append(os.path.relpath(path, root))
+        if not check_only:
+            with open(path, "w", encoding="utf-8") as f:
+                f.write(text)
+    return stale
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--check", action="store_true", help="only report outputs that are out of date")
+    args = parser.parse_args()
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    try:
+        stale = compile_content(root, args.check)
+    except (ContentError, KeyError, ValueError, OSError) as error:
+        sys.exit("content: %s" % error)
+    for path in stale:
+        print("%s %s" % ("stale" if args.check else "wrote", path))
+    if args.check and stale:
+        sys.exit(1)
+
+
+try:
+    Import("env")  # noqa: F821 -- defined when PlatformIO runs this as a pre: script
+except NameError:
+    env = None
+
+if env is not None:
+    try:
+        for written in compile_content(env.subst("$PROJECT_DIR")):
+            print("content: wrote %s" % written)
+    except (ContentError, KeyError, ValueError, OSError) as error:
+        sys.stderr.write("content: %s\n" % error)
+        env.Exit(1)
+elif __name__ == "__main__":
+    main()
@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""Build and inspect input trace files from an INPUT_TRACE build.
+
+The firmware streams every input sample it acts on as TM_INPUT_TRACE
+telemetry chunks (see include/InputTrace.h). `capture` joins the chunks
+of a telemetry capture into a trace file with a block index (layout in
+lib/HostArduino/src/InputTraceFile.h); `info` and `dump` map the file and
+seek through the index, so long captures open without reading them
+whole. Replay a trace on the host with the native build:
+
+    python3 tools/input_trace.py capture /dev/ttyACM0 session.itr   # Ctrl-C to stop
+    python3 tools/input_trace.py capture capture.bin session.itr
+    python3 tools/input_trace.py info session.itr
+    python3 tools/input_trace.py dump session.itr --at 312.5 --frames 20
+    .pio/build/native/program --replay session.itr
+"""
+
+import argparse
+import mmap
+import struct
+import sys
+
+from telemetry_decode import cobs_decode, frames, load_events, open_source, parse_record
+
+MAGIC = b"ITR1"
+VERSION = 1
+HEADER = struct.Struct("<4sHHIIQQQQIIII")
+BLOCK = struct.Struct("<QII4h")
+CHANNELS = 4
+TRUNCATED = 1
+DEFAULT_BLOCK_SIZE = 4096
+
+FRAME, ANALOG, KEYS, EDGE, SEED, STATE = range(6)
+FRAME_DELTA_ESCAPE = 31
+STATE_NAMES = ["intro", "game", "loading", "time up", "game won"]
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+class Decoder:
+    """Walks the record stream from a block's saved state."""
+
+    def __init__(self, data, offset=0, frame=0, time_ms=0, analog=(0,) * CHANNELS):
+        self.data = data
+        self.pos = offset
+        self.frame = frame
+        self.time_ms = time_ms
+        self.analog = list(analog)
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            if self.pos >= len(self.data):
+                raise ValueError("truncated record")
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError("truncated record")
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def records(self):
+        """Yield (offset, kind, value) until the data ends."""
+        while self.pos < len(self.data):
+            start = self.pos
+            tag = self.byte()
+            kind, payload = tag & 0x07, tag >> 3
+            if kind == FRAME:
+                delta = self.varint() if payload == FRAME_DELTA_ESCAPE else payload
+                self.time_ms += delta
+                self.frame += 1
+                value = self.time_ms
+            elif kind == ANALOG:
+                if payload >= CHANNELS:
+                    raise ValueError("bad analog channel %d at %d" % (payload, start))
+                self.analog[payload] += unzigzag(self.varint())
+                value = (payload, self.analog[payload])
+            elif kind == KEYS:
+                value = self.byte()
+            elif kind == EDGE:
+                value = (payload, self.time_ms + unzigzag(self.varint()))
+            elif kind == SEED:
+                value = int.from_bytes(bytes(self.byte() for _ in range(8)), "little")
+            elif kind == STATE:
+                value = (payload, self.byte(), self.byte())
+            else:
+                raise ValueError("bad record kind %d at %d" % (kind, start))
+            yield start, kind, value
+
+
+def collect_stream(source):
+    """Join the capture's TM_INPUT_TRACE chunks; returns (bytes, truncated)."""
+    event_id = [name for name, _ in load_events()].index("TM_INPUT_TRACE")
+    stream = bytearray()
+    expected = None
+    truncated = False
+    try:
+        for frame in frames(open_source(source)):
+            try:
+                event, _, fields = parse_record(cobs_decode(frame), raw=True)
+            except ValueError:
+                continue
+            if event != event_id or len(fields) < 2:
+                continue
+            sequence, chunk = fields[0] & 0xFFFF, fields[1]
+            if expected is not None and sequence != expected:
+                print("chunk %d lost, trace stops there" % expected, file=sys.stderr)
+                truncated = True
+                break
+            expected = (sequence + 1) & 0xFFFF
+            stream += chunk
+    except KeyboardInterrupt:
+        pass
+    return bytes(stream), truncated
+
+
+def build_index(stream, block_size):
+    """Return (blocks, frames, duration ms, seed, usable length)."""
+    decoder = Decoder(stream)
+    blocks = [(0, 0, 0, (0,) * CHANNELS)]
+    seed = 0
+    end = 0
+    previous_time, previous_analog = 0, (0,) * CHANNELS
+    try:
+        for offset, kind, value in decoder.records():
+            if kind == FRAME and offset - blocks[-1][0] >= block_size:
+                # State before this frame record is decoded.
+                blocks.append((offset, decoder.frame - 1, previous_time, previous_analog))
+            if kind == SEED and not seed:
+                seed = value
+            previous_time = decoder.time_ms
+            previous_analog = tuple(decoder.analog)
+            end = decoder.pos
+    except ValueError as error:
+        print("stream ends in a broken record (%s), kept %d of %d bytes" % (error, end, len(stream)), file=sys.stderr)
+    return blocks, decoder.frame, decoder.time_ms, seed, end
+
+
+def capture(args):
+    stream, truncated = collect_stream(args.source)
+    blocks, frame_count, duration, seed, end = build_index(stream, args.block_size)
+    if end < len(stream):
+        stream = stream[:end]
+        truncated = True
+    data_offset = HEADER.size
+    index_offset = (data_offset + len(stream) + 7) // 8 * 8
+    header = HEADER.pack(MAGIC, VERSION, BLOCK.size, args.block_size, len(blocks), data_offset, len(stream),
+                         index_offset, seed, frame_count, duration, TRUNCATED if truncated else 0, 0)
+    with open(args.output, "wb") as f:
+        f.write(header)
+        f.write(stream)
+        f.write(b"\0" * (index_offset - data_offset - len(stream)))
+        for offset, frame, time_ms, analog in blocks:
+            f.write(BLOCK.pack(offset, frame, time_ms, *analog))
+    print("%s: %d frames, %.1f s, %d bytes in %d blocks%s" % (args.output, frame_count, duration / 1000.0,
+                                                            len(stream), len(blocks),
+                                                            ", truncated" if truncated else ""))
+
+
+class TraceFile:
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        fields = HEADER.unpack_from(self.map, 0)
+        (magic, version, entry_size, self.block_size, self.block_count, self.data_offset, self.data_length,
+         self.index_offset, self.seed, self.frame_count, self.duration, self.flags, _) = fields
+        if magic != MAGIC or version != VERSION or entry_size != BLOCK.size:
+            raise SystemExit("%s: not a version %d input trace" % (path, VERSION))
+        self.data = memoryview(self.map)[self.data_offset:self.data_offset + self.data_length]
+
+    def block(self, index):
+        offset, frame, time_ms, *analog = BLOCK.unpack_from(self.map, self.index_offset + index * BLOCK.size)
+        return offset, frame, time_ms, analog
+
+    def block_at(self, time_ms):
+        low, high = 0, self.block_count
+        while low < high:
+            mid = (low + high) // 2
+            if self.block(mid)[2] <= time_ms:
+                low = mid + 1
+            else:
+                high = mid
+        return max(low - 1, 0)
+
+
+def info(args):
+    trace = TraceFile(args.trace)
+    print("seed        0x%016X" % trace.seed)
+    print("frames      %d" % trace.frame_count)
+    print("duration    %.3f s" % (trace.duration / 1000.0))
+    print("data        %d bytes, %.2f bytes/frame" % (trace.data_length, trace.data_length / max(trace.frame_count, 1)))
+    print("blocks      %d of ~%d bytes" % (trace.block_count, trace.block_size))
+    if trace.flags & TRUNCATED:
+        print("truncated   chunks were lost during capture")
+
+
+def describe(kind, value):
+    if kind == FRAME:
+        return "frame at %.3f s" % (value / 1000.0)
+    if kind == ANALOG:
+        return "analog %d = %d" % value
+    if kind == KEYS:
+        return "keys 0x%02X" % value
+    if kind == EDGE:
+        return "button %s at %.3f s" % ("up" if value[0] else "down", value[1] / 1000.0)
+    if kind == SEED:
+        return "seed 0x%016X" % value
+    state = STATE_NAMES[value[0]] if value[0] < len(STATE_NAMES) else value[0]
+    return "state %s, game %d state %d" % (state, value[1] + 1, value[2])
+
+
+def dump(args):
+    trace = TraceFile(args.trace)
+    at_ms = int(args.at * 1000)
+    offset, frame, time_ms, analog = trace.block(trace.block_at(at_ms))
+    decoder = Decoder(trace.data, offset, frame, time_ms, analog)
+    shown = 0
+    for _, kind, value in decoder.records():
+        if kind == FRAME:
+            if decoder.time_ms < at_ms:
+                continue
+            shown += 1
+            if shown > args.frames:
+                break
+        if decoder.time_ms < at_ms:
+            continue
+        prefix = "%8d  " % decoder.frame if kind == FRAME else "          "
+        print(prefix + describe(kind, value))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    p = commands.add_parser("capture", help="build a trace file from a telemetry capture")
+    p.add_argument("source", help="serial port, capture file, or - for stdin")
+    p.add_argument("output", help="trace file to write")
+    p.add_argument("--block-size", type=int, default=DEFAULT_BLOCK_SIZE, help="data bytes per index block")
+    p.set_defaults(run=capture)
+    p = commands.add_parser("info", help="summarise a trace file")
+    p.add_argument("trace")
+    p.set_defaults(run=info)
+    p = commands.add_parser("dump", help="print records from a point in a trace file")
+    p.add_argument("trace")
+    p.add_argument("--at", type=float, default=0.0, help="start time in seconds")
+    p.add_argument("--frames", type=int, default=10, help="frames to print")
+    p.set_defaults(run=dump)
+    args = parser.parse_args()
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main()
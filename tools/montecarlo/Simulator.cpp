@@ -0,0 +1,440 @@
+#include "Simulator.h"
+#include "GameRules.h"
+#include "Timeline.h"
+#include <math.h>
+#include <stdlib.h>
+
+namespace
+{
+struct Field
+{
+    const char *name;
+    double Params::*member;
+};
+
+const Field FIELDS[] = {
+    {"total_time_ms", &Params::totalTimeMs},
+    {"time_up_warning_ms", &Params::timeUpWarningMs},
+    {"intro_ms", &Params::introMs},
+    {"loading_ms", &Params::loadingMs},
+    {"threshold_level1", &Params::threshold1},
+    {"level2_threshold_offset", &Params::level2Offset},
+    {"level3_threshold_offset", &Params::level3Offset},
+    {"confirmation_ms", &Params::confirmMs},
+    {"game1_intro_ms", &Params::game1IntroMs},
+    {"game1_complete_ms", &Params::game1CompleteMs},
+    {"game2_init_ms", &Params::game2InitMs},
+    {"game2_wrong_ms", &Params::game2WrongMs},
+    {"game2_complete_ms", &Params::game2CompleteMs},
+    {"penalty_ms", &Params::penaltyMs},
+    {"game3_init_ms", &Params::game3InitMs},
+    {"game3_show_ms", &Params::game3ShowMs},
+    {"game3_debounce_ms", &Params::game3DebounceMs},
+    {"game3_success_ms", &Params::game3SuccessMs},
+    {"game3_level_up_ms", &Params::game3LevelUpMs},
+    {"game3_final_ms", &Params::game3FinalMs},
+    {"game3_fail_ms", &Params::game3FailMs},
+    {"color_tolerance", &Params::colorTolerance},
+    {"game4_init_ms", &Params::game4InitMs},
+    {"typewriter_ms", &Params::typewriterMs},
+    {"option_interval_ms", &Params::optionIntervalMs},
+    {"game4_correct_ms", &Params::game4CorrectMs},
+    {"game4_wrong_ms", &Params::game4WrongMs},
+    {"game4_complete_ms", &Params::game4CompleteMs},
+    {"frame_ms", &Params::frameMs},
+    {"game1_frame_ms", &Params::game1FrameMs},
+    {"reaction_ms", &Params::reactionMs},
+    {"reaction_spread", &Params::reactionSpread},
+    {"sweep_rate", &Params::sweepRate},
+    {"pot_sigma", &Params::potSigma},
+    {"adjust_ms", &Params::adjustMs},
+    {"tip_read_ms", &Params::tipReadMs},
+    {"guess_error", &Params::guessError},
+    {"learning", &Params::learning},
+    {"color_sigma", &Params::colorSigma},
+    {"knowledge", &Params::knowledge},
+};
+
+// Average question length on the LCD, for the typewriter effect.
+const double QUESTION_CHARS = 15;
+const int MELODY_NOTES = 8;
+
+uint64_t splitMix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint32_t rotl(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+}
+
+Params::Params()
+    : totalTimeMs(SESSION_TIME_MS), timeUpWarningMs(TIME_UP_WARNING_MS), introMs(3 * INTRO_MESSAGE_INTERVAL_MS),
+      loadingMs(LOADING_SCREEN_DURATION_MS), threshold1(THRESHOLD_LEVEL1), level2Offset(LEVEL2_THRESHOLD_OFFSET),
+      level3Offset(LEVEL3_THRESHOLD_OFFSET), confirmMs(CONFIRMATION_DELAY_MS), game1IntroMs(GAME1_INTRO_DURATION),
+      game1CompleteMs(SUCCESS_MELODY_MS + GAME1_COMPLETE_DISPLAY_TIME), game2InitMs(GAME2_INIT_DURATION),
+      game2WrongMs(GAME2_WRONG_DURATION), game2CompleteMs(SUCCESS_MELODY_MS + GAME2_COMPLETE_DURATION),
+      penaltyMs(PENALTY_TIME_INCREMENT), game3InitMs(GAME3_INIT_PHASE3_DURATION),
+      game3ShowMs(GAME3_SHOW_COLOR_PHASE2_DURATION), game3DebounceMs(GAME3_DEBOUNCE_DELAY),
+      game3SuccessMs(GAME3_SUCCESS_DISPLAY_DURATION), game3LevelUpMs(SUCCESS_MELODY_MS + GAME3_LEVEL_UP_DURATION),
+      game3FinalMs(SUCCESS_MELODY_MS + GAME3_SUCCESS_DISPLAY_DURATION), game3FailMs(GAME3_FAIL_DURATION),
+      colorTolerance(GAME3_COLOR_TOLERANCE), game4InitMs(GAME4_INIT_DURATION), typewriterMs(TYPEWRITER_DELAY),
+      optionIntervalMs(GAME4_OPTION_UPDATE_INTERVAL), game4CorrectMs(SUCCESS_MELODY_MS),
+      game4WrongMs(WRONG_FEEDBACK_DURATION), game4CompleteMs(SUCCESS_MELODY_MS + GAME4_FEEDBACK_DURATION),
+      // loop() sleeps 10 ms a frame; Game1 adds a 50 ms blocking tone
+      frameMs(12), game1FrameMs(62),
+      reactionMs(450), reactionSpread(0.35), sweepRate(900), potSigma(25), adjustMs(700), tipReadMs(2500),
+      guessError(0.08), learning(0.5), colorSigma(12), knowledge(0.6)
+{
+}
+
+bool Params::set(const std::string &name, double value)
+{
+    for (const Field &field : FIELDS)
+    {
+        if (name == field.name)
+        {
+            this->*field.member = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+double Params::get(const std::string &name) const
+{
+    for (const Field &field : FIELDS)
+    {
+        if (name == field.name)
+            return this->*field.member;
+    }
+    return 0;
+}
+
+std::vector<std::string> Params::names()
+{
+    std::vector<std::string> result;
+    for (const Field &field : FIELDS)
+    {
+        result.push_back(field.name);
+    }
+    return result;
+}
+
+Results::Results(double totalTimeMs)
+{
+    size_t buckets = (size_t)(totalTimeMs / BUCKET_MS) + 1;
+    completion.assign(buckets, 0);
+    for (int g = 0; g < SIM_GAMES; g++)
+    {
+        gameTime[g].assign(buckets, 0);
+    }
+}
+
+void Results::merge(const Results &other)
+{
+    sessions += other.sessions;
+    won += other.won;
+    for (int g = 0; g < SIM_GAMES; g++)
+    {
+        timeUpIn[g] += other.timeUpIn[g];
+        gamesPlayed[g] += other.gamesPlayed[g];
+        failures[g] += other.failures[g];
+        for (size_t b = 0; b < gameTime[g].size() && b < other.gameTime[g].size(); b++)
+            gameTime[g][b] += other.gameTime[g][b];
+    }
+    for (size_t b = 0; b < completion.size() && b < other.completion.size(); b++)
+        completion[b] += other.completion[b];
+}
+
+double Results::percentile(const std::vector<uint64_t> &histogram, double fraction)
+{
+    uint64_t total = 0;
+    for (uint64_t count : histogram)
+        total += count;
+    if (total == 0)
+        return NAN;
+    uint64_t target = (uint64_t)ceil(fraction * total);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < histogram.size(); b++)
+    {
+        seen += histogram[b];
+        if (seen >= target && seen > 0)
+            return (b + 1) * (BUCKET_MS / 1000.0);
+    }
+    return histogram.size() * (BUCKET_MS / 1000.0);
+}
+
+double Results::mean(const std::vector<uint64_t> &histogram)
+{
+    double sum = 0;
+    uint64_t total = 0;
+    for (size_t b = 0; b < histogram.size(); b++)
+    {
+        sum += (b + 0.5) * histogram[b];
+        total += histogram[b];
+    }
+    return total ? sum / total * (BUCKET_MS / 1000.0) : NAN;
+}
+
+SessionBatch::SessionBatch(const Params &params, uint64_t seed) : p(params)
+{
+    deadline = p.totalTimeMs - p.timeUpWarningMs;
+    uint64_t state = seed;
+    for (size_t i = 0; i < LANES; i++)
+    {
+        uint64_t a = splitMix64(state);
+        uint64_t b = splitMix64(state);
+        s0[i] = (uint32_t)a;
+        s1[i] = (uint32_t)(a >> 32) | 1; // Never all zero
+        s2[i] = (uint32_t)b;
+        s3[i] = (uint32_t)(b >> 32);
+    }
+}
+
+uint32_t SessionBatch::next(size_t i)
+{
+    uint32_t result = rotl(s1[i] * 5, 7) * 9;
+    uint32_t t = s1[i] << 9;
+    s2[i] ^= s0[i];
+    s3[i] ^= s1[i];
+    s1[i] ^= s2[i];
+    s0[i] ^= s3[i];
+    s2[i] ^= t;
+    s3[i] = rotl(s3[i], 11);
+    return result;
+}
+
+double SessionBatch::uniform(size_t i)
+{
+    return (next(i) + 0.5) * (1.0 / 4294967296.0);
+}
+
+double SessionBatch::normal(size_t i)
+{
+    return sqrt(-2.0 * log(uniform(i))) * cos(6.283185307179586 * uniform(i));
+}
+
+double SessionBatch::reaction(size_t i)
+{
+    return p.reactionMs * exp(p.reactionSpread * normal(i));
+}
+
+bool SessionBatch::spend(size_t i, double ms)
+{
+    clock[i] += ms;
+    if (clock[i] >= deadline)
+    {
+        running[i] = 0;
+    }
+    return running[i];
+}
+
+void SessionBatch::intro(size_t i)
+{
+    spend(i, p.introMs);
+}
+
+void SessionBatch::loading(size_t i)
+{
+    spend(i, p.loadingMs);
+}
+
+// Vault dial: sweep towards the beeps, aim, press; a press outside the
+// level's threshold is ignored and the player fine-tunes and tries again.
+void SessionBatch::game1(size_t i)
+{
+    if (!spend(i, p.game1IntroMs))
+        return;
+    double dial = 0;
+    double dialSigma = p.potSigma * GAME1_DIAL_RANGE / 1023.0;
+    for (int level = 1; level <= GAME1_LEVELS; level++)
+    {
+        double target = (GAME1_COMBO_MIN + (int)(uniform(i) * (GAME1_COMBO_MAX - GAME1_COMBO_MIN))) * GAME1_COMBO_STEP;
+        if (!spend(i, reaction(i) + fabs(target - dial) / p.sweepRate * 1000))
+            return;
+        dial = target;
+        double threshold = level == 1 ? p.threshold1 : level == 2 ? p.threshold1 - p.level2Offset : p.threshold1 - p.level3Offset;
+        while (fabs(dialSigma * normal(i)) >= threshold)
+        {
+            failed[i]++;
+            if (!spend(i, p.adjustMs + reaction(i)))
+                return;
+        }
+        if (!spend(i, p.confirmMs + 2 * p.game1FrameMs))
+            return;
+    }
+    spend(i, p.game1CompleteMs);
+}
+
+// Melody: read each tip and play its note; a wrong tune costs the penalty
+// and a full retry, with fewer mistakes each time.
+void SessionBatch::game2(size_t i)
+{
+    if (!spend(i, p.game2InitMs))
+        return;
+    double error = p.guessError;
+    for (;;)
+    {
+        bool correct = true;
+        for (int note = 0; note < MELODY_NOTES; note++)
+        {
+            if (!spend(i, p.tipReadMs * (error < p.guessError ? 0.5 : 1.0) + reaction(i)))
+                return;
+            if (uniform(i) < error)
+                correct = false;
+        }
+        if (!spend(i, reaction(i) + p.frameMs))
+            return;
+        if (correct)
+            break;
+        failed[i]++;
+        clock[i] += p.penaltyMs;
+        if (!spend(i, p.game2WrongMs))
+            return;
+        error *= p.learning;
+    }
+    spend(i, p.game2CompleteMs);
+}
+
+// Colour match: remember the shown colour, dial each channel, submit. A
+// channel passes within the tolerance of the nearest pot step; any miss
+// resets the game to level 1.
+void SessionBatch::game3(size_t i)
+{
+    if (!spend(i, p.game3InitMs))
+        return;
+    int level = 1;
+    while (level <= GAME3_LEVELS)
+    {
+        // Press when memorised, or the colour hides by itself.
+        double look = reaction(i) + 1000;
+        if (!spend(i, (look < p.game3ShowMs ? look : p.game3ShowMs) + p.game3DebounceMs))
+            return;
+        bool correct = true;
+        for (int channel = 0; channel < 3; channel++)
+        {
+            // Level n has n non-zero channels; a zero channel is easy.
+            if (!spend(i, 2 * reaction(i) + p.game3DebounceMs))
+                return;
+            if (channel < level)
+            {
+                double target = GAME3_DISCRETE_VALUE_MULTIPLIER * (1 + (int)(uniform(i) * 7));
+                double remembered = target + p.colorSigma * normal(i);
+                int step = (int)lround(remembered / GAME3_DISCRETE_VALUE_MULTIPLIER);
+                step = step < 0 ? 0 : step > GAME3_POT_MAX_STEP ? GAME3_POT_MAX_STEP : step;
+                if (fabs(step * GAME3_DISCRETE_VALUE_MULTIPLIER - target) > p.colorTolerance)
+                    correct = false;
+            }
+        }
+        if (!spend(i, reaction(i) + p.game3DebounceMs))
+            return;
+        if (!correct)
+        {
+            failed[i]++;
+            if (!spend(i, p.game3FailMs))
+                return;
+            level = 1;
+            continue;
+        }
+        if (!spend(i, p.game3SuccessMs))
+            return;
+        if (level == GAME3_LEVELS)
+            break;
+        if (!spend(i, p.game3LevelUpMs))
+            return;
+        level++;
+    }
+    spend(i, p.game3FinalMs);
+}
+
+// Trivia: answer known answers straight away, otherwise guess among the
+// options not tried yet. Each try waits for the option line to refresh.
+void SessionBatch::game4(size_t i)
+{
+    if (!spend(i, p.game4InitMs))
+        return;
+    for (int question = 0; question < GAME4_QUESTION_COUNT; question++)
+    {
+        if (!spend(i, QUESTION_CHARS * p.typewriterMs))
+            return;
+        bool known = uniform(i) < p.knowledge;
+        int untried = GAME4_OPTION_COUNT;
+        for (;;)
+        {
+            if (!spend(i, reaction(i) + uniform(i) * p.optionIntervalMs + reaction(i)))
+                return;
+            if (known || uniform(i) * untried < 1)
+                break;
+            untried--;
+            failed[i]++;
+            if (!spend(i, p.game4WrongMs))
+                return;
+        }
+        if (!spend(i, p.game4CorrectMs))
+            return;
+    }
+    spend(i, p.game4CompleteMs);
+}
+
+void SessionBatch::run(size_t count, Results &results)
+{
+    typedef void (SessionBatch::*Game)(size_t);
+    static const Game GAMES[SIM_GAMES] = {&SessionBatch::game1, &SessionBatch::game2, &SessionBatch::game3,
+                                          &SessionBatch::game4};
+    if (count > LANES)
+        count = LANES;
+    for (size_t i = 0; i < count; i++)
+    {
+        clock[i] = 0;
+        running[i] = 1;
+        intro(i);
+        if (!running[i])
+            results.timeUpIn[0]++;
+    }
+    // One game at a time across every lane still in time.
+    for (int g = 0; g < SIM_GAMES; g++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!running[i])
+                continue;
+            if (g > 0)
+            {
+                loading(i);
+                if (!running[i])
+                {
+                    results.timeUpIn[g]++;
+                    continue;
+                }
+            }
+            gameStart[i] = clock[i];
+            failed[i] = 0;
+            (this->*GAMES[g])(i);
+            results.gamesPlayed[g]++;
+            results.failures[g] += failed[i];
+            if (!running[i])
+            {
+                results.timeUpIn[g]++;
+                continue;
+            }
+            size_t bucket = (size_t)((clock[i] - gameStart[i]) / Results::BUCKET_MS);
+            std::vector<uint64_t> &histogram = results.gameTime[g];
+            histogram[bucket < histogram.size() ? bucket : histogram.size() - 1]++;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        results.sessions++;
+        if (!running[i])
+            continue;
+        results.won++;
+        size_t bucket = (size_t)(clock[i] / Results::BUCKET_MS);
+        results.completion[bucket < results.completion.size() ? bucket : results.completion.size() - 1]++;
+    }
+}
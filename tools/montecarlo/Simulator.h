@@ -0,0 +1,100 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Event-level model of a session: the app flow of src/main.cpp and the
+// rules of the four games, played by a synthetic player. Rule defaults
+// come from include/GameRules.h; every field can be overridden by name.
+struct Params
+{
+    // Rules
+    double totalTimeMs, timeUpWarningMs, introMs, loadingMs;
+    double threshold1, level2Offset, level3Offset, confirmMs, game1IntroMs, game1CompleteMs;
+    double game2InitMs, game2WrongMs, game2CompleteMs, penaltyMs;
+    double game3InitMs, game3ShowMs, game3DebounceMs, game3SuccessMs, game3LevelUpMs, game3FinalMs, game3FailMs;
+    double colorTolerance;
+    double game4InitMs, typewriterMs, optionIntervalMs, game4CorrectMs, game4WrongMs, game4CompleteMs;
+    double frameMs, game1FrameMs;
+
+    // Player
+    double reactionMs;   // Median reaction time
+    double reactionSpread; // Log-normal sigma of the reaction time
+    double sweepRate;    // Game1 dial units per second while searching
+    double potSigma;     // Pot aiming error, in ADC counts (of 1023)
+    double adjustMs;     // Game1 fine adjustment after a rejected press
+    double tipReadMs;    // Game2 time to read a tip and play the note
+    double guessError;   // Game2 chance to get a note wrong
+    double learning;     // Game2 error multiplier per retry
+    double colorSigma;   // Game3 colour memory error, colour units
+    double knowledge;    // Game4 chance to know an answer
+
+    Params();
+    // Set a field by its command line name; false if there is none.
+    bool set(const std::string &name, double value);
+    double get(const std::string &name) const;
+    static std::vector<std::string> names();
+};
+
+static const int SIM_GAMES = 4;
+
+// Accumulated outcomes of one parameter set.
+struct Results
+{
+    static const int BUCKET_MS = 1000; // Histogram resolution
+
+    uint64_t sessions = 0;
+    uint64_t won = 0;
+    uint64_t timeUpIn[SIM_GAMES] = {0}; // Game running (or loading) at time-up
+    uint64_t gamesPlayed[SIM_GAMES] = {0};
+    uint64_t failures[SIM_GAMES] = {0}; // Rejected presses, wrong tunes, resets, wrong answers
+    std::vector<uint64_t> completion;   // Won sessions, by session time (incl. penalties)
+    std::vector<uint64_t> gameTime[SIM_GAMES]; // Completed games, by time in the game
+
+    explicit Results(double totalTimeMs = 0);
+    void merge(const Results &other);
+    // Value below which fraction of the histogram lies, in seconds.
+    static double percentile(const std::vector<uint64_t> &histogram, double fraction);
+    static double mean(const std::vector<uint64_t> &histogram);
+};
+
+// One batch of sessions, stored structure-of-arrays: every per-session
+// field is its own array indexed by lane, and the games run one at a time
+// across all lanes.
+class SessionBatch {
+public:
+    static const size_t LANES = 1024;
+
+    SessionBatch(const Params &params, uint64_t seed);
+    // Play `count` (<= LANES) sessions to the end and add them to results.
+    void run(size_t count, Results &results);
+
+private:
+    // Per-lane random numbers (xoshiro128**, as in include/Random.h).
+    uint32_t next(size_t lane);
+    double uniform(size_t lane);
+    double normal(size_t lane);
+    double reaction(size_t lane);
+
+    // Spend ms of session time; false once the session is out of time.
+    bool spend(size_t lane, double ms);
+    void intro(size_t lane);
+    void loading(size_t lane);
+    void game1(size_t lane);
+    void game2(size_t lane);
+    void game3(size_t lane);
+    void game4(size_t lane);
+
+    const Params &p;
+    double deadline;
+    uint32_t s0[LANES], s1[LANES], s2[LANES], s3[LANES];
+    double clock[LANES];      // Session time, penalties included
+    double gameStart[LANES];
+    uint8_t running[LANES];   // Still in time
+    uint16_t failed[LANES];   // Failures in the current game
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, one task deque each. Submitted tasks are
+// dealt round-robin; a worker takes from the back of its own deque and,
+// when that is empty, steals from the front of the others', so uneven
+// batches (long sessions, slow parameter sets) even out by themselves.
+class WorkStealingPool {
+public:
+    // A task gets the index of the worker running it, for per-worker
+    // accumulators that need no locking.
+    typedef std::function<void(unsigned worker)> Task;
+
+    explicit WorkStealingPool(unsigned threads)
+        : queues(threads ? threads : 1), pending(0), stopping(false), nextQueue(0)
+    {
+        for (unsigned i = 0; i < queues.size(); i++)
+        {
+            workers.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    unsigned size() const { return (unsigned)queues.size(); }
+
+    void submit(Task task)
+    {
+        pending++;
+        Queue &queue = queues[nextQueue++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idle.notify_one();
+    }
+
+    // Block until every submitted task has run.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(idleMutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool popOwn(unsigned self, Task &task)
+    {
+        Queue &queue = queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            return false;
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned self, Task &task)
+    {
+        for (unsigned offset = 1; offset < queues.size(); offset++)
+        {
+            Queue &victim = queues[(self + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(unsigned self)
+    {
+        Task task;
+        for (;;)
+        {
+            if (popOwn(self, task) || steal(self, task))
+            {
+                task(self);
+                task = nullptr;
+                if (--pending == 0)
+                {
+                    std::lock_guard<std::mutex> lock(idleMutex);
+                    done.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idleMutex);
+            if (stopping)
+                return;
+            // Re-check under the lock; submit() notifies after queueing.
+            idle.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> pending;
+    bool stopping;
+    std::atomic<unsigned> nextQueue;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    std::condition_variable done;
+};
+
+#endif
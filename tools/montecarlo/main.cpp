@@ -0,0 +1,229 @@
+// Monte Carlo playthroughs of an escape room session, for tuning the
+// rules in include/GameRules.h before touching the board.
+//
+//   montecarlo [--sessions N] [--threads N] [--seed N]
+//              [--set name=value]... [--sweep name=a,b,c | name=from:to:step]...
+//              [--histogram file.csv] [--list]
+//
+// Prints one CSV row per parameter set (the cartesian product of all
+// sweeps) to stdout.
+#include "Simulator.h"
+#include "WorkStealingPool.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+
+namespace
+{
+struct Sweep
+{
+    std::string name;
+    std::vector<double> values;
+};
+
+void usage()
+{
+    fprintf(stderr, "usage: montecarlo [--sessions N] [--threads N] [--seed N] [--set name=value]...\n"
+                    "                  [--sweep name=a,b,c|name=from:to:step]... [--histogram file.csv] [--list]\n");
+    exit(2);
+}
+
+bool splitAssignment(const char *arg, std::string &name, std::string &value)
+{
+    const char *eq = strchr(arg, '=');
+    if (!eq)
+        return false;
+    name.assign(arg, eq - arg);
+    value = eq + 1;
+    return true;
+}
+
+bool parseValues(const std::string &text, std::vector<double> &values)
+{
+    double from, to, step;
+    char extra;
+    if (sscanf(text.c_str(), "%lf:%lf:%lf%c", &from, &to, &step, &extra) == 3)
+    {
+        if (step <= 0 || to < from)
+            return false;
+        for (double v = from; v <= to + step * 1e-9; v += step)
+            values.push_back(v);
+        return true;
+    }
+    size_t start = 0;
+    while (start <= text.size())
+    {
+        size_t comma = text.find(',', start);
+        std::string item = text.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        char *end;
+        double v = strtod(item.c_str(), &end);
+        if (item.empty() || *end)
+            return false;
+        values.push_back(v);
+        if (comma == std::string::npos)
+            break;
+        start = comma + 1;
+    }
+    return !values.empty();
+}
+
+void checkName(const std::string &name)
+{
+    Params probe;
+    if (!probe.set(name, probe.get(name)))
+    {
+        fprintf(stderr, "unknown parameter '%s' (see --list)\n", name.c_str());
+        exit(2);
+    }
+}
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t sessions = 100000;
+    unsigned threads = std::thread::hardware_concurrency();
+    uint64_t seed = 1;
+    const char *histogramPath = nullptr;
+    Params base;
+    std::vector<Sweep> sweeps;
+
+    for (int a = 1; a < argc; a++)
+    {
+        std::string arg = argv[a];
+        bool hasValue = a + 1 < argc;
+        if (arg == "--sessions" && hasValue)
+            sessions = strtoull(argv[++a], nullptr, 10);
+        else if (arg == "--threads" && hasValue)
+            threads = (unsigned)atoi(argv[++a]);
+        else if (arg == "--seed" && hasValue)
+            seed = strtoull(argv[++a], nullptr, 10);
+        else if (arg == "--histogram" && hasValue)
+            histogramPath = argv[++a];
+        else if (arg == "--set" && hasValue)
+        {
+            std::string name, value;
+            char *end;
+            if (!splitAssignment(argv[++a], name, value))
+                usage();
+            checkName(name);
+            double v = strtod(value.c_str(), &end);
+            if (value.empty() || *end)
+                usage();
+            base.set(name, v);
+        }
+        else if (arg == "--sweep" && hasValue)
+        {
+            Sweep sweep;
+            std::string value;
+            if (!splitAssignment(argv[++a], sweep.name, value) || !parseValues(value, sweep.values))
+                usage();
+            checkName(sweep.name);
+            sweeps.push_back(sweep);
+        }
+        else if (arg == "--list")
+        {
+            for (const std::string &name : Params::names())
+                printf("%s=%g\n", name.c_str(), base.get(name));
+            return 0;
+        }
+        else
+            usage();
+    }
+    if (sessions == 0)
+        usage();
+
+    // Cartesian product of the sweeps, first sweep varying slowest.
+    std::vector<Params> sets(1, base);
+    for (const Sweep &sweep : sweeps)
+    {
+        std::vector<Params> expanded;
+        for (const Params &params : sets)
+        {
+            for (double v : sweep.values)
+            {
+                expanded.push_back(params);
+                expanded.back().set(sweep.name, v);
+            }
+        }
+        sets.swap(expanded);
+    }
+
+    // One task per batch of LANES sessions; each worker accumulates into
+    // its own Results per set, merged once everything has run.
+    WorkStealingPool pool(threads);
+    std::vector<std::vector<Results>> partial(sets.size());
+    for (size_t s = 0; s < sets.size(); s++)
+        partial[s].assign(pool.size(), Results(sets[s].totalTimeMs));
+    uint64_t batches = (sessions + SessionBatch::LANES - 1) / SessionBatch::LANES;
+    for (size_t s = 0; s < sets.size(); s++)
+    {
+        for (uint64_t b = 0; b < batches; b++)
+        {
+            size_t count = (size_t)std::min<uint64_t>(SessionBatch::LANES, sessions - b * SessionBatch::LANES);
+            // Same seeds for every set: sweeps compare like with like.
+            uint64_t batchSeed = seed * 0x100000001B3ULL + b;
+            pool.submit([&, s, count, batchSeed](unsigned worker) {
+                std::unique_ptr<SessionBatch> batch(new SessionBatch(sets[s], batchSeed));
+                batch->run(count, partial[s][worker]);
+            });
+        }
+    }
+    pool.wait();
+
+    printf("set");
+    for (const Sweep &sweep : sweeps)
+        printf(",%s", sweep.name.c_str());
+    printf(",sessions,win_rate,p50_s,p90_s,p99_s,mean_s");
+    for (int g = 1; g <= SIM_GAMES; g++)
+        printf(",time_up_in_game%d,game%d_mean_s,game%d_p90_s,game%d_failures", g, g, g, g);
+    printf("\n");
+
+    FILE *histogram = nullptr;
+    if (histogramPath)
+    {
+        histogram = fopen(histogramPath, "w");
+        if (!histogram)
+        {
+            perror(histogramPath);
+            return 1;
+        }
+        fprintf(histogram, "set,second,won\n");
+    }
+
+    for (size_t s = 0; s < sets.size(); s++)
+    {
+        Results total(sets[s].totalTimeMs);
+        for (const Results &results : partial[s])
+            total.merge(results);
+
+        printf("%zu", s);
+        for (const Sweep &sweep : sweeps)
+            printf(",%g", sets[s].get(sweep.name));
+        printf(",%llu,%.4f,%.0f,%.0f,%.0f,%.1f", (unsigned long long)total.sessions,
+               (double)total.won / total.sessions, Results::percentile(total.completion, 0.5),
+               Results::percentile(total.completion, 0.9), Results::percentile(total.completion, 0.99),
+               Results::mean(total.completion));
+        for (int g = 0; g < SIM_GAMES; g++)
+        {
+            printf(",%.4f,%.1f,%.0f,%.2f", (double)total.timeUpIn[g] / total.sessions, Results::mean(total.gameTime[g]),
+                   Results::percentile(total.gameTime[g], 0.9),
+                   total.gamesPlayed[g] ? (double)total.failures[g] / total.gamesPlayed[g] : 0.0);
+        }
+        printf("\n");
+
+        if (histogram)
+        {
+            for (size_t b = 0; b < total.completion.size(); b++)
+            {
+                if (total.completion[b])
+                    fprintf(histogram, "%zu,%zu,%llu\n", s, b * Results::BUCKET_MS / 1000,
+                            (unsigned long long)total.completion[b]);
+            }
+        }
+    }
+    if (histogram)
+        fclose(histogram);
+    return 0;
+}
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""Build, inspect and upload puzzle config blobs (see include/PuzzleConfig.h).
+
+A config is a JSON object whose keys are the names in
+include/ConfigKeys.def, lower case and without the CFG_ prefix; every key
+is optional. Numbers are integers, texts strings, lists arrays of strings:
+
+    {"session_time_ms": 1800000, "game3_tolerance": 20,
+     "game2_tips": ["Do", "Re", "Mi", "Fa", "So", "La", "Ti", "Do!"]}
+
+Keys, types and limits are read from ConfigKeys.def, so this script needs
+no update when keys are added there. Strings are measured in UTF-8 bytes,
+as the LCD code sees them.
+
+    python3 tools/puzzle_config.py build cabinet.json -o cabinet.pcfg
+    python3 tools/puzzle_config.py show cabinet.pcfg
+    python3 tools/puzzle_config.py upload cabinet.pcfg /dev/ttyACM0   # needs pyserial
+
+The board only takes an upload between games.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+import zlib
+
+from telemetry_decode import cobs_decode, frames, load_events, parse_record
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+KEYS_DEF = os.path.join(ROOT, "include", "ConfigKeys.def")
+BAUD = 921600
+
+MAGIC = 0x47464350  # "PCFG"
+VERSION = 1
+HEADER = struct.Struct("<IHHII")
+ENTRY = struct.Struct("<BBH")
+NUMBER, TEXT, LIST = 1, 2, 3
+REPLY_TIMEOUT = 5.0
+
+KEY_RE = re.compile(r"^\s*CONFIG_(NUMBER_STEP|NUMBER|TEXT|LIST)\(\s*(\w+)\s*,([^)]*)\)")
+
+
+def load_keys(path=KEYS_DEF):
+    """Return [(name, type, limits)] in id order."""
+    types = {"NUMBER": NUMBER, "NUMBER_STEP": NUMBER, "TEXT": TEXT, "LIST": LIST}
+    keys = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            match = KEY_RE.match(line)
+            if match:
+                limits = tuple(int(value) for value in match.group(3).split(","))
+                if match.group(1) == "NUMBER":
+                    limits += (1,)
+                keys.append((match.group(2), types[match.group(1)], limits))
+    return keys
+
+
+def json_name(key):
+    return key[len("CFG_"):].lower()
+
+
+def encode_strings(name, strings, max_length):
+    value = b""
+    for string in strings:
+        if not isinstance(string, str):
+            raise ValueError("%s: %r is not a string" % (name, string))
+        data = string.encode("utf-8")
+        if len(data) > max_length or b"\0" in data:
+            raise ValueError("%s: %r is over %d bytes" % (name, string, max_length))
+        value += data + b"\0"
+    return value
+
+
+def encode_value(name, kind, limits, value):
+    if kind == NUMBER:
+        low, high, step = limits
+        if not isinstance(value, int) or isinstance(value, bool) or not low <= value <= high:
+            raise ValueError("%s: %r is not a whole number in %d..%d" % (name, value, low, high))
+        if value % step != 0:
+            raise ValueError("%s: %r is not a multiple of %d" % (name, value, step))
+        return struct.pack("<i", value)
+    if kind == TEXT:
+        return encode_strings(name, [value], limits[0])
+    max_items, max_length = limits
+    if not isinstance(value, list) or not 1 <= len(value) <= max_items:
+        raise ValueError("%s: expected a list of 1 to %d strings" % (name, max_items))
+    return encode_strings(name, value, max_length)
+
+
+def build_blob(config, keys):
+    by_name = {json_name(name): (key, kind, limits) for key, (name, kind, limits) in enumerate(keys)}
+    unknown = sorted(set(config) - set(by_name))
+    if unknown:
+        raise ValueError("unknown keys: %s" % ", ".join(unknown))
+    body = b""
+    for name in sorted(config, key=lambda name: by_name[name][0]):
+        key, kind, limits = by_name[name]
+        value = encode_value(name, kind, limits, config[name])
+        body += ENTRY.pack(key, kind, len(value)) + value + b"\0" * (-len(value) % 4)
+    header = HEADER.pack(MAGIC, VERSION, len(config), HEADER.size + len(body), zlib.crc32(body))
+    return header + body
+
+
+def parse_blob(blob, keys):
+    """Return [(name, value)], raising ValueError on a malformed blob."""
+    magic, version, entries, length, crc = HEADER.unpack_from(blob)
+    if magic != MAGIC or version != VERSION or length != len(blob):
+        raise ValueError("bad header")
+    if zlib.crc32(blob[HEADER.size:]) != crc:
+        raise ValueError("bad checksum")
+    values = []
+    pos = HEADER.size
+    for _ in range(entries):
+        key, kind, size = ENTRY.unpack_from(blob, pos)
+        value = blob[pos + ENTRY.size:pos + ENTRY.size + size]
+        pos += ENTRY.size + size + (-size % 4)
+        name = keys[key][0] if key < len(keys) else "key %d" % key
+        if kind == NUMBER:
+            values.append((name, struct.unpack("<i", value)[0]))
+        else:
+            strings = [s.decode("utf-8", "replace") for s in value.split(b"\0")[:-1]]
+            values.append((name, strings[0] if kind == TEXT and strings else strings))
+    return values
+
+
+def build(args):
+    with open(args.config, encoding="utf-8") as f:
+        config = json.load(f)
+    try:
+        blob = build_blob(config, load_keys())
+    except ValueError as error:
+        sys.exit("%s: %s" % (args.config, error))
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    print("%s: %d keys, %d bytes" % (args.output, len(config), len(blob)))
+
+
+def show(args):
+    with open(args.blob, "rb") as f:
+        blob = f.read()
+    try:
+        values = parse_blob(blob, load_keys())
+    except (ValueError, struct.error) as error:
+        sys.exit("%s: %s" % (args.blob, error))
+    for name, value in values:
+        print("%-28s %s" % (name, json.dumps(value, ensure_ascii=False)))
+
+
+def wait_for(replies, events, wanted):
+    """Return (event name, fields) of the next config reply."""
+    for frame in replies:
+        try:
+            event, _, fields = parse_record(cobs_decode(frame))
+        except ValueError:
+            continue
+        if event < len(events) and events[event][0] in wanted:
+            return events[event][0], fields
+    sys.exit("no reply from the board")
+
+
+def upload(args):
+    import serial  # pyserial
+
+    with open(args.blob, "rb") as f:
+        blob = f.read()
+    parse_blob(blob, load_keys())
+    events = load_events()
+    port = serial.Serial(args.port, BAUD, timeout=REPLY_TIMEOUT)
+    replies = frames(port)
+    port.reset_input_buffer()
+    port.write(b"c" + struct.pack("<I", len(blob)))
+    name, fields = wait_for(replies, events, ("TM_CONFIG_READY", "TM_CONFIG_REJECTED"))
+    if name == "TM_CONFIG_REJECTED":
+        sys.exit("rejected: %s" % fields[0])
+    chunk_size = fields[1]
+    sent = 0
+    while sent < len(blob):
+        port.write(blob[sent:sent + chunk_size])
+        sent = min(sent + chunk_size, len(blob))
+        name, fields = wait_for(replies, events, ("TM_CONFIG_ACK", "TM_CONFIG_REJECTED"))
+        if name == "TM_CONFIG_REJECTED":
+            sys.exit("rejected: %s" % fields[0])
+    name, fields = wait_for(replies, events, ("TM_CONFIG_LOADED", "TM_CONFIG_REJECTED"))
+    if name == "TM_CONFIG_REJECTED":
+        sys.exit("rejected: %s" % fields[0])
+    print("loaded as generation %d" % fields[0])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    p = commands.add_parser("build", help="check a JSON config and write its blob")
+    p.add_argument("config")
+    p.add_argument("-o", "--output", required=True, help="blob file to write")
+    p.set_defaults(run=build)
+    p = commands.add_parser("show", help="print the keys in a blob")
+    p.add_argument("blob")
+    p.set_defaults(run=show)
+    p = commands.add_parser("upload", help="send a blob to the board")
+    p.add_argument("blob")
+    p.add_argument("port", help="serial port")
+    p.set_defaults(run=upload)
+    args = parser.parse_args()
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Decode the board's binary telemetry back into readable log lines.
+
+The firmware sends COBS-framed records (see include/Telemetry.h):
+event id, timestamp in ms, then fields. Event ids and their text come
+from include/TelemetryEvents.def, so this script needs no update when
+events are added there.
+
+    python3 tools/telemetry_decode.py /dev/ttyACM0       # live, needs pyserial
+    python3 tools/telemetry_decode.py capture.bin        # a saved capture
+    python3 tools/telemetry_decode.py - < capture.bin    # stdin
+"""
+
+import argparse
+import codecs
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+EVENTS_DEF = os.path.join(ROOT, "include", "TelemetryEvents.def")
+BAUD = 921600
+
+EVENT_RE = re.compile(r'^\s*TELEMETRY_EVENT\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+
+
+def load_events(path=EVENTS_DEF):
+    """Return [(name, format)] in id order."""
+    events = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            match = EVENT_RE.match(line)
+            if match:
+                events.append((match.group(1), codecs.decode(match.group(2), "unicode_escape")))
+    return events
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame) + 1:
+            raise ValueError("bad COBS frame")
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def parse_record(data, raw=False):
+    """Return (event id, timestamp ms, fields) for one decoded record.
+
+    String fields are text, or bytes when raw is set."""
+    event = data[0]
+    timestamp, pos = read_varint(data, 1)
+    fields = []
+    while pos < len(data):
+        key, pos = read_varint(data, pos)
+        if key & 1:
+            length = key >> 1
+            chunk = data[pos:pos + length]
+            fields.append(chunk if raw else chunk.decode("utf-8", "replace"))
+            pos += length
+        else:
+            zigzag = key >> 1
+            fields.append((zigzag >> 1) ^ -(zigzag & 1))
+    return event, timestamp, fields
+
+
+def format_record(events, event, fields):
+    if event >= len(events):
+        return "[unknown event %d: %s]" % (event, fields)
+    name, fmt = events[event]
+    try:
+        return fmt.format(*fields)
+    except (IndexError, ValueError) as error:
+        return "[%s: %s (%s)]" % (name, fields, error)
+
+
+def frames(stream):
+    """Yield raw frames split on the 0x00 delimiter."""
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(1) if hasattr(stream, "in_waiting") else stream.read(4096)
+        if not chunk:
+            return
+        for byte in chunk:
+            if byte == 0:
+                if buffer:
+                    yield bytes(buffer)
+                buffer.clear()
+            else:
+                buffer.append(byte)
+
+
+def open_source(source):
+    if source == "-":
+        return sys.stdin.buffer
+    if os.path.exists(source) and not source.startswith("/dev/"):
+        return open(source, "rb")
+    import serial  # pyserial, only needed for a live port
+
+    return serial.Serial(source, BAUD)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="serial port, capture file, or - for stdin")
+    parser.add_argument("-t", "--timestamps", action="store_true", help="prefix lines with the board time")
+    args = parser.parse_args()
+
+    events = load_events()
+    bad = 0
+    for frame in frames(open_source(args.source)):
+        try:
+            event, timestamp, fields = parse_record(cobs_decode(frame))
+        except ValueError:
+            bad += 1
+            continue
+        text = format_record(events, event, fields)
+        for line in text.split("\n"):
+            if args.timestamps:
+                print("%10.3f  %s" % (timestamp / 1000.0, line))
+            else:
+                print(line)
+        sys.stdout.flush()
+    if bad:
+        print("[%d corrupt frames skipped]" % bad, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
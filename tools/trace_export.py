@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Convert a telemetry capture from a TRACING build into a Chrome trace.
+
+TM_TRACE records become begin/end spans and instant events on one track;
+every other telemetry record is kept as an instant event carrying its
+decoded text, so log lines show up next to the spans around them. Span
+names come from include/TraceNames.def. Open the output in
+chrome://tracing or https://ui.perfetto.dev.
+
+    python3 tools/trace_export.py capture.bin -o trace.json
+    python3 tools/trace_export.py /dev/ttyACM0 -o trace.json   # Ctrl-C to stop
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+from telemetry_decode import ROOT, cobs_decode, format_record, frames, load_events, open_source, parse_record
+
+NAMES_DEF = os.path.join(ROOT, "include", "TraceNames.def")
+NAME_RE = re.compile(r'^\s*TRACE_NAME\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+STATE_NAMES = ["intro", "game", "loading", "time up", "game won"]
+
+
+def load_names(path=NAMES_DEF):
+    """Return [(id name, label)] in id order."""
+    names = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            match = NAME_RE.match(line)
+            if match:
+                names.append((match.group(1), match.group(2)))
+    return names
+
+
+class MicrosClock:
+    """Unwraps the board's 32-bit micros() into a monotonic count."""
+
+    def __init__(self):
+        self.last = None
+        self.offset = 0
+
+    def __call__(self, value):
+        value &= 0xFFFFFFFF
+        if self.last is not None and value < self.last:
+            self.offset += 1 << 32
+        self.last = value
+        return value + self.offset
+
+
+def trace_args(id_name, arg):
+    if id_name == "TRACE_ENTER_STATE":
+        return {"state": STATE_NAMES[arg] if 0 <= arg < len(STATE_NAMES) else arg}
+    if id_name == "TRACE_GAME_STATE":
+        return {"game": arg // 100, "state": arg % 100}
+    return {"arg": arg} if arg else {}
+
+
+def convert(source, events, names):
+    trace_id = next(i for i, (name, _) in enumerate(events) if name == "TM_TRACE")
+    clock = MicrosClock()
+    out = []
+    last_us = 0
+    bad = 0
+    try:
+        for frame in frames(source):
+            try:
+                event, timestamp, fields = parse_record(cobs_decode(frame))
+            except ValueError:
+                bad += 1
+                continue
+            if event == trace_id and len(fields) == 4:
+                phase, name, micros, arg = fields
+                last_us = clock(micros)
+                id_name, label = names[name] if name < len(names) else ("", "trace %d" % name)
+                record = {"name": label, "ph": chr(phase), "ts": last_us, "pid": 1, "tid": 1}
+                if record["ph"] == "i":
+                    record["s"] = "t"
+                if record["ph"] != "E":
+                    record["args"] = trace_args(id_name, arg)
+                out.append(record)
+            else:
+                # Log records carry milliseconds; keep them in order by
+                # stamping them at the latest trace time we have seen
+                ts = last_us if last_us else timestamp * 1000
+                text = format_record(events, event, fields).strip("\n")
+                name = events[event][0] if event < len(events) else "event %d" % event
+                out.append({"name": name, "ph": "i", "s": "t", "ts": ts, "pid": 1, "tid": 2,
+                            "args": {"text": text}})
+    except KeyboardInterrupt:
+        pass
+    return out, bad
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="serial port, capture file, or - for stdin")
+    parser.add_argument("-o", "--output", default="trace.json", help="Chrome trace JSON to write")
+    args = parser.parse_args()
+
+    trace_events, bad = convert(open_source(args.source), load_events(), load_names())
+    metadata = [
+        {"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "Magic Games"}},
+        {"name": "thread_name", "ph": "M", "pid": 1, "tid": 1, "args": {"name": "loop"}},
+        {"name": "thread_name", "ph": "M", "pid": 1, "tid": 2, "args": {"name": "telemetry"}},
+    ]
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump({"traceEvents": metadata + trace_events, "displayTimeUnit": "ms"}, f)
+    print("%d events written to %s" % (len(trace_events), args.output))
+    if bad:
+        print("[%d corrupt frames skipped]" % bad, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()